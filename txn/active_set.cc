@@ -0,0 +1,85 @@
+#include "txn/active_set.h"
+
+#include <thread>
+
+// Tickets start at kSlots so slot i initially holds the finished ticket i.
+ActiveTxnSet::ActiveTxnSet() : next_ticket_(kSlots)
+{
+    for (int i = 0; i < kSlots; i++)
+    {
+        slots_[i].state_.store(State(i, FINISHED));
+        for (int w = 0; w < kBloomWords; w++) slots_[i].bloom_[w].store(0);
+    }
+}
+
+void ActiveTxnSet::BloomBits(Key key, int* bit1, int* bit2)
+{
+    uint64 h = key * 0x9E3779B97F4A7C15ull;
+    *bit1    = h >> 55;
+    *bit2    = (h >> 46) & 511;
+}
+
+bool ActiveTxnSet::BloomContains(const uint64* bloom, const KeySet& keys)
+{
+    int bit1, bit2;
+    for (KeySet::const_iterator it = keys.begin(); it != keys.end(); ++it)
+    {
+        BloomBits(*it, &bit1, &bit2);
+        if ((bloom[bit1 / 64] >> (bit1 % 64) & 1) && (bloom[bit2 / 64] >> (bit2 % 64) & 1)) return true;
+    }
+    return false;
+}
+
+uint64 ActiveTxnSet::Enter(const KeySet& writeset)
+{
+    uint64 ticket = next_ticket_.fetch_add(1);
+    Slot* slot    = &slots_[ticket % kSlots];
+    while (slot->state_.load() != State(ticket - kSlots, FINISHED)) std::this_thread::yield();
+    slot->state_.store(State(ticket, CLAIMING));
+    std::atomic_thread_fence(std::memory_order_release);
+
+    uint64 bloom[kBloomWords] = {0};
+    int bit1, bit2;
+    for (KeySet::const_iterator it = writeset.begin(); it != writeset.end(); ++it)
+    {
+        BloomBits(*it, &bit1, &bit2);
+        bloom[bit1 / 64] |= 1ull << (bit1 % 64);
+        bloom[bit2 / 64] |= 1ull << (bit2 % 64);
+    }
+    for (int w = 0; w < kBloomWords; w++) slot->bloom_[w].store(bloom[w], std::memory_order_relaxed);
+
+    slot->state_.store(State(ticket, ACTIVE));
+    return ticket;
+}
+
+bool ActiveTxnSet::Conflicts(uint64 ticket, const KeySet& readset, const KeySet& writeset)
+{
+    uint64 bloom[kBloomWords];
+    for (uint64 distance = 1; distance < kSlots; distance++)
+    {
+        // The one ticket before ours that maps to this slot.
+        uint64 other = ticket - distance;
+        Slot* slot   = &slots_[other % kSlots];
+        while (true)
+        {
+            uint64 state = slot->state_.load();
+            if ((state >> 2) > other || state == State(other, FINISHED)) break;
+            if (state != State(other, ACTIVE))
+            {
+                // 'other' hasn't published its write set yet.
+                std::this_thread::yield();
+                continue;
+            }
+
+            for (int w = 0; w < kBloomWords; w++) bloom[w] = slot->bloom_[w].load(std::memory_order_relaxed);
+            // The copy is only valid if the slot wasn't reused meanwhile.
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if ((slot->state_.load() >> 2) != other) break;
+            if (BloomContains(bloom, readset) || BloomContains(bloom, writeset)) return true;
+            break;
+        }
+    }
+    return false;
+}
+
+void ActiveTxnSet::Leave(uint64 ticket) { slots_[ticket % kSlots].state_.store(State(ticket, FINISHED)); }
@@ -0,0 +1,61 @@
+// Registry of the txns in the validation phase of parallel OCC, without a
+// shared lock. Entering txns take a ticket, which fixes the order they
+// validate in, and publish a bloom filter of their write set in the ticket's
+// slot. A txn only has to check the txns with smaller tickets that are still
+// active: those that finished before it looked are covered by the storage
+// timestamps.
+
+#ifndef _ACTIVE_SET_H_
+#define _ACTIVE_SET_H_
+
+#include <atomic>
+
+#include "txn/common.h"
+#include "txn/key_set.h"
+#include "utils/global.h"
+
+class ActiveTxnSet
+{
+   public:
+    ActiveTxnSet();
+
+    // Registers a txn writing 'writeset' and returns its ticket. Blocks while
+    // the txn kSlots tickets ahead is still active.
+    uint64 Enter(const KeySet& writeset);
+
+    // Returns true if a txn with a smaller ticket, active when this is called,
+    // may write a key of 'readset' or 'writeset'. False positives are possible.
+    bool Conflicts(uint64 ticket, const KeySet& readset, const KeySet& writeset);
+
+    // Unregisters 'ticket'. A committing txn must have applied its writes.
+    void Leave(uint64 ticket);
+
+   private:
+    static const int kSlots      = 256;
+    static const int kBloomWords = 8;  // 512 bits
+
+    // Slot states: the ticket of the occupant and its phase.
+    enum Phase
+    {
+        FINISHED = 0,
+        CLAIMING = 1,  // bloom filter being written
+        ACTIVE   = 2,
+    };
+
+    static uint64 State(uint64 ticket, Phase phase) { return ticket << 2 | phase; }
+    static void BloomBits(Key key, int* bit1, int* bit2);
+    static bool BloomContains(const uint64* bloom, const KeySet& keys);
+
+    struct Slot
+    {
+        std::atomic<uint64> state_;
+        std::atomic<uint64> bloom_[kBloomWords];
+    };
+
+    std::atomic<uint64> next_ticket_;
+    Slot slots_[kSlots];
+
+    DISALLOW_CLASS_COPY_AND_ASSIGN(ActiveTxnSet);
+};
+
+#endif  // _ACTIVE_SET_H_
@@ -0,0 +1,59 @@
+#include "txn/active_set.h"
+
+#include "utils/testing.h"
+
+TEST(ActiveTxnSet_Conflicts)
+{
+    ActiveTxnSet active;
+    set<Key> empty, w1, w2, r2;
+    w1.insert(1);
+    w1.insert(2);
+    w2.insert(5);
+    r2.insert(2);
+
+    uint64 t1 = active.Enter(w1);
+    uint64 t2 = active.Enter(w2);
+    EXPECT_TRUE(t1 < t2);
+
+    // Only txns with smaller tickets are checked.
+    EXPECT_TRUE(active.Conflicts(t2, r2, w2));
+    EXPECT_TRUE(active.Conflicts(t2, empty, w1));
+    EXPECT_FALSE(active.Conflicts(t2, empty, w2));
+    EXPECT_FALSE(active.Conflicts(t1, w2, w2));
+
+    // Finished txns are left to the timestamp check.
+    active.Leave(t1);
+    EXPECT_FALSE(active.Conflicts(t2, r2, w2));
+    active.Leave(t2);
+    END;
+}
+
+TEST(ActiveTxnSet_SlotReuse)
+{
+    ActiveTxnSet active;
+    set<Key> w1, w2;
+    w1.insert(7);
+    w2.insert(8);
+
+    // Tickets wrap around the slots many times.
+    uint64 held = active.Enter(w1);
+    int conflicts = 0;
+    for (int i = 0; i < 10000; i++)
+    {
+        uint64 ticket = active.Enter(w2);
+        if (active.Conflicts(ticket, w1, w2)) conflicts++;
+        active.Leave(ticket);
+        if (i == 100)
+        {
+            active.Leave(held);
+        }
+    }
+    EXPECT_EQ(101, conflicts);
+    END;
+}
+
+int main(int argc, char** argv)
+{
+    ActiveTxnSet_Conflicts();
+    ActiveTxnSet_SlotReuse();
+}
@@ -0,0 +1,345 @@
+#include "txn/batch_graph.h"
+
+#include <algorithm>
+#include <fstream>
+#include <map>
+#include <sstream>
+
+#include "txn/command_log.h"
+
+static const uint32 kGraphMagic   = 0x53545247;  // "STRG"
+static const uint32 kGraphVersion = 1;
+static const size_t kHeaderSize   = 2 * sizeof(uint32);
+
+// Graphs are written once this much is buffered.
+static const size_t kFlushSize = 1 << 20;
+
+void BatchGraph::Encode(string* out) const
+{
+    TxnCodec::PutVarint(batch_id_, out);
+    TxnCodec::PutVarint(k_, out);
+    char alpha[sizeof(float)];
+    memcpy(alpha, &alpha_, sizeof(float));
+    out->append(alpha, sizeof(float));
+
+    TxnCodec::PutVarint(txns_.size(), out);
+    for (size_t i = 0; i < txns_.size(); i++)
+    {
+        const TxnEntry& txn = txns_[i];
+        TxnCodec::PutVarint(txn.keys_.size(), out);
+        Key prev = 0;
+        for (size_t j = 0; j < txn.keys_.size(); j++)
+        {
+            TxnCodec::PutVarint(txn.keys_[j] - prev, out);
+            prev = txn.keys_[j];
+        }
+        TxnCodec::PutVarint(txn.clusters_.size(), out);
+        for (size_t j = 0; j < txn.clusters_.size(); j++) TxnCodec::PutVarint(txn.clusters_[j], out);
+        TxnCodec::PutVarint(txn.queue_ + 1, out);
+    }
+
+    TxnCodec::PutVarint(specials_.size(), out);
+    for (size_t i = 0; i < specials_.size(); i++)
+    {
+        TxnCodec::PutVarint(specials_[i].key_, out);
+        TxnCodec::PutVarint(specials_[i].count_, out);
+    }
+
+    TxnCodec::PutVarint(merges_.size(), out);
+    for (size_t i = 0; i < merges_.size(); i++)
+    {
+        TxnCodec::PutVarint(merges_[i].a_, out);
+        TxnCodec::PutVarint(merges_[i].b_, out);
+        TxnCodec::PutVarint(merges_[i].cross_, out);
+    }
+}
+
+bool BatchGraph::Decode(const char** pos, const char* end)
+{
+    const char* p = *pos;
+    uint64 v, n, m;
+    if (!TxnCodec::GetVarint(&p, end, &batch_id_)) return false;
+    if (!TxnCodec::GetVarint(&p, end, &v)) return false;
+    k_ = static_cast<uint32>(v);
+    if (end - p < static_cast<ptrdiff_t>(sizeof(float))) return false;
+    memcpy(&alpha_, p, sizeof(float));
+    p += sizeof(float);
+
+    if (!TxnCodec::GetVarint(&p, end, &n)) return false;
+    txns_.resize(n);
+    for (size_t i = 0; i < txns_.size(); i++)
+    {
+        TxnEntry& txn = txns_[i];
+        if (!TxnCodec::GetVarint(&p, end, &m)) return false;
+        txn.keys_.resize(m);
+        Key prev = 0;
+        for (size_t j = 0; j < txn.keys_.size(); j++)
+        {
+            if (!TxnCodec::GetVarint(&p, end, &v)) return false;
+            prev += v;
+            txn.keys_[j] = prev;
+        }
+        if (!TxnCodec::GetVarint(&p, end, &m)) return false;
+        txn.clusters_.resize(m);
+        for (size_t j = 0; j < txn.clusters_.size(); j++)
+        {
+            if (!TxnCodec::GetVarint(&p, end, &v)) return false;
+            txn.clusters_[j] = static_cast<uint32>(v);
+        }
+        if (!TxnCodec::GetVarint(&p, end, &v)) return false;
+        txn.queue_ = static_cast<int>(v) - 1;
+    }
+
+    if (!TxnCodec::GetVarint(&p, end, &n)) return false;
+    specials_.resize(n);
+    for (size_t i = 0; i < specials_.size(); i++)
+    {
+        if (!TxnCodec::GetVarint(&p, end, &v)) return false;
+        specials_[i].key_ = v;
+        if (!TxnCodec::GetVarint(&p, end, &specials_[i].count_)) return false;
+    }
+
+    if (!TxnCodec::GetVarint(&p, end, &n)) return false;
+    merges_.resize(n);
+    for (size_t i = 0; i < merges_.size(); i++)
+    {
+        if (!TxnCodec::GetVarint(&p, end, &v)) return false;
+        merges_[i].a_ = static_cast<uint32>(v);
+        if (!TxnCodec::GetVarint(&p, end, &v)) return false;
+        merges_[i].b_ = static_cast<uint32>(v);
+        if (!TxnCodec::GetVarint(&p, end, &merges_[i].cross_)) return false;
+    }
+    *pos = p;
+    return true;
+}
+
+BatchGraphWriter::BatchGraphWriter(const string& path) : graphs_(0)
+{
+    file_ = fopen(path.c_str(), "wb");
+    if (file_ == nullptr) DIE("Can't open graph file " << path);
+    uint32 header[2] = {kGraphMagic, kGraphVersion};
+    if (fwrite(header, kHeaderSize, 1, file_) != 1) DIE("Graph write failed.");
+}
+
+BatchGraphWriter::~BatchGraphWriter()
+{
+    if (!buffer_.empty() && fwrite(buffer_.data(), buffer_.size(), 1, file_) != 1) DIE("Graph write failed.");
+    fclose(file_);
+}
+
+void BatchGraphWriter::Write(const BatchGraph& graph)
+{
+    graph.Encode(&buffer_);
+    graphs_++;
+    if (buffer_.size() < kFlushSize) return;
+    if (fwrite(buffer_.data(), buffer_.size(), 1, file_) != 1) DIE("Graph write failed.");
+    buffer_.clear();
+}
+
+BatchGraphReader::BatchGraphReader(const string& path)
+{
+    std::ifstream in(path.c_str(), std::ios::binary);
+    if (!in) DIE("Can't open graph file " << path);
+    std::stringstream contents;
+    contents << in.rdbuf();
+    data_ = contents.str();
+
+    uint32 header[2];
+    if (data_.size() < kHeaderSize) DIE("Not a graph file: " << path);
+    memcpy(header, data_.data(), kHeaderSize);
+    if (header[0] != kGraphMagic || header[1] != kGraphVersion) DIE("Not a graph file: " << path);
+    pos_ = data_.data() + kHeaderSize;
+}
+
+bool BatchGraphReader::Next(BatchGraph* graph) { return graph->Decode(&pos_, data_.data() + data_.size()); }
+
+const char* ResidualCauseToString(ResidualCause cause)
+{
+    switch (cause)
+    {
+        case RESIDUAL_ALPHA: return "alpha";
+        case RESIDUAL_STRAY: return "stray";
+        case RESIDUAL_OTHER: return "other";
+        default:             return "unknown";
+    }
+}
+
+void BatchGraphReport::Merge(const BatchGraphReport& other)
+{
+    batches_ += other.batches_;
+    txns_ += other.txns_;
+    for (int i = 0; i < NUM_RESIDUAL_CAUSES; i++) residuals_[i] += other.residuals_[i];
+    clusters_.Merge(other.clusters_);
+    cluster_txns_.Merge(other.cluster_txns_);
+    components_.Merge(other.components_);
+    component_txns_.Merge(other.component_txns_);
+    critical_path_ += other.critical_path_;
+    component_critical_path_ += other.component_critical_path_;
+}
+
+uint64 BatchGraphReport::Residuals() const
+{
+    uint64 residuals = 0;
+    for (int i = 0; i < NUM_RESIDUAL_CAUSES; i++) residuals += residuals_[i];
+    return residuals;
+}
+
+// Union-find over dense ids, for the offline analysis only.
+static uint32 Find(vector<uint32>* parent, uint32 x)
+{
+    while ((*parent)[x] != x)
+    {
+        (*parent)[x] = (*parent)[(*parent)[x]];
+        x            = (*parent)[x];
+    }
+    return x;
+}
+
+static void Union(vector<uint32>* parent, uint32 x, uint32 y) { (*parent)[Find(parent, x)] = Find(parent, y); }
+
+static ResidualCause Cause(const BatchGraph& graph, const BatchGraph::TxnEntry& txn)
+{
+    if (txn.clusters_.size() <= 1) return RESIDUAL_OTHER;
+    // ids are ascending, specials first
+    return txn.clusters_.back() < graph.specials_.size() ? RESIDUAL_ALPHA : RESIDUAL_STRAY;
+}
+
+// Fills in the connected components of the batch's txn-data graph and the
+// queues of its partition ('queues[i]' for txn i, -1 for a residual).
+static BatchGraphReport Report(const BatchGraph& graph, const vector<int>& queues)
+{
+    BatchGraphReport report;
+    report.batches_ = 1;
+    report.txns_    = graph.txns_.size();
+
+    std::map<int, uint64> queue_txns;
+    uint64 residuals = 0;
+    for (size_t i = 0; i < graph.txns_.size(); i++)
+    {
+        if (queues[i] >= 0)
+            queue_txns[queues[i]]++;
+        else
+            residuals++;
+    }
+    uint64 largest = 0;
+    for (std::map<int, uint64>::const_iterator it = queue_txns.begin(); it != queue_txns.end(); ++it)
+    {
+        report.cluster_txns_.Record(it->second);
+        largest = std::max(largest, it->second);
+    }
+    report.clusters_.Record(queue_txns.size());
+    report.critical_path_ = largest + residuals;
+
+    // txns conflict through the keys they both write
+    std::map<Key, uint32> key_ids;
+    vector<uint32> parent;
+    vector<uint32> txn_key(graph.txns_.size());
+    for (size_t i = 0; i < graph.txns_.size(); i++)
+    {
+        const vector<Key>& keys = graph.txns_[i].keys_;
+        // a txn without writes conflicts with nothing
+        uint32 first = parent.size();
+        parent.push_back(first);
+        for (size_t j = 0; j < keys.size(); j++)
+        {
+            std::map<Key, uint32>::iterator it = key_ids.find(keys[j]);
+            if (it == key_ids.end())
+            {
+                it = key_ids.insert(std::make_pair(keys[j], static_cast<uint32>(parent.size()))).first;
+                parent.push_back(it->second);
+            }
+            Union(&parent, it->second, first);
+        }
+        txn_key[i] = first;
+    }
+    std::map<uint32, uint64> component_txns;
+    for (size_t i = 0; i < graph.txns_.size(); i++) component_txns[Find(&parent, txn_key[i])]++;
+    largest = 0;
+    for (std::map<uint32, uint64>::const_iterator it = component_txns.begin(); it != component_txns.end(); ++it)
+    {
+        report.component_txns_.Record(it->second);
+        largest = std::max(largest, it->second);
+    }
+    report.components_.Record(component_txns.size());
+    report.component_critical_path_ = largest;
+    return report;
+}
+
+BatchGraphReport Analyze(const BatchGraph& graph)
+{
+    vector<int> queues(graph.txns_.size());
+    for (size_t i = 0; i < graph.txns_.size(); i++) queues[i] = graph.txns_[i].queue_;
+    BatchGraphReport report = Report(graph, queues);
+    for (size_t i = 0; i < graph.txns_.size(); i++)
+        if (queues[i] < 0) report.residuals_[Cause(graph, graph.txns_[i])]++;
+    return report;
+}
+
+BatchGraphReport AnalyzeAlpha(const BatchGraph& graph, float alpha)
+{
+    // Merge joins the specials of the candidates over the threshold
+    uint32 specials = graph.specials_.size();
+    vector<uint32> parent(specials);
+    for (uint32 i = 0; i < specials; i++) parent[i] = i;
+    for (size_t i = 0; i < graph.merges_.size(); i++)
+    {
+        const BatchGraph::MergeCandidate& candidate = graph.merges_[i];
+        if (BatchGraph::Merges(candidate, graph.specials_[candidate.a_].count_, graph.specials_[candidate.b_].count_,
+                               alpha))
+            Union(&parent, candidate.a_, candidate.b_);
+    }
+
+    // then Allocate queues the txns left in a single cluster
+    vector<int> queues(graph.txns_.size());
+    vector<bool> residual(graph.txns_.size());
+    for (size_t i = 0; i < graph.txns_.size(); i++)
+    {
+        const vector<uint32>& clusters = graph.txns_[i].clusters_;
+        int queue                      = -1;
+        for (size_t j = 0; j < clusters.size(); j++)
+        {
+            int cluster = clusters[j] < specials ? Find(&parent, clusters[j]) : clusters[j];
+            if (j > 0 && cluster != queue)
+            {
+                residual[i] = true;
+                break;
+            }
+            queue = cluster;
+        }
+        queues[i] = residual[i] ? -1 : queue;
+    }
+    BatchGraphReport report = Report(graph, queues);
+    for (size_t i = 0; i < graph.txns_.size(); i++)
+        if (residual[i]) report.residuals_[Cause(graph, graph.txns_[i])]++;
+    return report;
+}
+
+void WriteDot(const BatchGraph& graph, std::ostream& out)
+{
+    static const char* kColors[] = {"blue", "darkgreen", "orange", "purple", "brown", "cyan4", "gold3", "deeppink"};
+    static const int kNumColors  = sizeof(kColors) / sizeof(kColors[0]);
+
+    out << "graph batch_" << graph.batch_id_ << " {\n";
+    out << "  label=\"batch " << graph.batch_id_ << ": " << graph.txns_.size() << " txns, k=" << graph.k_
+        << ", alpha=" << graph.alpha_ << "\";\n";
+    out << "  node [fontsize=10];\n";
+
+    std::map<Key, bool> keys;  // key -> root of a special
+    for (size_t i = 0; i < graph.txns_.size(); i++)
+        for (size_t j = 0; j < graph.txns_[i].keys_.size(); j++) keys[graph.txns_[i].keys_[j]] = false;
+    for (size_t i = 0; i < graph.specials_.size(); i++) keys[graph.specials_[i].key_] = true;
+    for (std::map<Key, bool>::const_iterator it = keys.begin(); it != keys.end(); ++it)
+        out << "  k" << it->first << " [label=\"" << it->first << "\"" << (it->second ? ", style=bold" : "")
+            << "];\n";
+
+    for (size_t i = 0; i < graph.txns_.size(); i++)
+    {
+        const BatchGraph::TxnEntry& txn = graph.txns_[i];
+        const char* color = txn.queue_ < 0 ? "red" : kColors[txn.queue_ % kNumColors];
+        out << "  t" << i << " [shape=box, color=" << color << ", label=\"t" << i
+            << (txn.queue_ < 0 ? " residual" : "") << "\"];\n";
+        for (size_t j = 0; j < txn.keys_.size(); j++)
+            out << "  t" << i << " -- k" << txn.keys_[j] << " [color=" << color << "];\n";
+    }
+    out << "}\n";
+}
@@ -0,0 +1,169 @@
+// Conflict graphs of STRIFE batches (TxnProcessorOptions::graph_path_): for
+// every batch the clusterer partitions, the txn-data graph it started from,
+// the clusters Fuse grew around the special clusters Spot picked, the merge
+// candidates and the queue Allocate put every txn in. strife_graph analyses
+// them offline. A graph file is a header followed by one record per batch:
+//
+//   header: magic "STRG", format version (uint32 each)
+//   record: batch id, k (varints), alpha (float), txn count (varint)
+//           per txn: write set (count, then deltas of the sorted keys), Fuse clusters
+//                    (count, then ids), queue + 1 (0: residual), all varints
+//           specials: count, then root key and Fuse count of each (varints)
+//           merge candidates: count, then the two specials and the txns
+//                    spanning both of each (varints)
+//
+// Fuse clusters are numbered specials first (by Spot's cluster id), then the
+// other clusters in the order their first txn appears in the batch.
+
+#ifndef _BATCH_GRAPH_H_
+#define _BATCH_GRAPH_H_
+
+#include <stdio.h>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "txn/common.h"
+#include "utils/global.h"
+#include "utils/histogram.h"
+
+using std::string;
+using std::vector;
+
+struct BatchGraph
+{
+    struct TxnEntry
+    {
+        vector<Key> keys_;         // write set, ascending
+        vector<uint32> clusters_;  // distinct Fuse clusters of the keys, ascending
+        int queue_;                // worklist position of its queue, -1 for a residual
+    };
+
+    struct Special
+    {
+        Key key_;       // key of the cluster's root
+        uint64 count_;  // txns Spot and Fuse put in the cluster
+    };
+
+    struct MergeCandidate
+    {
+        uint32 a_, b_;   // specials, a_ < b_
+        uint64 cross_;   // txns spanning both
+    };
+
+    BatchGraph() : batch_id_(0), k_(0), alpha_(0) {}
+
+    // Merge joins the candidate's specials, exactly as ClustererBase::Merge.
+    static bool Merges(const MergeCandidate& candidate, uint64 count_a, uint64 count_b, float alpha)
+    {
+        return candidate.cross_ > alpha * (count_a + count_b + candidate.cross_);
+    }
+
+    void Encode(string* out) const;
+    // Returns false (leaving '*pos') if the record at '*pos' is cut short.
+    bool Decode(const char** pos, const char* end);
+
+    uint64 batch_id_;
+    uint32 k_;
+    float alpha_;
+    vector<TxnEntry> txns_;
+    vector<Special> specials_;
+    vector<MergeCandidate> merges_;
+};
+
+// Appends the graphs of a clusterer's batches to a new file. Only the
+// partitioning thread writes.
+class BatchGraphWriter
+{
+   public:
+    // Creates (truncates) the file at 'path'.
+    explicit BatchGraphWriter(const string& path);
+    ~BatchGraphWriter();
+
+    void Write(const BatchGraph& graph);
+
+    uint64 NumGraphs() const { return graphs_; }
+
+   private:
+    FILE* file_;
+    string buffer_;
+    uint64 graphs_;
+
+    DISALLOW_CLASS_COPY_AND_ASSIGN(BatchGraphWriter);
+};
+
+// Reads back the graphs of a file, in order.
+class BatchGraphReader
+{
+   public:
+    // Dies if 'path' can't be read or isn't a graph file.
+    explicit BatchGraphReader(const string& path);
+
+    // Returns false at the end of the file.
+    bool Next(BatchGraph* graph);
+
+   private:
+    string data_;
+    const char* pos_;
+
+    DISALLOW_CLASS_COPY_AND_ASSIGN(BatchGraphReader);
+};
+
+// why a txn ended up in the residual queue
+enum ResidualCause
+{
+    RESIDUAL_ALPHA = 0,  // spans special clusters only, which Merge kept apart at this alpha
+    RESIDUAL_STRAY = 1,  // also writes keys of a non-special cluster, which no Merge joins
+    RESIDUAL_OTHER = 2,  // in a single Fuse cluster (parallel clusterer races)
+    NUM_RESIDUAL_CAUSES = 3,
+};
+
+const char* ResidualCauseToString(ResidualCause cause);
+
+// What the partition of one or more batches achieved, against the finest one
+// without residuals: the connected components of the txn-data graph, which
+// every cluster lies within. Residuals run after the clusters, one at a time,
+// so the critical path of a batch is its largest cluster plus its residuals;
+// on a few hot keys that beats the components, which then join most txns.
+struct BatchGraphReport
+{
+    BatchGraphReport() : batches_(0), txns_(0), critical_path_(0), component_critical_path_(0)
+    {
+        memset(residuals_, 0, sizeof(residuals_));
+    }
+
+    // Adds the batches of 'other'.
+    void Merge(const BatchGraphReport& other);
+
+    uint64 Residuals() const;
+
+    // Speedup over running the batches serially, with unlimited executors.
+    double Speedup() const { return critical_path_ > 0 ? static_cast<double>(txns_) / critical_path_ : 0; }
+    double ComponentSpeedup() const
+    {
+        return component_critical_path_ > 0 ? static_cast<double>(txns_) / component_critical_path_ : 0;
+    }
+
+    uint64 batches_;
+    uint64 txns_;
+    uint64 residuals_[NUM_RESIDUAL_CAUSES];
+    Histogram clusters_;        // conflict free queues of a batch
+    Histogram cluster_txns_;    // txns of a queue
+    Histogram components_;      // connected components of a batch
+    Histogram component_txns_;  // txns of a component
+    uint64 critical_path_;            // txns, summed over the batches
+    uint64 component_critical_path_;  // txns of the largest components, summed
+};
+
+// Report of the partition the clusterer made.
+BatchGraphReport Analyze(const BatchGraph& graph);
+
+// Report of the partition ClustererSerial would have made of the batch at
+// another 'alpha' (Spot and Fuse don't depend on it).
+BatchGraphReport AnalyzeAlpha(const BatchGraph& graph, float alpha);
+
+// Writes the txn-data graph in Graphviz DOT: txns as boxes, keys as
+// ellipses, coloured by queue (residuals in red, special roots in bold).
+void WriteDot(const BatchGraph& graph, std::ostream& out);
+
+#endif  // _BATCH_GRAPH_H_
@@ -0,0 +1,168 @@
+#include "txn/batch_graph.h"
+
+#include <stdio.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <sstream>
+
+#include "txn/load_generator.h"
+#include "txn/txn_processor.h"
+#include "utils/testing.h"
+
+static string TempPath(const char* name)
+{
+    char path[128];
+    snprintf(path, sizeof(path), "/tmp/strife_%s_%d", name, getpid());
+    return path;
+}
+
+static BatchGraph::TxnEntry Entry(const vector<Key>& keys, const vector<uint32>& clusters, int queue)
+{
+    BatchGraph::TxnEntry entry;
+    entry.keys_     = keys;
+    entry.clusters_ = clusters;
+    entry.queue_    = queue;
+    return entry;
+}
+
+// Two specials rooted at keys 1 and 2, each with two txns of its own, two txns
+// spanning both and one also writing key 9, alone in cluster 2.
+static BatchGraph TwoSpecials()
+{
+    BatchGraph graph;
+    graph.batch_id_ = 7;
+    graph.k_        = 2;
+    graph.alpha_    = 0.2;
+    graph.txns_.push_back(Entry({1}, {0}, 0));
+    graph.txns_.push_back(Entry({1, 3}, {0}, 0));
+    graph.txns_.push_back(Entry({2}, {1}, 1));
+    graph.txns_.push_back(Entry({2, 4}, {1}, 1));
+    graph.txns_.push_back(Entry({1, 2}, {0, 1}, -1));
+    graph.txns_.push_back(Entry({3, 4}, {0, 1}, -1));
+    graph.txns_.push_back(Entry({2, 9}, {1, 2}, -1));
+    BatchGraph::Special special;
+    special.key_   = 1;
+    special.count_ = 5;
+    graph.specials_.push_back(special);
+    special.key_ = 2;
+    graph.specials_.push_back(special);
+    BatchGraph::MergeCandidate candidate;
+    candidate.a_     = 0;
+    candidate.b_     = 1;
+    candidate.cross_ = 2;
+    graph.merges_.push_back(candidate);
+    return graph;
+}
+
+TEST(BatchGraph_Codec)
+{
+    BatchGraph graph = TwoSpecials();
+    string encoded;
+    graph.Encode(&encoded);
+
+    BatchGraph decoded;
+    const char* pos = encoded.data();
+    EXPECT_TRUE(decoded.Decode(&pos, encoded.data() + encoded.size()));
+    EXPECT_TRUE(pos == encoded.data() + encoded.size());
+    EXPECT_EQ(7, (int)decoded.batch_id_);
+    EXPECT_TRUE(decoded.alpha_ == graph.alpha_);
+    EXPECT_EQ(graph.txns_.size(), decoded.txns_.size());
+    for (size_t i = 0; i < graph.txns_.size(); i++)
+    {
+        EXPECT_TRUE(decoded.txns_[i].keys_ == graph.txns_[i].keys_);
+        EXPECT_TRUE(decoded.txns_[i].clusters_ == graph.txns_[i].clusters_);
+        EXPECT_EQ(graph.txns_[i].queue_, decoded.txns_[i].queue_);
+    }
+    EXPECT_EQ(5, (int)decoded.specials_[1].count_);
+    EXPECT_EQ(2, (int)decoded.merges_[0].cross_);
+
+    // a cut short record doesn't decode
+    pos = encoded.data();
+    EXPECT_FALSE(decoded.Decode(&pos, encoded.data() + encoded.size() - 1));
+    EXPECT_TRUE(pos == encoded.data());
+    END;
+}
+
+TEST(BatchGraph_Analyze)
+{
+    BatchGraph graph = TwoSpecials();
+    BatchGraphReport report = Analyze(graph);
+    EXPECT_EQ(7, (int)report.txns_);
+    EXPECT_EQ(2, (int)report.residuals_[RESIDUAL_ALPHA]);
+    EXPECT_EQ(1, (int)report.residuals_[RESIDUAL_STRAY]);
+    EXPECT_EQ(2, (int)report.clusters_.Max());
+    EXPECT_EQ(2, (int)report.cluster_txns_.Max());
+    // every txn is connected through keys 1 and 2
+    EXPECT_EQ(1, (int)report.components_.Max());
+    EXPECT_EQ(2 + 3, (int)report.critical_path_);
+    EXPECT_EQ(7, (int)report.component_critical_path_);
+
+    // 2 <= 0.2 * (5 + 5 + 2): replaying the batch's alpha reproduces it
+    BatchGraphReport same = AnalyzeAlpha(graph, graph.alpha_);
+    EXPECT_EQ(report.Residuals(), same.Residuals());
+    EXPECT_EQ(report.critical_path_, same.critical_path_);
+
+    // 2 > 0.1 * 12 merges the specials, all but the stray txn run in one queue
+    BatchGraphReport merged = AnalyzeAlpha(graph, 0.1);
+    EXPECT_EQ(0, (int)merged.residuals_[RESIDUAL_ALPHA]);
+    EXPECT_EQ(1, (int)merged.residuals_[RESIDUAL_STRAY]);
+    EXPECT_EQ(6, (int)merged.cluster_txns_.Max());
+
+    std::stringstream dot;
+    WriteDot(graph, dot);
+    EXPECT_TRUE(dot.str().find("graph batch_7 {") == 0);
+    EXPECT_TRUE(dot.str().find("t4 -- k2") != string::npos);
+    END;
+}
+
+// The graphs a STRIFE_S processor exports account for every txn, and
+// replaying its alpha allocates them the way ClustererSerial did.
+TEST(BatchGraph_Export)
+{
+    string path = TempPath("graphs");
+    RMWLoadGenHot lg(10000, 0, 4, 0, 20, 4, 1, 10, 2);
+    int num_txns = 3000;
+    PartitionStats stats;
+    {
+        TxnProcessorOptions options;
+        options.graph_path_ = path;
+        TxnProcessor p(STRIFE_S, options);
+        for (int i = 0; i < num_txns; i++) p.NewTxnRequest(lg.NewTxn());
+        for (int i = 0; i < num_txns; i++) delete p.GetTxnResult();
+        stats = p.STRIFEStats();
+    }
+
+    BatchGraphReader reader(path);
+    BatchGraph graph;
+    BatchGraphReport total;
+    uint64 batches = 0;
+    while (reader.Next(&graph))
+    {
+        EXPECT_EQ(batches, graph.batch_id_);
+        batches++;
+        BatchGraphReport report = Analyze(graph);
+        BatchGraphReport replay = AnalyzeAlpha(graph, graph.alpha_);
+        EXPECT_EQ(report.Residuals(), replay.Residuals());
+        EXPECT_EQ(report.clusters_.Max(), replay.clusters_.Max());
+        EXPECT_EQ(0, (int)report.residuals_[RESIDUAL_OTHER]);
+        for (size_t i = 0; i < graph.txns_.size(); i++)
+            EXPECT_TRUE(std::is_sorted(graph.txns_[i].keys_.begin(), graph.txns_[i].keys_.end()));
+        total.Merge(report);
+    }
+    EXPECT_EQ(stats.batches_, batches);
+    EXPECT_EQ(num_txns, (int)total.txns_);
+    EXPECT_EQ(stats.residuals_.Sum(), total.Residuals());
+    EXPECT_EQ(stats.clusters_.Sum(), total.clusters_.Sum());
+    // clusters lie within components
+    EXPECT_TRUE(total.component_txns_.Max() >= total.cluster_txns_.Max());
+    unlink(path.c_str());
+    END;
+}
+
+int main(int argc, char** argv)
+{
+    BatchGraph_Codec();
+    BatchGraph_Analyze();
+    BatchGraph_Export();
+}
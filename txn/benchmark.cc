@@ -0,0 +1,585 @@
+#include "txn/benchmark.h"
+
+#include <math.h>
+#include <stdlib.h>
+
+#include <atomic>
+#include <fstream>
+#include <iomanip>
+#include <random>
+#include <sstream>
+#include <thread>
+
+#include "txn/trace.h"
+#include "utils/cycle_clock.h"
+
+static const struct
+{
+    const char* name;
+    CCMode mode;
+} kModeNames[] = {
+    {"SERIAL", SERIAL},       {"LOCKING_EXCLUSIVE_ONLY", LOCKING_EXCLUSIVE_ONLY},
+    {"LOCKING", LOCKING},     {"OCC", OCC},
+    {"P_OCC", P_OCC},         {"MVCC", MVCC},
+    {"STRIFE_S", STRIFE_S},   {"STRIFE_PM", STRIFE_PM},
+    {"STRIFE_LM", STRIFE_LM}, {"STRIFE_PLM", STRIFE_PLM},
+    {"STRIFE_P", STRIFE_P},   {"STRIFE_PM_P", STRIFE_PM_P},
+};
+
+static const int kNumModes = sizeof(kModeNames) / sizeof(kModeNames[0]);
+
+const char* ModeName(CCMode mode)
+{
+    for (int i = 0; i < kNumModes; i++)
+        if (kModeNames[i].mode == mode) return kModeNames[i].name;
+    return "UNKNOWN";
+}
+
+bool ParseMode(const string& name, CCMode* mode)
+{
+    for (int i = 0; i < kNumModes; i++)
+    {
+        if (name == kModeNames[i].name)
+        {
+            *mode = kModeNames[i].mode;
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool ParseInt(const string& value, int* result)
+{
+    char* end;
+    long parsed = strtol(value.c_str(), &end, 10);
+    if (value.empty() || *end != '\0') return false;
+    *result = static_cast<int>(parsed);
+    return true;
+}
+
+static bool ParseDouble(const string& value, double* result)
+{
+    char* end;
+    double parsed = strtod(value.c_str(), &end);
+    if (value.empty() || *end != '\0') return false;
+    *result = parsed;
+    return true;
+}
+
+static vector<string> SplitList(const string& value)
+{
+    vector<string> items;
+    std::stringstream stream(value);
+    string item;
+    while (std::getline(stream, item, ','))
+        if (!item.empty()) items.push_back(item);
+    return items;
+}
+
+BenchSpec::BenchSpec()
+    : workload_("rmw"),
+      dbsize_(1000000),
+      rsetsize_(0),
+      wsetsize_(10),
+      txn_time_(0.0001),
+      clusters_(10),
+      theta_(0.99),
+      hotsetsize_(100),
+      hotpartition_(1),
+      hotdatasize_(1),
+      reshotsize_(0),
+      residual_(0),
+      hotpct_(90),
+      shift_period_(1),
+      warehouses_(4),
+      neworder_pct_(50),
+      trace_(""),
+      duration_(1),
+      arrival_("closed"),
+      active_txns_(100),
+      clients_(2),
+      reps_(3),
+      format_("csv"),
+      output_(""),
+      record_(""),
+      graphs_(""),
+      perf_(false)
+{
+    modes_.push_back(STRIFE_S);
+    threads_.push_back(THREAD_COUNT);
+    rates_.push_back(1000);
+}
+
+bool BenchSpec::Set(const string& setting, string* error)
+{
+    size_t eq = setting.find('=');
+    if (eq == string::npos)
+    {
+        *error = "expected key=value: " + setting;
+        return false;
+    }
+    string key   = setting.substr(0, eq);
+    string value = setting.substr(eq + 1);
+
+    bool ok = true;
+    if (key == "workload")
+    {
+        workload_ = value;
+        ok        = workload_ == "rmw" || workload_ == "rmw2" || workload_ == "par" || workload_ == "hot" ||
+             workload_ == "zipf" || workload_ == "latest" || workload_ == "hotspot" || workload_ == "tpcc" ||
+             workload_ == "trace";
+    }
+    else if (key == "dbsize")
+        ok = ParseInt(value, &dbsize_) && dbsize_ > 0 && dbsize_ <= MAX_DB_SIZE;
+    else if (key == "rsetsize")
+        ok = ParseInt(value, &rsetsize_) && rsetsize_ >= 0;
+    else if (key == "wsetsize")
+        ok = ParseInt(value, &wsetsize_) && wsetsize_ >= 0;
+    else if (key == "txn_time")
+        ok = ParseDouble(value, &txn_time_) && txn_time_ >= 0;
+    else if (key == "clusters")
+        ok = ParseInt(value, &clusters_) && clusters_ > 0;
+    else if (key == "theta")
+        ok = ParseDouble(value, &theta_) && theta_ >= 0 && theta_ < 1;
+    else if (key == "hotsetsize")
+        ok = ParseInt(value, &hotsetsize_) && hotsetsize_ > 0;
+    else if (key == "hotpartition")
+        ok = ParseInt(value, &hotpartition_) && hotpartition_ > 0;
+    else if (key == "hotdatasize")
+        ok = ParseInt(value, &hotdatasize_) && hotdatasize_ >= 0;
+    else if (key == "reshotsize")
+        ok = ParseInt(value, &reshotsize_) && reshotsize_ >= 0;
+    else if (key == "residual")
+        ok = ParseInt(value, &residual_) && residual_ >= 0 && residual_ <= 100;
+    else if (key == "hotpct")
+        ok = ParseInt(value, &hotpct_) && hotpct_ >= 0 && hotpct_ <= 100;
+    else if (key == "shift_period")
+        ok = ParseDouble(value, &shift_period_) && shift_period_ >= 0;
+    else if (key == "warehouses")
+        ok = ParseInt(value, &warehouses_) && warehouses_ > 0 && TpccLayout::Fits(warehouses_);
+    else if (key == "neworder_pct")
+        ok = ParseInt(value, &neworder_pct_) && neworder_pct_ >= 0 && neworder_pct_ <= 100;
+    else if (key == "trace")
+    {
+        trace_ = value;
+        ok     = !trace_.empty();
+    }
+    else if (key == "record")
+        record_ = value;
+    else if (key == "graphs")
+        graphs_ = value;
+    else if (key == "perf")
+    {
+        int perf;
+        ok    = ParseInt(value, &perf) && (perf == 0 || perf == 1);
+        perf_ = perf == 1;
+    }
+    else if (key == "duration")
+        ok = ParseDouble(value, &duration_) && duration_ > 0;
+    else if (key == "arrival")
+    {
+        arrival_ = value;
+        ok       = arrival_ == "closed" || arrival_ == "poisson" || arrival_ == "constant" || arrival_ == "trace";
+    }
+    else if (key == "active")
+        ok = ParseInt(value, &active_txns_) && active_txns_ > 0;
+    else if (key == "clients")
+        ok = ParseInt(value, &clients_) && clients_ > 0;
+    else if (key == "rates")
+    {
+        rates_.clear();
+        vector<string> rates = SplitList(value);
+        for (size_t i = 0; i < rates.size() && ok; i++)
+        {
+            double rate;
+            ok = ParseDouble(rates[i], &rate) && rate > 0;
+            rates_.push_back(rate);
+        }
+        ok = ok && !rates_.empty();
+    }
+    else if (key == "reps")
+        ok = ParseInt(value, &reps_) && reps_ > 0;
+    else if (key == "format")
+    {
+        format_ = value;
+        ok      = format_ == "csv" || format_ == "json";
+    }
+    else if (key == "output")
+        output_ = value;
+    else if (key == "modes")
+    {
+        modes_.clear();
+        vector<string> names = SplitList(value);
+        for (size_t i = 0; i < names.size() && ok; i++)
+        {
+            CCMode mode;
+            ok = ParseMode(names[i], &mode);
+            modes_.push_back(mode);
+        }
+        ok = ok && !modes_.empty();
+    }
+    else if (key == "threads")
+    {
+        threads_.clear();
+        vector<string> counts = SplitList(value);
+        for (size_t i = 0; i < counts.size() && ok; i++)
+        {
+            int threads;
+            ok = ParseInt(counts[i], &threads) && threads > 0;
+            threads_.push_back(threads);
+        }
+        ok = ok && !threads_.empty();
+    }
+    else
+    {
+        *error = "unknown setting: " + key;
+        return false;
+    }
+
+    if (!ok) *error = "bad value for " + key + ": " + value;
+    return ok;
+}
+
+bool BenchSpec::Load(const string& path, string* error)
+{
+    std::ifstream in(path.c_str());
+    if (!in)
+    {
+        *error = "can't open " + path;
+        return false;
+    }
+    string line;
+    for (int number = 1; std::getline(in, line); number++)
+    {
+        size_t comment = line.find('#');
+        if (comment != string::npos) line.erase(comment);
+        size_t begin = line.find_first_not_of(" \t\r");
+        if (begin == string::npos) continue;
+        line = line.substr(begin, line.find_last_not_of(" \t\r") + 1 - begin);
+        if (!Set(line, error))
+        {
+            std::ostringstream where;
+            where << path << ":" << number << ": " << *error;
+            *error = where.str();
+            return false;
+        }
+    }
+    return true;
+}
+
+LoadGen* BenchSpec::NewLoadGen() const
+{
+    if (workload_ == "rmw2") return new RMWLoadGen2(dbsize_, rsetsize_, wsetsize_, txn_time_);
+    if (workload_ == "par") return new RMWLoadGenPar(dbsize_, rsetsize_, wsetsize_, clusters_, txn_time_, residual_);
+    if (workload_ == "hot")
+        return new RMWLoadGenHot(dbsize_, rsetsize_, wsetsize_, txn_time_, hotsetsize_, hotpartition_, hotdatasize_,
+                                 residual_, reshotsize_);
+    if (workload_ == "zipf") return new ZipfianLoadGen(dbsize_, rsetsize_, wsetsize_, theta_, txn_time_);
+    if (workload_ == "latest") return new LatestLoadGen(dbsize_, rsetsize_, wsetsize_, theta_, txn_time_);
+    if (workload_ == "hotspot")
+        return new ShiftingHotspotLoadGen(dbsize_, rsetsize_, wsetsize_, hotsetsize_, hotpct_, shift_period_,
+                                          txn_time_);
+    if (workload_ == "trace")
+    {
+        if (trace_.empty()) DIE("workload=trace needs a trace file");
+        return new TraceLoadGen(trace_);
+    }
+    if (workload_ == "tpcc") return new TpccLoadGen(TpccLayout(warehouses_), neworder_pct_, txn_time_);
+    return new RMWLoadGen(dbsize_, rsetsize_, wsetsize_, txn_time_);
+}
+
+BenchSummary Summarize(const vector<double>& samples)
+{
+    // Two sided 95% quantiles of Student's t for 1..30 degrees of freedom.
+    static const double kT95[] = {12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+                                  2.201,  2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+                                  2.080,  2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042};
+
+    BenchSummary summary;
+    size_t n = samples.size();
+    if (n == 0) return summary;
+    for (size_t i = 0; i < n; i++) summary.mean_ += samples[i];
+    summary.mean_ /= n;
+    if (n == 1) return summary;
+
+    double squares = 0;
+    for (size_t i = 0; i < n; i++) squares += (samples[i] - summary.mean_) * (samples[i] - summary.mean_);
+    summary.stddev_ = sqrt(squares / (n - 1));
+    double t        = n - 1 <= 30 ? kT95[n - 2] : 1.960;
+    summary.ci95_   = t * summary.stddev_ / sqrt(static_cast<double>(n));
+    return summary;
+}
+
+// Keeps 'active_txns_' txns in flight, replacing every result by a new txn
+// until the time is up, then drains. Returns the throughput.
+static double RunClosedLoop(const BenchSpec& spec, TxnProcessor* p, LoadGen* lg)
+{
+    Txn* done[64];
+    double start = GetTime();
+    for (int i = 0; i < spec.active_txns_; i++) p->NewTxnRequest(lg->NewPooledTxn(p->Pool()));
+    uint64 txn_count = 0;
+    while (GetTime() < start + spec.duration_)
+    {
+        int n = p->GetTxnResults(done, 64);
+        for (int i = 0; i < n; i++)
+        {
+            p->ReleaseTxn(done[i]);
+            p->NewTxnRequest(lg->NewPooledTxn(p->Pool()));
+        }
+        txn_count += n;
+    }
+    for (int left = spec.active_txns_; left > 0;)
+    {
+        int n = p->GetTxnResults(done, left < 64 ? left : 64);
+        for (int i = 0; i < n; i++) p->ReleaseTxn(done[i]);
+        txn_count += n;
+        left -= n;
+    }
+    return txn_count / (GetTime() - start);
+}
+
+// Submits txns for 'duration_' seconds from 'clients_' threads, each at its
+// share of 'rate', with exponential (poisson) or fixed gaps, or at the
+// arrival times of the trace replayed by 'lg' (arrival=trace). Every txn is
+// stamped with the time it was due, so a client falling behind can't hide
+// latency. The calling thread collects the results, until all are back.
+// Returns the throughput.
+static double RunOpenLoop(const BenchSpec& spec, TxnProcessor* p, LoadGen* lg, double rate)
+{
+    std::atomic<uint64> submitted(0);
+    std::atomic<int> clients_done(0);
+    uint64 start    = CycleClock::Now();
+    uint64 end      = start + static_cast<uint64>(spec.duration_ * CycleClock::PerSecond());
+    double mean_gap = rate > 0 ? CycleClock::PerSecond() * spec.clients_ / rate : 0;
+
+    TraceLoadGen* trace = nullptr;
+    if (spec.arrival_ == "trace")
+    {
+        trace = dynamic_cast<TraceLoadGen*>(lg);
+        if (trace == nullptr) DIE("arrival=trace needs workload=trace");
+    }
+
+    vector<std::thread> clients;
+    for (int c = 0; c < spec.clients_; c++)
+    {
+        clients.push_back(std::thread([&, c]() {
+            std::mt19937_64 random(c + 1);
+            std::exponential_distribution<double> gap(mean_gap > 0 ? 1 / mean_gap : 1);
+            // Clients start staggered, so constant arrivals don't come in bursts.
+            double due = start + mean_gap * c / spec.clients_;
+            while (true)
+            {
+                // Clients share the trace, each taking the next txn due.
+                Txn* txn = nullptr;
+                if (trace != nullptr)
+                {
+                    double arrival;
+                    txn = trace->Next(&arrival);
+                    if (txn == nullptr) break;
+                    due = start + arrival * CycleClock::PerSecond();
+                }
+                if (due >= end)
+                {
+                    delete txn;
+                    break;
+                }
+
+                uint64 due_cycles = static_cast<uint64>(due);
+                for (uint64 now = CycleClock::Now(); now < due_cycles; now = CycleClock::Now())
+                {
+                    double wait = (due_cycles - now) / CycleClock::PerSecond();
+                    if (wait > 0.0002)
+                        Sleep(wait - 0.0001);
+                    else
+                        std::this_thread::yield();
+                }
+                if (txn == nullptr) txn = lg->NewPooledTxn(p->Pool());
+                txn->stage_time_[TXN_SUBMITTED] = due_cycles;
+                p->NewTxnRequest(txn);
+                submitted++;
+                if (trace == nullptr) due += spec.arrival_ == "poisson" ? gap(random) : mean_gap;
+            }
+            clients_done++;
+        }));
+    }
+
+    Txn* done[64];
+    uint64 received = 0;
+    while (clients_done.load() < spec.clients_ || received < submitted.load())
+    {
+        int n = p->GetTxnResults(done, 64, false);
+        if (n == 0)
+        {
+            std::this_thread::yield();
+            continue;
+        }
+        for (int i = 0; i < n; i++) p->ReleaseTxn(done[i]);
+        received += n;
+    }
+    uint64 finish = CycleClock::Now();
+    for (size_t c = 0; c < clients.size(); c++) clients[c].join();
+    return received / CycleClock::ToSeconds(finish - start);
+}
+
+BenchResult RunBenchmark(const BenchSpec& spec, CCMode mode, int threads, double rate)
+{
+    BenchResult result;
+    result.mode_         = mode;
+    result.threads_      = threads;
+    result.offered_rate_ = spec.arrival_ == "closed" || spec.arrival_ == "trace" ? 0 : rate;
+
+    TxnProcessorOptions options;
+    options.worker_threads_ = threads;
+    options.trace_path_     = spec.record_;
+    options.graph_path_     = spec.graphs_;
+    options.perf_counters_  = spec.perf_;
+    for (int rep = 0; rep < spec.reps_; rep++)
+    {
+        LoadGen* lg     = spec.NewLoadGen();
+        TxnProcessor* p = new TxnProcessor(mode, options);
+
+        if (spec.arrival_ == "closed")
+            result.throughput_.push_back(RunClosedLoop(spec, p, lg));
+        else
+            result.throughput_.push_back(RunOpenLoop(spec, p, lg, rate));
+        TxnLatencyStats latency = p->LatencyStats();
+        for (int path = 0; path < NUM_LATENCY_PATHS; path++) result.latency_.Merge(latency.total_[path]);
+        if (spec.perf_)
+        {
+            PartitionStats partition = p->STRIFEStats();
+            result.partition_txns_ += partition.txns_.Sum();
+            for (int phase = 0; phase < NUM_PARTITION_PHASES; phase++)
+                result.partition_events_[phase] += partition.phase_events_[phase];
+            ExecutorPerfStats executor = p->ExecutorPerf();
+            for (int path = 0; path < NUM_LATENCY_PATHS; path++)
+            {
+                result.executor_.queues_[path] += executor.queues_[path];
+                result.executor_.txns_[path] += executor.txns_[path];
+                result.executor_.events_[path] += executor.events_[path];
+            }
+        }
+
+        delete p;
+        delete lg;
+    }
+    return result;
+}
+
+static double Micros(uint64 cycles) { return CycleClock::ToSeconds(cycles) * 1e6; }
+
+static double PerTxn(uint64 count, uint64 txns) { return txns > 0 ? static_cast<double>(count) / txns : 0; }
+
+static double Ipc(const PerfSample& events)
+{
+    uint64 cycles = events.value_[PERF_CYCLES];
+    return cycles > 0 ? static_cast<double>(events.value_[PERF_INSTRUCTIONS]) / cycles : 0;
+}
+
+static void PartitionTotals(const BenchResult& r, PerfSample* events)
+{
+    for (int phase = 0; phase < NUM_PARTITION_PHASES; phase++) *events += r.partition_events_[phase];
+}
+
+static void ExecutorTotals(const BenchResult& r, PerfSample* events, uint64* txns)
+{
+    *txns = 0;
+    for (int path = 0; path < NUM_LATENCY_PATHS; path++)
+    {
+        *events += r.executor_.events_[path];
+        *txns += r.executor_.txns_[path];
+    }
+}
+
+// {"txns": .., "cycles_per_txn": .., "ipc": .., ...} of 'events' over 'txns'.
+static void WritePerfJson(const PerfSample& events, uint64 txns, std::ostream& out)
+{
+    out << "{\"txns\": " << txns;
+    for (int e = 0; e < NUM_PERF_EVENTS; e++)
+    {
+        if (e == PERF_INSTRUCTIONS) continue;
+        out << ", \"" << PerfCounters::EventName(static_cast<PerfEvent>(e))
+            << "_per_txn\": " << PerTxn(events.value_[e], txns);
+    }
+    out << ", \"ipc\": " << std::setprecision(3) << Ipc(events) << std::setprecision(1) << "}";
+}
+
+// CSV columns of 'events' over 'txns', as named by PerfCsvHeader().
+static void WritePerfCsv(const PerfSample& events, uint64 txns, std::ostream& out)
+{
+    out << "," << PerTxn(events.value_[PERF_CYCLES], txns) << "," << std::setprecision(3) << Ipc(events)
+        << std::setprecision(1) << "," << PerTxn(events.value_[PERF_LLC_MISSES], txns) << ","
+        << PerTxn(events.value_[PERF_BRANCH_MISSES], txns);
+}
+
+static string PerfCsvHeader(const string& prefix)
+{
+    return "," + prefix + "_cycles_per_txn," + prefix + "_ipc," + prefix + "_llc_misses_per_txn," + prefix +
+           "_branch_misses_per_txn";
+}
+
+void WriteResults(const BenchSpec& spec, const vector<BenchResult>& results, std::ostream& out)
+{
+    out << std::fixed << std::setprecision(1);
+    if (spec.format_ == "json")
+    {
+        out << "[\n";
+        for (size_t i = 0; i < results.size(); i++)
+        {
+            const BenchResult& r = results[i];
+            BenchSummary tput    = Summarize(r.throughput_);
+            out << "  {\"workload\": \"" << spec.workload_ << "\", \"mode\": \"" << ModeName(r.mode_)
+                << "\", \"threads\": " << r.threads_ << ", \"arrival\": \"" << spec.arrival_
+                << "\", \"offered_rate\": " << r.offered_rate_ << ", \"reps\": " << r.throughput_.size()
+                << ", \"throughput\": {\"mean\": " << tput.mean_ << ", \"stddev\": " << tput.stddev_
+                << ", \"ci95\": " << tput.ci95_ << "}, \"latency_us\": {\"p50\": " << Micros(r.latency_.Percentile(50))
+                << ", \"p99\": " << Micros(r.latency_.Percentile(99))
+                << ", \"p999\": " << Micros(r.latency_.Percentile(99.9))
+                << ", \"max\": " << Micros(r.latency_.Max()) << "}";
+            if (spec.perf_)
+            {
+                out << ", \"perf\": {\"partition\": {";
+                for (int phase = 0; phase < NUM_PARTITION_PHASES; phase++)
+                {
+                    out << (phase > 0 ? ", \"" : "\"") << PartitionPhaseToString(static_cast<PartitionPhase>(phase))
+                        << "\": ";
+                    WritePerfJson(r.partition_events_[phase], r.partition_txns_, out);
+                }
+                out << "}, \"executor\": {";
+                for (int path = 0; path < NUM_LATENCY_PATHS; path++)
+                {
+                    out << (path > 0 ? ", \"" : "\"") << LatencyPathToString(static_cast<LatencyPath>(path))
+                        << "\": ";
+                    WritePerfJson(r.executor_.events_[path], r.executor_.txns_[path], out);
+                }
+                out << "}}";
+            }
+            out << "}" << (i + 1 < results.size() ? "," : "") << "\n";
+        }
+        out << "]\n";
+        return;
+    }
+
+    out << "workload,mode,threads,arrival,offered_rate,reps,throughput_mean,throughput_stddev,throughput_ci95,p50_us,p99_us,p999_us,max_us";
+    if (spec.perf_) out << PerfCsvHeader("partition") << PerfCsvHeader("executor");
+    out << "\n";
+    for (size_t i = 0; i < results.size(); i++)
+    {
+        const BenchResult& r = results[i];
+        BenchSummary tput    = Summarize(r.throughput_);
+        out << spec.workload_ << "," << ModeName(r.mode_) << "," << r.threads_ << "," << spec.arrival_ << ","
+            << r.offered_rate_ << "," << r.throughput_.size() << ","
+            << tput.mean_ << "," << tput.stddev_ << "," << tput.ci95_ << "," << Micros(r.latency_.Percentile(50))
+            << "," << Micros(r.latency_.Percentile(99)) << "," << Micros(r.latency_.Percentile(99.9)) << ","
+            << Micros(r.latency_.Max());
+        if (spec.perf_)
+        {
+            PerfSample partition, executor;
+            uint64 executor_txns;
+            PartitionTotals(r, &partition);
+            ExecutorTotals(r, &executor, &executor_txns);
+            WritePerfCsv(partition, r.partition_txns_, out);
+            WritePerfCsv(executor, executor_txns, out);
+        }
+        out << "\n";
+    }
+}
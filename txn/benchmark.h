@@ -0,0 +1,152 @@
+// Benchmark sweeps of the TxnProcessor, described by a workload spec (see
+// strife_bench). A spec is a list of 'key=value' settings, one per line in a
+// spec file ('#' starts a comment) or one per command line argument:
+//
+//   workload=hot        rmw, rmw2, par, hot, zipf, latest, hotspot, tpcc or
+//                       trace (RMWLoadGen, RMWLoadGen2, RMWLoadGenPar,
+//                       RMWLoadGenHot, ZipfianLoadGen, LatestLoadGen,
+//                       ShiftingHotspotLoadGen, TpccLoadGen, TraceLoadGen)
+//   dbsize=1000000      keys in the database
+//   rsetsize=0          keys read by a txn
+//   wsetsize=10         keys written by a txn (STRIFE needs at least one)
+//   txn_time=0.0001     seconds a txn busy waits when it runs
+//   clusters=10         par: disjoint key ranges
+//   theta=0.99          zipf, latest: Zipfian skew, in [0, 1)
+//   hotsetsize=100      hot, hotspot: keys of the hot set
+//   hotpartition=1      hot: partitions of the hot set
+//   hotdatasize=1       hot: hot keys per txn
+//   reshotsize=0        hot: hot keys of a residual txn
+//   residual=0          par, hot: percentage of txns spanning clusters
+//   hotpct=90           hotspot: percentage of keys in the hot set
+//   shift_period=1      hotspot: seconds before the hot set moves
+//   warehouses=4        tpcc: warehouses (TpccLayout, up to 76)
+//   neworder_pct=50     tpcc: percentage of NewOrders, the rest Payments
+//   trace=              trace: trace file to replay, looping (txn/trace.h)
+//   duration=1          seconds of a run
+//   arrival=closed      closed: a new txn per result, 'active' in flight;
+//                       poisson or constant: open loop, txns arrive at
+//                       'rates' from 'clients' threads whatever the results;
+//                       trace: open loop at the arrival times of the trace
+//   active=100          txns in flight (closed loop)
+//   rates=1000,2000     offered loads to sweep, txns per second (open loop)
+//   clients=2           submitting threads (open loop)
+//   modes=STRIFE_S,MVCC CCMode names
+//   threads=8           worker thread counts to sweep
+//   reps=3              runs of every (mode, threads, rate) point
+//   format=csv          csv or json
+//   output=             result file ("" for stdout)
+//   record=             trace file recording the txns of the last run
+//   graphs=             conflict graphs of the STRIFE batches of the last
+//                       run, for strife_graph (txn/batch_graph.h)
+//   perf=0              1: hardware counters of the STRIFE phases and
+//                       executors (TxnProcessorOptions::perf_counters_)
+//
+// Each point reports the mean throughput of its runs with a 95% confidence
+// interval, and the end to end latency percentiles over all the runs. Closed
+// loop throughput is flattering: the load backs off as the system slows. Open
+// loop points, swept over the offered load, show where latency takes off.
+// With perf=1, STRIFE points also report cycles and instructions per txn
+// (IPC) and LLC and branch misses per txn, of the partitioner and of the
+// executors; counters the machine won't provide read 0.
+
+#ifndef _BENCHMARK_H_
+#define _BENCHMARK_H_
+
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "txn/load_generator.h"
+#include "txn/txn_processor.h"
+#include "utils/histogram.h"
+
+using std::string;
+using std::vector;
+
+struct BenchSpec
+{
+    BenchSpec();
+
+    // Applies one 'key=value' setting. Returns false, with a message in
+    // '*error', for unknown keys and malformed values.
+    bool Set(const string& setting, string* error);
+
+    // Applies the settings of the spec file at 'path'.
+    bool Load(const string& path, string* error);
+
+    // Returns a new generator of the spec's workload, owned by the caller.
+    LoadGen* NewLoadGen() const;
+
+    string workload_;
+    int dbsize_;
+    int rsetsize_;
+    int wsetsize_;
+    double txn_time_;
+    int clusters_;
+    double theta_;
+    int hotsetsize_;
+    int hotpartition_;
+    int hotdatasize_;
+    int reshotsize_;
+    int residual_;
+    int hotpct_;
+    double shift_period_;
+    int warehouses_;
+    int neworder_pct_;
+    string trace_;
+
+    double duration_;
+    string arrival_;
+    int active_txns_;
+    vector<double> rates_;
+    int clients_;
+    vector<CCMode> modes_;
+    vector<int> threads_;
+    int reps_;
+
+    string format_;
+    string output_;
+    string record_;
+    string graphs_;
+    bool perf_;
+};
+
+// Name of 'mode' as spelled in specs ("STRIFE_LM"), and back.
+const char* ModeName(CCMode mode);
+bool ParseMode(const string& name, CCMode* mode);
+
+// Mean, sample standard deviation and half width of the 95% confidence
+// interval (Student's t) of a set of samples.
+struct BenchSummary
+{
+    BenchSummary() : mean_(0), stddev_(0), ci95_(0) {}
+    double mean_;
+    double stddev_;
+    double ci95_;
+};
+
+BenchSummary Summarize(const vector<double>& samples);
+
+// Outcome of all the runs of one (mode, threads, rate) point.
+struct BenchResult
+{
+    BenchResult() : mode_(SERIAL), threads_(0), offered_rate_(0), partition_txns_(0) {}
+    CCMode mode_;
+    int threads_;
+    double offered_rate_;        // txns per second (0 for closed loop)
+    vector<double> throughput_;  // txns per second of every run
+    Histogram latency_;          // end to end CycleClock ticks of every txn
+
+    // Hardware counters of all the runs (spec perf=1, STRIFE modes).
+    uint64 partition_txns_;                                  // txns partitioned
+    PerfSample partition_events_[NUM_PARTITION_PHASES];      // by PartitionBatch phase
+    ExecutorPerfStats executor_;
+};
+
+// Runs the spec's reps at one point ('rate' is ignored in closed loop).
+BenchResult RunBenchmark(const BenchSpec& spec, CCMode mode, int threads, double rate = 0);
+
+// Writes the results in the spec's format.
+void WriteResults(const BenchSpec& spec, const vector<BenchResult>& results, std::ostream& out);
+
+#endif  // _BENCHMARK_H_
@@ -0,0 +1,140 @@
+#include "txn/benchmark.h"
+
+#include <stdio.h>
+
+#include <fstream>
+#include <sstream>
+
+#include "utils/testing.h"
+
+TEST(BenchSpec_Settings)
+{
+    BenchSpec spec;
+    string error;
+    EXPECT_TRUE(spec.Set("workload=hot", &error));
+    EXPECT_TRUE(spec.Set("dbsize=5000", &error));
+    EXPECT_TRUE(spec.Set("modes=STRIFE_LM,MVCC", &error));
+    EXPECT_TRUE(spec.Set("threads=2,4,8", &error));
+    EXPECT_EQ(5000, spec.dbsize_);
+    EXPECT_EQ(2, (int)spec.modes_.size());
+    EXPECT_EQ(MVCC, spec.modes_[1]);
+    EXPECT_EQ(3, (int)spec.threads_.size());
+
+    EXPECT_FALSE(spec.Set("dbsize=12x", &error));
+    EXPECT_FALSE(spec.Set("modes=STRIFE_X", &error));
+    EXPECT_FALSE(spec.Set("format=xml", &error));
+    EXPECT_FALSE(spec.Set("colour=red", &error));
+    EXPECT_FALSE(spec.Set("reps", &error));
+    EXPECT_FALSE(spec.Set("arrival=bursty", &error));
+    EXPECT_FALSE(spec.Set("rates=100,-5", &error));
+    EXPECT_TRUE(spec.Set("arrival=poisson", &error));
+    EXPECT_TRUE(spec.Set("rates=100,2e3", &error));
+    EXPECT_EQ(2000, spec.rates_[1]);
+    EXPECT_EQ(5000, spec.dbsize_);
+    END;
+}
+
+TEST(BenchSpec_File)
+{
+    string path = "/tmp/benchmark_test.spec";
+    {
+        std::ofstream out(path.c_str());
+        out << "# sweep\n"
+            << "workload=par   # clustered\n"
+            << "\n"
+            << "  clusters=4\n"
+            << "reps=5\n";
+    }
+    BenchSpec spec;
+    string error;
+    EXPECT_TRUE(spec.Load(path, &error));
+    EXPECT_EQ("par", spec.workload_);
+    EXPECT_EQ(4, spec.clusters_);
+    EXPECT_EQ(5, spec.reps_);
+
+    {
+        std::ofstream out(path.c_str());
+        out << "reps=2\nbogus\n";
+    }
+    EXPECT_FALSE(spec.Load(path, &error));
+    EXPECT_TRUE(error.find(":2:") != string::npos);
+    remove(path.c_str());
+    END;
+}
+
+TEST(BenchSummary_ConfidenceInterval)
+{
+    vector<double> samples;
+    samples.push_back(10);
+    samples.push_back(12);
+    samples.push_back(14);
+    BenchSummary summary = Summarize(samples);
+    EXPECT_EQ(12, summary.mean_);
+    EXPECT_EQ(2, summary.stddev_);
+    // t(0.975, 2) * 2 / sqrt(3)
+    EXPECT_TRUE(summary.ci95_ > 4.96 && summary.ci95_ < 4.97);
+
+    samples.resize(1);
+    EXPECT_EQ(0, Summarize(samples).ci95_);
+    END;
+}
+
+TEST(Benchmark_Run)
+{
+    BenchSpec spec;
+    string error;
+    EXPECT_TRUE(spec.Set("dbsize=1000", &error));
+    EXPECT_TRUE(spec.Set("wsetsize=2", &error));
+    EXPECT_TRUE(spec.Set("txn_time=0", &error));
+    EXPECT_TRUE(spec.Set("duration=0.05", &error));
+    EXPECT_TRUE(spec.Set("reps=2", &error));
+
+    vector<BenchResult> results;
+    results.push_back(RunBenchmark(spec, SERIAL, 2));
+    EXPECT_EQ(2, (int)results[0].throughput_.size());
+    EXPECT_TRUE(results[0].throughput_[0] > 0);
+    EXPECT_TRUE(results[0].latency_.Count() > 0);
+
+    std::ostringstream csv;
+    WriteResults(spec, results, csv);
+    EXPECT_TRUE(csv.str().find("\nrmw,SERIAL,2,closed,0.0,2,") != string::npos);
+
+    EXPECT_TRUE(spec.Set("format=json", &error));
+    std::ostringstream json;
+    WriteResults(spec, results, json);
+    EXPECT_TRUE(json.str().find("\"mode\": \"SERIAL\"") != string::npos);
+    END;
+}
+
+TEST(Benchmark_OpenLoop)
+{
+    BenchSpec spec;
+    string error;
+    EXPECT_TRUE(spec.Set("dbsize=1000", &error));
+    EXPECT_TRUE(spec.Set("wsetsize=2", &error));
+    EXPECT_TRUE(spec.Set("txn_time=0", &error));
+    EXPECT_TRUE(spec.Set("duration=0.2", &error));
+    EXPECT_TRUE(spec.Set("reps=1", &error));
+    EXPECT_TRUE(spec.Set("clients=2", &error));
+
+    // Far below capacity, the processor keeps up with the offered load.
+    const char* arrivals[] = {"arrival=constant", "arrival=poisson"};
+    for (int i = 0; i < 2; i++)
+    {
+        EXPECT_TRUE(spec.Set(arrivals[i], &error));
+        BenchResult result = RunBenchmark(spec, SERIAL, 2, 2000);
+        EXPECT_EQ(2000, result.offered_rate_);
+        EXPECT_TRUE(result.latency_.Count() > 250 && result.latency_.Count() < 550);
+        EXPECT_TRUE(result.throughput_[0] > 1000 && result.throughput_[0] < 3000);
+    }
+    END;
+}
+
+int main(int argc, char** argv)
+{
+    BenchSpec_Settings();
+    BenchSpec_File();
+    BenchSummary_ConfidenceInterval();
+    Benchmark_Run();
+    Benchmark_OpenLoop();
+}
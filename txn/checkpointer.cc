@@ -0,0 +1,183 @@
+#include "txn/checkpointer.h"
+
+#include <stdio.h>
+#include <unistd.h>
+#include <vector>
+
+using std::vector;
+
+static const uint32 kImageMagic   = 0x53545243;  // "STRC"
+static const uint32 kImageVersion = 1;
+
+struct ImageHeader
+{
+    uint32 magic_;
+    uint32 version_;
+    uint64 batch_id_;
+    uint64 num_records_;
+    uint64 checksum_;
+};
+
+// FNV-1a over the records of the image.
+static inline void AddChecksum(uint64* h, Key key, Value value)
+{
+    uint64 words[2] = {key, value};
+    const uint8* p  = reinterpret_cast<const uint8*>(words);
+    for (size_t i = 0; i < sizeof(words); ++i)
+    {
+        *h ^= p[i];
+        *h *= 1099511628211ull;
+    }
+}
+
+Checkpointer::Checkpointer(Storage* storage, const string& path, double interval, uint64 keys_per_ms)
+    : storage_(storage),
+      path_(path),
+      interval_(interval),
+      keys_per_ms_(keys_per_ms),
+      last_start_(0),
+      pending_(false),
+      stopped_(false),
+      pending_batch_id_(0),
+      num_checkpoints_(0),
+      last_batch_id_(0)
+{
+    pthread_create(&thread_, NULL, RunThread, reinterpret_cast<void*>(this));
+}
+
+Checkpointer::~Checkpointer()
+{
+    mutex_.Lock();
+    stopped_ = true;
+    cond_.notify_all();
+    mutex_.Unlock();
+    pthread_join(thread_, NULL);
+}
+
+bool Checkpointer::MaybeStart(uint64 batch_id)
+{
+    double now = GetTime();
+    if (now - last_start_ < interval_) return false;
+
+    mutex_.Lock();
+    if (pending_)
+    {
+        mutex_.Unlock();
+        return false;
+    }
+    // No txn is running, so this fixes a transaction consistent image.
+    storage_->BeginCheckpoint();
+    pending_          = true;
+    pending_batch_id_ = batch_id;
+    last_start_       = now;
+    cond_.notify_all();
+    mutex_.Unlock();
+    return true;
+}
+
+void Checkpointer::Wait()
+{
+    mutex_.Lock();
+    while (pending_) cond_.wait(mutex_);
+    mutex_.Unlock();
+}
+
+uint64 Checkpointer::NumCheckpoints()
+{
+    mutex_.Lock();
+    uint64 n = num_checkpoints_;
+    mutex_.Unlock();
+    return n;
+}
+
+uint64 Checkpointer::LastBatchId()
+{
+    mutex_.Lock();
+    uint64 id = last_batch_id_;
+    mutex_.Unlock();
+    return id;
+}
+
+void* Checkpointer::RunThread(void* arg)
+{
+    Checkpointer* cp = reinterpret_cast<Checkpointer*>(arg);
+    cp->mutex_.Lock();
+    while (true)
+    {
+        // A pending checkpoint is always finished, even when stopping.
+        while (!cp->pending_ && !cp->stopped_) cp->cond_.wait(cp->mutex_);
+        if (!cp->pending_) break;
+
+        uint64 batch_id = cp->pending_batch_id_;
+        cp->mutex_.Unlock();
+        cp->WriteImage(batch_id);
+        cp->mutex_.Lock();
+
+        cp->pending_       = false;
+        cp->last_batch_id_ = batch_id;
+        ++cp->num_checkpoints_;
+        cp->cond_.notify_all();
+    }
+    cp->mutex_.Unlock();
+    return NULL;
+}
+
+void Checkpointer::WriteImage(uint64 batch_id)
+{
+    string tmp_path = path_ + ".tmp";
+    FILE* file      = fopen(tmp_path.c_str(), "wb");
+    if (file == nullptr) DIE("Can't open checkpoint " << tmp_path);
+
+    ImageHeader header = {kImageMagic, kImageVersion, batch_id, 0, 14695981039346656037ull};
+    fwrite(&header, sizeof(header), 1, file);
+
+    double start = GetTime();
+    bool failed  = false;
+    storage_->ScanCheckpoint([&](Key key, Value value) {
+        uint64 record[2] = {key, value};
+        failed |= fwrite(record, sizeof(record), 1, file) != 1;
+        AddChecksum(&header.checksum_, key, value);
+        ++header.num_records_;
+
+        // Throttle: sleep whenever the copy runs ahead of 'keys_per_ms_'.
+        if (keys_per_ms_ != 0 && header.num_records_ % 1024 == 0)
+        {
+            double ahead = header.num_records_ / (keys_per_ms_ * 1000.0) - (GetTime() - start);
+            if (ahead > 0) Sleep(ahead);
+        }
+    });
+    storage_->EndCheckpoint();
+
+    fseek(file, 0, SEEK_SET);
+    failed |= fwrite(&header, sizeof(header), 1, file) != 1;
+    failed |= fflush(file) != 0;
+    failed |= fsync(fileno(file)) != 0;
+    fclose(file);
+    if (failed || rename(tmp_path.c_str(), path_.c_str()) != 0) DIE("Checkpoint write failed: " << tmp_path);
+}
+
+bool Checkpointer::Load(const string& path, Storage* storage, uint64* batch_id)
+{
+    FILE* file = fopen(path.c_str(), "rb");
+    if (file == nullptr) return false;
+
+    ImageHeader header;
+    vector<uint64> records;
+    bool ok = fread(&header, sizeof(header), 1, file) == 1 && header.magic_ == kImageMagic &&
+              header.version_ == kImageVersion;
+    if (ok)
+    {
+        records.resize(2 * header.num_records_);
+        ok = header.num_records_ == 0 || fread(&records[0], sizeof(uint64), records.size(), file) == records.size();
+    }
+    fclose(file);
+    if (!ok) return false;
+
+    uint64 checksum = 14695981039346656037ull;
+    for (size_t i = 0; i < records.size(); i += 2) AddChecksum(&checksum, records[i], records[i + 1]);
+    if (checksum != header.checksum_) return false;
+
+    for (size_t i = 0; i < records.size(); i += 2) storage->Write(records[i], records[i + 1], 0);
+    *batch_id = header.batch_id_;
+    return true;
+}
@@ -0,0 +1,75 @@
+// Asynchronous checkpoints of a Storage. The image is fixed at a STRIFE batch
+// boundary, while no txn is executing, and then copied by a background thread
+// while the executors keep running: records overwritten before they are copied
+// keep their pre-image in the storage (copy-on-write). The copy is rate limited
+// so it doesn't compete with the executor threads for memory bandwidth.
+//
+// Images are written to '<path>.tmp', synced and renamed over 'path', so 'path'
+// always holds the last complete checkpoint. Together with the command log, an
+// image taken after batch N is recovered by loading it and replaying the
+// batches after N.
+
+#ifndef _CHECKPOINTER_H_
+#define _CHECKPOINTER_H_
+
+#include <pthread.h>
+#include <string>
+
+#include "txn/common.h"
+#include "txn/storage.h"
+#include "utils/global.h"
+#include "utils/mutex.h"
+
+using std::string;
+
+class Checkpointer
+{
+   public:
+    // 'interval' is the minimum time between the starts of two checkpoints in
+    // seconds, 'keys_per_ms' limits the copy rate (0 means no limit).
+    Checkpointer(Storage* storage, const string& path, double interval, uint64 keys_per_ms);
+
+    // Finishes the running checkpoint and stops the background thread.
+    ~Checkpointer();
+
+    // Called at a batch boundary, while no txn is executing, with the id of the
+    // last batch whose writes are complete. Starts a checkpoint unless one is
+    // still being written or 'interval' hasn't elapsed. Returns true if started.
+    bool MaybeStart(uint64 batch_id);
+
+    // Blocks until the running checkpoint (if any) is on disk.
+    void Wait();
+
+    uint64 NumCheckpoints();
+    // Batch id of the last complete checkpoint.
+    uint64 LastBatchId();
+
+    // Loads the image at 'path' into '*storage' and sets '*batch_id' to the
+    // batch it was taken after. Returns false if there's no valid image.
+    static bool Load(const string& path, Storage* storage, uint64* batch_id);
+
+   private:
+    static void* RunThread(void* arg);
+    void WriteImage(uint64 batch_id);
+
+    Storage* storage_;
+    string path_;
+    double interval_;
+    uint64 keys_per_ms_;
+    double last_start_;
+
+    // Guards everything below; 'cond_' signals start/finish of a checkpoint.
+    Mutex mutex_;
+    CondVariable cond_;
+    bool pending_;  // a checkpoint was begun and is waiting for/being copied
+    bool stopped_;
+    uint64 pending_batch_id_;
+    uint64 num_checkpoints_;
+    uint64 last_batch_id_;
+
+    pthread_t thread_;
+
+    DISALLOW_CLASS_COPY_AND_ASSIGN(Checkpointer);
+};
+
+#endif  // _CHECKPOINTER_H_
@@ -0,0 +1,125 @@
+#include "txn/checkpointer.h"
+
+#include <stdio.h>
+#include <unistd.h>
+#include <string>
+
+#include "txn/command_log.h"
+#include "txn/load_generator.h"
+#include "txn/txn_processor.h"
+#include "utils/testing.h"
+
+// Writes that race with the copy must not leak into the image.
+TEST(StorageCheckpointPreImages)
+{
+    Storage storage;
+    for (Key k = 0; k < 100; k++) storage.Write(k, k, 0);
+
+    storage.BeginCheckpoint();
+    for (Key k = 0; k < 100; k += 2) storage.Write(k, k + 1000, 1);
+    storage.Write(500, 500, 1);
+
+    map<Key, Value> image;
+    storage.ScanCheckpoint([&](Key key, Value value) { image[key] = value; });
+    storage.EndCheckpoint();
+
+    EXPECT_EQ(100, image.size());
+    int mismatches = 0;
+    for (Key k = 0; k < 100; k++)
+        if (image[k] != k) ++mismatches;
+    EXPECT_EQ(0, mismatches);
+
+    // Writes after the checkpoint are visible to the next one.
+    storage.BeginCheckpoint();
+    image.clear();
+    storage.ScanCheckpoint([&](Key key, Value value) { image[key] = value; });
+    storage.EndCheckpoint();
+    EXPECT_EQ(101, image.size());
+    EXPECT_EQ(1002, image[2]);
+    END;
+}
+
+TEST(CheckpointerWriteLoad)
+{
+    string path = "/tmp/strife_checkpoint_test." + IntToString(getpid());
+    Storage storage;
+    for (Key k = 0; k < 5000; k++) storage.Write(k, 3 * k, 0);
+    {
+        Checkpointer cp(&storage, path, 0, 0);
+        EXPECT_TRUE(cp.MaybeStart(7));
+        for (Key k = 0; k < 5000; k++) storage.Write(k, 0, 1);
+        cp.Wait();
+        EXPECT_EQ(1, cp.NumCheckpoints());
+        EXPECT_EQ(7, cp.LastBatchId());
+    }
+
+    Storage loaded;
+    uint64 batch_id = 0;
+    EXPECT_TRUE(Checkpointer::Load(path, &loaded, &batch_id));
+    EXPECT_EQ(7, batch_id);
+    Value value;
+    int mismatches = 0;
+    for (Key k = 0; k < 5000; k++)
+        if (!loaded.Read(k, &value) || value != 3 * k) ++mismatches;
+    EXPECT_EQ(0, mismatches);
+
+    // A corrupt image is rejected.
+    FILE* file = fopen(path.c_str(), "r+b");
+    fseek(file, -1, SEEK_END);
+    fputc(0x7f, file);
+    fclose(file);
+    EXPECT_FALSE(Checkpointer::Load(path, &loaded, &batch_id));
+
+    unlink(path.c_str());
+    END;
+}
+
+// Recovers a STRIFE run from its last checkpoint plus the command log tail.
+TEST(CheckpointRecoverySTRIFE)
+{
+    string log_path = "/tmp/strife_checkpoint_log_test." + IntToString(getpid());
+    string cp_path  = "/tmp/strife_checkpoint_image_test." + IntToString(getpid());
+    TxnProcessorOptions options;
+    options.command_log_path_    = log_path;
+    options.checkpoint_path_     = cp_path;
+    options.checkpoint_interval_ = 0;
+    options.checkpoint_rate_     = 0;
+
+    map<Key, Value> expected;
+    uint64 num_txns = 2000;
+    {
+        TxnProcessor p(STRIFE_S, options);
+        RMWLoadGenHot lg(1000000, 0, 5, 0, 20, 4, 5, 10, 5);
+        for (uint64 i = 0; i < num_txns; i++) p.NewTxnRequest(lg.NewTxn());
+        for (uint64 i = 0; i < num_txns; i++)
+        {
+            Txn* txn = p.GetTxnResult();
+            for (KeySet::const_iterator it = txn->writeset_.begin(); it != txn->writeset_.end(); ++it) expected[*it]++;
+            delete txn;
+        }
+    }
+
+    Storage storage;
+    storage.InitStorage();
+    uint64 batch_id = 0;
+    EXPECT_TRUE(Checkpointer::Load(cp_path, &storage, &batch_id));
+    CommandLogReplayer replayer(log_path);
+    replayer.Replay(&storage, batch_id);
+
+    Value value;
+    int mismatches = 0;
+    for (map<Key, Value>::iterator it = expected.begin(); it != expected.end(); ++it)
+        if (!storage.Read(it->first, &value) || value != it->second) ++mismatches;
+    EXPECT_EQ(0, mismatches);
+
+    unlink(log_path.c_str());
+    unlink(cp_path.c_str());
+    END;
+}
+
+int main(int argc, char** argv)
+{
+    StorageCheckpointPreImages();
+    CheckpointerWriteLoad();
+    CheckpointRecoverySTRIFE();
+}
@@ -1,19 +1,22 @@
 #include "txn/clusterer.h"
 #include <stdlib.h>
 #include <string.h>
+#include <algorithm>
+#include <map>
+#include "utils/cycle_clock.h"
 
 
 // TODO: heavy STL container use, mempool allocator maybe needed to improve performance (Haoran Zhou)
 
 
 ClustererBase::ClustererBase() :
-        data_pool_counter_(0), txn_pool_counter_(0), uf_(GetUnionFind())
+        data_pool_counter_(0), txn_pool_counter_(0), uf_(GetUnionFind()), merges_(0), perf_(false), graphs_(nullptr)
 {
     Init();
 }
 
 ClustererBase::ClustererBase(const ClustererOptions &config) :
-        config_(config), data_pool_counter_(0), txn_pool_counter_(0), uf_(GetUnionFind())
+        config_(config), data_pool_counter_(0), txn_pool_counter_(0), uf_(GetUnionFind()), merges_(0), perf_(false), graphs_(nullptr)
 {
     Init();
 }
@@ -50,15 +53,85 @@ size_t ClustererBase::PartitionBatch(AtomicQueue<Txn*> &txn_requests,
     DB_ASSERT(worklist.Size() == 0);
     DB_ASSERT(residuals.Size() == 0);
     DB_ASSERT((size_t)txn_requests.Size() <= config_.max_txn_per_batch_);
+    uint64 cycles[NUM_PARTITION_PHASES + 1];
+    PerfSample events[NUM_PARTITION_PHASES + 1];
+    // marks the start of phase i (the end of them all for NUM_PARTITION_PHASES)
+    auto mark = [&](int i) {
+        if (perf_) events[i] = PerfCounters::ThreadLocal().Read();
+        cycles[i] = CycleClock::Now();
+    };
+    mark(PHASE_PREPARE);
     Prepare(txn_requests);
+    mark(PHASE_SPOT);
     Spot();
+    mark(PHASE_FUSE);
     Fuse();
+    mark(PHASE_MERGE);
+    // the exports aren't timed: marking the phase again restarts it after them
+    if (graphs_ != nullptr)
+    {
+        CaptureFuse();
+        mark(PHASE_MERGE);
+    }
     Merge();
+    mark(PHASE_ALLOCATE);
     Allocate(worklist, residuals);
+    mark(PHASE_CLEANUP);
+    if (graphs_ != nullptr)
+    {
+        CaptureAllocation(worklist);
+        graphs_->Write(graph_);
+        mark(PHASE_CLEANUP);
+    }
+
+    // the pools are reset by CleanUp, so count and stamp the txns before it
+    size_t txns = txn_pool_counter_;
+    for (size_t i = 0; i < txns; ++i)
+        txn_pool_[i].txn_->stage_time_[TXN_PARTITIONED] = cycles[PHASE_CLEANUP];
+    size_t data_nodes = data_pool_counter_;
+    size_t special_clusters = special_list_.size();
     CleanUp();
+    mark(NUM_PARTITION_PHASES);
+
+    stats_mutex_.Lock();
+    ++stats_.batches_;
+    for (int i = 0; i < NUM_PARTITION_PHASES; ++i)
+    {
+        stats_.phase_cycles_[i].Record(cycles[i + 1] - cycles[i]);
+        if (perf_) stats_.phase_events_[i] += events[i + 1] - events[i];
+    }
+    stats_.txns_.Record(txns);
+    stats_.data_nodes_.Record(data_nodes);
+    stats_.special_clusters_.Record(special_clusters);
+    stats_.merges_.Record(merges_);
+    stats_.clusters_.Record(worklist.Size());
+    stats_.residuals_.Record(residuals.Size());
+    stats_mutex_.Unlock();
     return worklist.Size();
 }
 
+PartitionStats ClustererBase::Stats()
+{
+    stats_mutex_.Lock();
+    PartitionStats stats = stats_;
+    stats_mutex_.Unlock();
+    return stats;
+}
+
+const char* PartitionPhaseToString(PartitionPhase phase)
+{
+    switch (phase)
+    {
+        case PHASE_PREPARE:  return "prepare";
+        case PHASE_SPOT:     return "spot";
+        case PHASE_FUSE:     return "fuse";
+        case PHASE_MERGE:    return "merge";
+        case PHASE_ALLOCATE: return "allocate";
+        case PHASE_CLEANUP:  return "cleanup";
+        default:             return "unknown";
+    }
+}
+
 void ClustererBase::InitDataNode(size_t size) 
 {
     special_id_thresh_ = config_.max_data_items_ * 2;  // start from two timces the total data nodes, so it won't collide with normal data id
@@ -125,7 +198,8 @@ void ClustererBase::CleanUp()
 void ClustererBase::Spot()
 {
     size_t i = 0;
-    for (size_t j = 0; j < txn_pool_counter_; ++j) 
+    // count_ only has room for strife_k_ special clusters
+    for (size_t j = 0; j < txn_pool_counter_ && i < config_.strife_k_; ++j) 
     
     // for (size_t j = 0; j < config_.strife_k_; ++j) 
     {
@@ -165,6 +239,7 @@ void ClustererBase::Merge()
 {
     std::list<DataNode*>::iterator iter = special_list_.begin();
     std::list<DataNode*>::iterator iter2 = special_list_.begin();
+    merges_ = 0;
     // std::cout << "special list size " << special_list_.size() << "\n";
     for (; iter != special_list_.end(); ++iter)
     {
@@ -177,7 +252,9 @@ void ClustererBase::Merge()
                 DB_ASSERT(*iter2);
                 DB_ASSERT((*iter)->parent_);
                 DB_ASSERT((*iter2)->parent_);
-                uf_->Union(*iter, *iter2, true);
+                bool linked;
+                uf_->Union(*iter, *iter2, true, &linked);
+                if (linked) ++merges_;
             }
             // if (n1 >= 1) {
             //     std::cout << "Union" << std::endl;
@@ -188,6 +265,95 @@ void ClustererBase::Merge()
 }
 
 
+void ClustererBase::CaptureFuse()
+{
+    graph_.batch_id_ = stats_.batches_;  // only this thread updates it
+    graph_.k_ = config_.strife_k_;
+    graph_.alpha_ = config_.strife_alpha_;
+
+    // Spot numbered the specials in the order it listed them
+    graph_.specials_.clear();
+    std::list<DataNode*>::iterator iter = special_list_.begin();
+    for (; iter != special_list_.end(); ++iter)
+    {
+        DB_ASSERT((size_t)(*iter)->cluster_id_ == graph_.specials_.size());
+        BatchGraph::Special special;
+        special.key_ = (*iter)->key_;
+        special.count_ = (*iter)->count_;
+        graph_.specials_.push_back(special);
+    }
+
+    map<DataNode*, uint32> others;  // roots of the other clusters, numbered after the specials
+    graph_.txns_.resize(txn_pool_counter_);
+    for (size_t i = 0; i < txn_pool_counter_; ++i)
+    {
+        BatchGraph::TxnEntry &entry = graph_.txns_[i];
+        KeySet *write_set = &txn_pool_[i].txn_->writeset_;
+        // KeySet keeps its keys sorted, which Encode relies on to store deltas
+        entry.keys_.assign(write_set->begin(), write_set->end());
+        DB_ASSERT(std::is_sorted(entry.keys_.begin(), entry.keys_.end()));
+        entry.clusters_.clear();
+        entry.queue_ = -1;
+
+        set<DataNode*> clusters;
+        FindForAllData(&txn_pool_[i], clusters);
+        set<DataNode*>::iterator iter2 = clusters.begin();
+        for (; iter2 != clusters.end(); ++iter2)
+        {
+            if ((*iter2)->special_)
+            {
+                entry.clusters_.push_back((*iter2)->cluster_id_);
+                continue;
+            }
+            map<DataNode*, uint32>::iterator other = others.find(*iter2);
+            if (other == others.end())
+                other = others.insert(std::make_pair(*iter2, (uint32)(graph_.specials_.size() + others.size()))).first;
+            entry.clusters_.push_back(other->second);
+        }
+        std::sort(entry.clusters_.begin(), entry.clusters_.end());
+    }
+
+    // count_ is symmetric, Merge decides on both orders alike
+    graph_.merges_.clear();
+    for (size_t a = 0; a < graph_.specials_.size(); ++a)
+    {
+        for (size_t b = a + 1; b < graph_.specials_.size(); ++b)
+        {
+            BatchGraph::MergeCandidate candidate;
+            candidate.a_ = a;
+            candidate.b_ = b;
+            candidate.cross_ = count_[Idx2Offset(a, b)];
+            if (candidate.cross_ > 0) graph_.merges_.push_back(candidate);
+        }
+    }
+}
+
+void ClustererBase::CaptureAllocation(AtomicQueue<AtomicQueue<Txn*>*> &worklist)
+{
+    map<Txn*, int> queue_of;
+    int queues = worklist.Size();
+    for (int q = 0; q < queues; ++q)
+    {
+        AtomicQueue<Txn*> *queue;
+        worklist.Pop(&queue);
+        int txns = queue->Size();
+        for (int j = 0; j < txns; ++j)
+        {
+            Txn *txn;
+            queue->Pop(&txn);
+            queue_of[txn] = q;
+            queue->Push(txn);
+        }
+        worklist.Push(queue);
+    }
+    for (size_t i = 0; i < txn_pool_counter_; ++i)
+    {
+        map<Txn*, int>::iterator it = queue_of.find(txn_pool_[i].txn_);
+        graph_.txns_[i].queue_ = it == queue_of.end() ? -1 : it->second;
+    }
+}
+
+
 UnionFindItf* ClustererBase::GetUnionFind()
 {
     // init a concrete UnionFind here
@@ -214,8 +380,8 @@ void ClustererSerial::Prepare(AtomicQueue<Txn*> &txn_requests)
 
         new_txn_node->txn_ = txn;
 
-        set<Key> *write_set = &txn->writeset_;
-        set<Key>::const_iterator iter = write_set->begin();
+        KeySet *write_set = &txn->writeset_;
+        KeySet::const_iterator iter = write_set->begin();
         for (; iter != write_set->end(); ++iter)
         {
             DB_ASSERT(*iter <= config_.max_db_size_);
@@ -333,8 +499,8 @@ void ClustererParallel::Prepare(AtomicQueue<Txn*> &txn_requests)
 void ClustererParallel::PrepareTxn(TxnNode *new_txn_node)
 {
     Txn *txn = new_txn_node->txn_;
-    set<Key> *write_set = &txn->writeset_;
-    set<Key>::const_iterator iter = write_set->begin();
+    KeySet *write_set = &txn->writeset_;
+    KeySet::const_iterator iter = write_set->begin();
 
     // too many critical regions that could be avoided by per thread mempool
 
@@ -4,10 +4,12 @@
 #define _CLUSTERER_H_
 
 #include <list>
+#include "txn/batch_graph.h"
 #include "txn/union_find.h"
 #include "txn/strife_itf.h"
 #include "txn/txn_processor.h"
 #include "utils/global.h"
+#include "utils/mutex.h"
 
 
 // struct for one data node, could also be used to represent a cluster if it is
@@ -68,6 +70,9 @@ public:
 
     virtual ~ClustererBase();
     virtual size_t PartitionBatch(AtomicQueue<Txn*> &txn_requests, AtomicQueue<AtomicQueue<Txn*>*> &worklist, AtomicQueue<Txn*> &residuals);
+    virtual PartitionStats Stats();
+    virtual void EnablePerfCounters() { perf_ = true; };
+    virtual void ExportGraphs(BatchGraphWriter* graphs) { graphs_ = graphs; };
 
 protected:
     void Init();
@@ -83,6 +88,12 @@ protected:
 
     UnionFindItf* GetUnionFind();
 
+    // fill graph_ in for graphs_: the txn-data graph and the clusters as Fuse
+    // left them, then where Allocate put the txns (the worklist is popped and
+    // pushed back in order)
+    void CaptureFuse();
+    void CaptureAllocation(AtomicQueue<AtomicQueue<Txn*>*> &worklist);
+
     virtual void CleanUp();  // clean up for next partition job, probably can be done in another thread!!!
     virtual void Prepare(AtomicQueue<Txn*> &txn_requests) = 0;
     void Spot();
@@ -112,6 +123,13 @@ protected:
     UnionFindItf *uf_;
 
     size_t special_id_thresh_;  // used for setspecial;
+
+    size_t merges_;  // special clusters joined by the last Merge
+    bool perf_;  // sample the hardware counters around the phases
+    BatchGraphWriter* graphs_;  // conflict graph export, nullptr if disabled
+    BatchGraph graph_;  // graph of the batch being partitioned, reused
+    Mutex stats_mutex_;  // guards stats_, which clients read while we partition
+    PartitionStats stats_;
     DISALLOW_CLASS_COPY_AND_ASSIGN(ClustererBase);
 };
 
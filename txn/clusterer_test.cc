@@ -525,6 +525,55 @@ TEST(ClusterLoadGenSerialClustererImprovedHot)
 
 }
 
+TEST(PartitionStatsSerial)
+{
+    Histogram hist;
+    for (uint64 i = 1; i <= 1000; ++i) hist.Record(i);
+    EXPECT_EQ(1000, (int)hist.Count());
+    EXPECT_EQ(1, (int)hist.Min());
+    EXPECT_EQ(1000, (int)hist.Max());
+    EXPECT_TRUE(hist.Percentile(50) >= 500 && hist.Percentile(50) <= 516);
+    EXPECT_TRUE(hist.Percentile(99) >= 990 && hist.Percentile(99) <= 1000);
+    EXPECT_EQ(1000, (int)hist.Percentile(100));
+
+    // same batch as SimpleSerialPartition1: 1,2 | 1,2 | 3,4 | 3,4 | 1,2,3,4
+    set<Key> write_set1, write_set2, write_set_all;
+    write_set1.insert(1);
+    write_set1.insert(2);
+    write_set2.insert(3);
+    write_set2.insert(4);
+    write_set_all = write_set1;
+    write_set_all.insert(3);
+    write_set_all.insert(4);
+    Txn *txns[5] = {new RMW(write_set1), new RMW(write_set1), new RMW(write_set2), new RMW(write_set2),
+                    new RMW(write_set_all)};
+
+    ClustererOptions opt(20, 0.19, 5, 4, 5);
+    ClustererItf *clusterer = new ClustererSerial(opt);
+    EXPECT_EQ(0, (int)clusterer->Stats().batches_);
+
+    AtomicQueue<Txn*> requests;
+    AtomicQueue<AtomicQueue<Txn*>*> worklist;
+    AtomicQueue<Txn*> ret;
+    for (int i = 0; i < 5; ++i) requests.Push(txns[i]);
+    clusterer->PartitionBatch(requests, worklist, ret);
+
+    PartitionStats stats = clusterer->Stats();
+    EXPECT_EQ(1, (int)stats.batches_);
+    EXPECT_EQ(5, (int)stats.txns_.Max());
+    EXPECT_EQ(4, (int)stats.data_nodes_.Max());
+    EXPECT_EQ(worklist.Size(), (int)stats.clusters_.Max());
+    EXPECT_EQ(ret.Size(), (int)stats.residuals_.Max());
+    EXPECT_TRUE(stats.special_clusters_.Max() >= 1);
+    for (int i = 0; i < NUM_PARTITION_PHASES; ++i) EXPECT_EQ(1, (int)stats.phase_cycles_[i].Count());
+
+    AtomicQueue<Txn*>* tmp;
+    while (worklist.Pop(&tmp)) { delete tmp; };
+    delete clusterer;
+    for (int i = 0; i < 5; ++i) delete txns[i];
+    END;
+}
+
 
 int main()
 {
@@ -539,4 +588,5 @@ int main()
     // ClusterLoadGenSerialImproved();
     // ClusterLoadGenSerialClusteredHot();
     // ClusterLoadGenSerialClustererImprovedHot();
+    PartitionStatsSerial();
 }
\ No newline at end of file
@@ -0,0 +1,332 @@
+#include "txn/command_log.h"
+
+#include <unistd.h>
+
+#include <iostream>
+
+#include "txn/clusterer.h"
+#include "txn/tpcc.h"
+#include "txn/txn_types.h"
+
+static const uint32 kBatchMagic = 0x53545242;  // "STRB"
+static const size_t kHeaderSize = 3 * sizeof(uint32);
+
+// FNV-1a over the record body, enough to detect torn writes.
+static uint32 Checksum(const char* data, size_t size)
+{
+    uint32 h = 2166136261u;
+    for (size_t i = 0; i < size; ++i)
+    {
+        h ^= static_cast<uint8>(data[i]);
+        h *= 16777619u;
+    }
+    return h;
+}
+
+void TxnCodec::PutVarint(uint64 v, string* out)
+{
+    while (v >= 0x80)
+    {
+        out->push_back(static_cast<char>(v | 0x80));
+        v >>= 7;
+    }
+    out->push_back(static_cast<char>(v));
+}
+
+bool TxnCodec::GetVarint(const char** pos, const char* end, uint64* v)
+{
+    uint64 result = 0;
+    for (int shift = 0; shift < 64 && *pos < end; shift += 7)
+    {
+        uint8 byte = static_cast<uint8>(**pos);
+        ++(*pos);
+        result |= static_cast<uint64>(byte & 0x7f) << shift;
+        if ((byte & 0x80) == 0)
+        {
+            *v = result;
+            return true;
+        }
+    }
+    return false;
+}
+
+// Sets are sorted, so only the gaps between consecutive keys are stored.
+static void PutKeySet(const KeySet& keys, string* out)
+{
+    TxnCodec::PutVarint(keys.size(), out);
+    Key prev = 0;
+    for (KeySet::const_iterator it = keys.begin(); it != keys.end(); ++it)
+    {
+        TxnCodec::PutVarint(*it - prev, out);
+        prev = *it;
+    }
+}
+
+static bool GetKeySet(const char** pos, const char* end, KeySet* keys)
+{
+    uint64 n, delta;
+    Key prev = 0;
+    if (!TxnCodec::GetVarint(pos, end, &n)) return false;
+    for (uint64 i = 0; i < n; ++i)
+    {
+        if (!TxnCodec::GetVarint(pos, end, &delta)) return false;
+        prev += delta;
+        keys->insert(prev);
+    }
+    return true;
+}
+
+void TxnCodec::Encode(const Txn* txn, string* out)
+{
+    TxnType type = txn->Type();
+    if (type == TXN_UNKNOWN) DIE("Txn type can't be encoded.");
+
+    out->push_back(static_cast<char>(type));
+    PutVarint(txn->unique_id_, out);
+    PutKeySet(txn->readset_, out);
+    PutKeySet(txn->writeset_, out);
+
+    vector<uint64> args;
+    txn->EncodeArgs(&args);
+    PutVarint(args.size(), out);
+    for (size_t i = 0; i < args.size(); ++i) PutVarint(args[i], out);
+}
+
+Txn* TxnCodec::Decode(const char** pos, const char* end)
+{
+    if (*pos >= end) return nullptr;
+    TxnType type = static_cast<TxnType>(static_cast<uint8>(**pos));
+    ++(*pos);
+
+    uint64 unique_id, nargs;
+    KeySet readset, writeset;
+    vector<uint64> args;
+    if (!GetVarint(pos, end, &unique_id) || !GetKeySet(pos, end, &readset) || !GetKeySet(pos, end, &writeset) ||
+        !GetVarint(pos, end, &nargs))
+        return nullptr;
+    args.resize(nargs);
+    for (uint64 i = 0; i < nargs; ++i)
+        if (!GetVarint(pos, end, &args[i])) return nullptr;
+
+    Txn* txn = nullptr;
+    map<Key, Value> m;
+    switch (type)
+    {
+        case TXN_NOOP:
+            txn = new Noop();
+            break;
+        case TXN_EXPECT:
+        case TXN_PUT:
+            if (nargs % 2 != 0) return nullptr;
+            for (uint64 i = 0; i < nargs; i += 2) m[args[i]] = args[i + 1];
+            if (type == TXN_EXPECT)
+                txn = new Expect(m);
+            else
+                txn = new Put(m);
+            break;
+        case TXN_RMW:
+        case TXN_RMW_HOT:
+        case TXN_RMW_PAR:
+            if (nargs != 1) return nullptr;
+            if (type == TXN_RMW)
+                txn = new RMW(readset, writeset, BitsToDouble(args[0]));
+            else if (type == TXN_RMW_HOT)
+                txn = new RMWHot(readset, writeset, BitsToDouble(args[0]));
+            else
+                txn = new RMWPar(readset, writeset, BitsToDouble(args[0]));
+            break;
+        case TXN_TPCC_NEW_ORDER:
+            txn = TpccNewOrder::Decode(args);
+            break;
+        case TXN_TPCC_PAYMENT:
+            txn = TpccPayment::Decode(args);
+            break;
+        default:
+            return nullptr;
+    }
+    if (txn == nullptr) return nullptr;
+    txn->unique_id_ = unique_id;
+    return txn;
+}
+
+CommandLog::CommandLog(const string& path, bool sync)
+    : sync_(sync), next_batch_id_(1), bytes_written_(0), skipped_(0)
+{
+    file_ = fopen(path.c_str(), "wb");
+    if (file_ == nullptr) DIE("Can't open command log " << path);
+}
+
+CommandLog::~CommandLog() { fclose(file_); }
+
+uint64 CommandLog::Take(AtomicQueue<Txn*>& queue)
+{
+    // AtomicQueue can't be iterated, so drain it and push the txns back in order.
+    Txn* txn;
+    drained_.clear();
+    while (queue.Pop(&txn)) drained_.push_back(txn);
+
+    uint64 taken = 0;
+    for (size_t i = 0; i < drained_.size(); ++i)
+    {
+        queue.Push(drained_[i]);
+        if (drained_[i]->Type() == TXN_UNKNOWN)
+        {
+            if (skipped_++ == 0)
+                std::cerr << "Command log: txns of unknown type are not logged and won't be replayed." << std::endl;
+            continue;
+        }
+        txns_.push_back(drained_[i]);
+        ++taken;
+    }
+    return taken;
+}
+
+uint64 CommandLog::LogBatch(AtomicQueue<Txn*>& batch, uint32 flags)
+{
+    txns_.clear();
+    Take(batch);
+    return WriteRecord(flags, 0);
+}
+
+uint64 CommandLog::LogSchedule(AtomicQueue<AtomicQueue<Txn*>*>& worklist, AtomicQueue<Txn*>& residuals, uint32 flags)
+{
+    AtomicQueue<Txn*>* queue;
+    queues_.clear();
+    while (worklist.Pop(&queue)) queues_.push_back(queue);
+
+    txns_.clear();
+    uint64 queued = 0;
+    for (size_t i = 0; i < queues_.size(); ++i)
+    {
+        queued += Take(*queues_[i]);
+        worklist.Push(queues_[i]);
+    }
+    Take(residuals);
+    return WriteRecord(flags | kSchedule, queued);
+}
+
+uint64 CommandLog::WriteRecord(uint32 flags, uint64 queued)
+{
+    uint64 batch_id = next_batch_id_++;
+    body_.clear();
+    TxnCodec::PutVarint(batch_id, &body_);
+    TxnCodec::PutVarint(flags, &body_);
+    TxnCodec::PutVarint(txns_.size(), &body_);
+    if (flags & kSchedule) TxnCodec::PutVarint(queued, &body_);
+    for (size_t i = 0; i < txns_.size(); ++i) TxnCodec::Encode(txns_[i], &body_);
+
+    uint32 header[3] = {kBatchMagic, static_cast<uint32>(body_.size()), Checksum(body_.data(), body_.size())};
+    if (fwrite(header, kHeaderSize, 1, file_) != 1 || fwrite(body_.data(), body_.size(), 1, file_) != 1 ||
+        fflush(file_) != 0)
+        DIE("Command log write failed.");
+    if (sync_) fdatasync(fileno(file_));
+
+    bytes_written_ += kHeaderSize + body_.size();
+    return batch_id;
+}
+
+CommandLogReplayer::CommandLogReplayer(const string& path) : path_(path), last_batch_id_(0), num_txns_(0) {}
+
+void CommandLogReplayer::ExecuteTxn(Txn* txn, Storage* storage)
+{
+    Value result;
+    for (KeySet::const_iterator it = txn->readset_.begin(); it != txn->readset_.end(); ++it)
+        if (storage->Read(*it, &result)) txn->reads_[*it] = result;
+    for (KeySet::const_iterator it = txn->writeset_.begin(); it != txn->writeset_.end(); ++it)
+        if (storage->Read(*it, &result)) txn->reads_[*it] = result;
+
+    txn->Run();
+
+    if (txn->Status() == COMPLETED_C)
+    {
+        for (KeyValueMap::const_iterator it = txn->writes_.begin(); it != txn->writes_.end(); ++it)
+            storage->Write(it->first, it->second, txn->unique_id_);
+        txn->status_ = COMMITTED;
+    }
+    else
+    {
+        txn->status_ = ABORTED;
+    }
+}
+
+uint64 CommandLogReplayer::Replay(Storage* storage, uint64 after_batch)
+{
+    FILE* file = fopen(path_.c_str(), "rb");
+    if (file == nullptr) DIE("Can't open command log " << path_);
+
+    ClustererSerial clusterer;
+    AtomicQueue<Txn*> batch;
+    AtomicQueue<AtomicQueue<Txn*>*> worklist;
+    AtomicQueue<Txn*> residuals;
+    AtomicQueue<Txn*>* current;
+    Txn* txn;
+
+    uint64 replayed = 0;
+    last_batch_id_  = 0;
+    num_txns_       = 0;
+
+    uint32 header[3];
+    string body;
+    while (fread(header, kHeaderSize, 1, file) == 1 && header[0] == kBatchMagic)
+    {
+        body.resize(header[1]);
+        if (header[1] != 0 && fread(&body[0], header[1], 1, file) != 1) break;
+        if (Checksum(body.data(), body.size()) != header[2]) break;
+
+        const char* pos = body.data();
+        const char* end = pos + body.size();
+        uint64 batch_id, flags, num_txns, queued = 0;
+        if (!TxnCodec::GetVarint(&pos, end, &batch_id) || !TxnCodec::GetVarint(&pos, end, &flags) ||
+            !TxnCodec::GetVarint(&pos, end, &num_txns))
+            break;
+        if ((flags & CommandLog::kSchedule) && !TxnCodec::GetVarint(&pos, end, &queued)) break;
+        last_batch_id_ = batch_id;
+        if (batch_id <= after_batch) continue;
+
+        for (uint64 i = 0; i < num_txns; ++i)
+        {
+            txn = TxnCodec::Decode(&pos, end);
+            if (txn == nullptr) DIE("Corrupt txn in batch " << batch_id);
+            if ((flags & CommandLog::kSchedule) && i >= queued)
+                residuals.Push(txn);
+            else
+                batch.Push(txn);
+        }
+
+        // Partitions have disjoint write sets, so running them one after the
+        // other gives the same state as running them in parallel. A logged
+        // schedule runs its queues as they were.
+        if (flags & CommandLog::kSchedule)
+        {
+            while (batch.Pop(&txn))
+            {
+                ExecuteTxn(txn, storage);
+                delete txn;
+            }
+        }
+        else
+        {
+            clusterer.PartitionBatch(batch, worklist, residuals);
+        }
+        while (worklist.Pop(&current))
+        {
+            while (current->Pop(&txn))
+            {
+                ExecuteTxn(txn, storage);
+                delete txn;
+            }
+            delete current;
+        }
+        while (residuals.Pop(&txn))
+        {
+            // Deferred residuals are part of the next batch record.
+            if (!(flags & CommandLog::kDeferResiduals)) ExecuteTxn(txn, storage);
+            delete txn;
+        }
+
+        num_txns_ += num_txns;
+        ++replayed;
+    }
+    fclose(file);
+    return replayed;
+}
@@ -0,0 +1,125 @@
+// Command logging for the STRIFE schedulers. ClustererSerial schedules are a
+// function of the batch content, so logging the ordered input batches (txn
+// type + parameters) is enough to rebuild the database: replay re-runs every
+// batch through ClustererSerial and executes the partitions serially.
+// ClustererParallel fills its queues in whatever order its workers get to the
+// txns, so for it the log holds the schedule instead: the txns of the queues
+// in execution order, then the residuals. Records are much smaller than value
+// logging since no written values and no per-write headers are logged.
+//
+// Txns TxnCodec can't encode (TXN_UNKNOWN) are left out of the records, and
+// so out of the replay.
+
+#ifndef _COMMAND_LOG_H_
+#define _COMMAND_LOG_H_
+
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+#include "txn/common.h"
+#include "txn/storage.h"
+#include "txn/txn.h"
+#include "utils/atomic.h"
+#include "utils/global.h"
+
+using std::string;
+using std::vector;
+
+// Compact binary encoding of txn commands: type, id, delta + varint encoded
+// read/write sets and the type specific arguments.
+class TxnCodec
+{
+   public:
+    // Appends the encoding of '*txn' to '*out'. Dies if the type of the txn
+    // isn't known (Type() returns TXN_UNKNOWN).
+    static void Encode(const Txn* txn, string* out);
+
+    // Decodes the txn at '*pos' and advances '*pos' past it. Returns nullptr
+    // if the encoding is malformed or runs past 'end'. The caller takes
+    // ownership of the returned txn.
+    static Txn* Decode(const char** pos, const char* end);
+
+    static void PutVarint(uint64 v, string* out);
+    static bool GetVarint(const char** pos, const char* end, uint64* v);
+};
+
+// Append-only command log. Each record holds one batch exactly as it was handed
+// to the clusterer, or the schedule the clusterer made of it, so the log must
+// be written before the batch executes.
+class CommandLog
+{
+   public:
+    // Record flags.
+    static const uint32 kDeferResiduals = 1;  // residuals were moved to the next batch (STRIFE_PM)
+    static const uint32 kSchedule       = 2;  // the record holds the schedule (LogSchedule)
+
+    // Creates (truncates) the log at 'path'. If 'sync' is set, every batch is
+    // fdatasync'ed before LogBatch returns.
+    CommandLog(const string& path, bool sync);
+    ~CommandLog();
+
+    // Appends 'batch' as the next batch record and returns its batch id
+    // (starting at 1). The content and order of 'batch' are left unchanged.
+    uint64 LogBatch(AtomicQueue<Txn*>& batch, uint32 flags);
+
+    // Appends the schedule the clusterer made of the next batch: the txns of
+    // the queues of 'worklist' in order, then 'residuals'. Leaves them
+    // unchanged.
+    uint64 LogSchedule(AtomicQueue<AtomicQueue<Txn*>*>& worklist, AtomicQueue<Txn*>& residuals, uint32 flags);
+
+    // Id of the last logged batch, 0 if none.
+    uint64 LastBatchId() { return next_batch_id_ - 1; }
+    // Total bytes appended by this process.
+    uint64 BytesWritten() { return bytes_written_; }
+    // Txns left out because TxnCodec can't encode them.
+    uint64 NumSkipped() { return skipped_; }
+
+   private:
+    // Appends the txns of 'queue' TxnCodec can encode to txns_, and puts them
+    // all back in order. Returns the number appended.
+    uint64 Take(AtomicQueue<Txn*>& queue);
+    // Writes txns_ as the next record; 'queued' leading txns of it ran in
+    // the queues of a kSchedule record.
+    uint64 WriteRecord(uint32 flags, uint64 queued);
+
+    FILE* file_;
+    bool sync_;
+    uint64 next_batch_id_;
+    uint64 bytes_written_;
+    uint64 skipped_;
+
+    // Scratch buffers reused across batches.
+    string body_;
+    vector<Txn*> txns_;
+    vector<Txn*> drained_;
+    vector<AtomicQueue<Txn*>*> queues_;
+
+    DISALLOW_CLASS_COPY_AND_ASSIGN(CommandLog);
+};
+
+// Rebuilds a Storage from a command log. Stops at the first torn or corrupt
+// record (e.g. the tail of a log written by a crashed process).
+class CommandLogReplayer
+{
+   public:
+    explicit CommandLogReplayer(const string& path);
+
+    // Replays every complete batch with id > 'after_batch' into '*storage'.
+    // Returns the number of batches replayed.
+    uint64 Replay(Storage* storage, uint64 after_batch = 0);
+
+    // Stats of the last Replay call.
+    uint64 LastBatchId() { return last_batch_id_; }
+    uint64 NumTxns() { return num_txns_; }
+
+   private:
+    // Executes a txn and applies its writes the same way the STRIFE executors do.
+    void ExecuteTxn(Txn* txn, Storage* storage);
+
+    string path_;
+    uint64 last_batch_id_;
+    uint64 num_txns_;
+};
+
+#endif  // _COMMAND_LOG_H_
@@ -0,0 +1,172 @@
+#include "txn/command_log.h"
+
+#include <stdio.h>
+#include <unistd.h>
+#include <string>
+
+#include "txn/load_generator.h"
+#include "txn/txn_processor.h"
+#include "txn/txn_types.h"
+#include "utils/testing.h"
+
+TEST(TxnCodecRoundTrip)
+{
+    set<Key> readset, writeset;
+    readset.insert(3);
+    readset.insert(700000);
+    writeset.insert(5);
+    writeset.insert(1 << 20);
+    RMW rmw(readset, writeset, 0.0001);
+    rmw.unique_id_ = 42;
+
+    map<Key, Value> m = {{1, 2}, {9, 1000}};
+    Put put(m);
+    put.unique_id_ = 43;
+
+    string buf;
+    TxnCodec::Encode(&rmw, &buf);
+    TxnCodec::Encode(&put, &buf);
+
+    const char* pos = buf.data();
+    const char* end = pos + buf.size();
+    Txn* t1         = TxnCodec::Decode(&pos, end);
+    Txn* t2         = TxnCodec::Decode(&pos, end);
+    EXPECT_TRUE(t1 != nullptr);
+    EXPECT_TRUE(t2 != nullptr);
+    EXPECT_TRUE(pos == end);
+    EXPECT_EQ(TXN_RMW, t1->Type());
+    EXPECT_EQ(42, t1->unique_id_);
+    EXPECT_TRUE(t1->writeset_ == writeset);
+    EXPECT_EQ(TXN_PUT, t2->Type());
+    EXPECT_EQ(43, t2->unique_id_);
+    EXPECT_EQ(2, t2->writeset_.size());
+
+    vector<uint64> args1, args2;
+    rmw.EncodeArgs(&args1);
+    t1->EncodeArgs(&args2);
+    EXPECT_TRUE(args1 == args2);
+
+    // Truncated input is rejected.
+    pos = buf.data();
+    EXPECT_TRUE(TxnCodec::Decode(&pos, buf.data() + 3) == nullptr);
+
+    delete t1;
+    delete t2;
+    END;
+}
+
+// A Put TxnCodec can't encode.
+class UnknownPut : public Put
+{
+   public:
+    explicit UnknownPut(const map<Key, Value>& m) : Put(m) {}
+    virtual TxnType Type() const { return TXN_UNKNOWN; }
+};
+
+// Runs a hot-set workload through STRIFE with command logging enabled, then
+// rebuilds a fresh Storage from the log and checks every written key. STRIFE_P
+// logs the schedules of ClustererParallel rather than the batches.
+TEST(CommandLogReplaySTRIFE)
+{
+    CCMode modes[] = {STRIFE_S, STRIFE_P};
+    for (CCMode mode : modes)
+    {
+        string path = "/tmp/strife_command_log_test." + IntToString(getpid());
+        TxnProcessorOptions options;
+        options.command_log_path_ = path;
+
+        map<Key, Value> expected;
+        uint64 num_txns = 2000;
+        {
+            TxnProcessor p(mode, options);
+            RMWLoadGenHot lg(1000000, 0, 5, 0, 20, 4, 5, 10, 5);
+            for (uint64 i = 0; i < num_txns; i++) p.NewTxnRequest(lg.NewTxn());
+            for (uint64 i = 0; i < num_txns; i++)
+            {
+                Txn* txn = p.GetTxnResult();
+                EXPECT_EQ(COMMITTED, txn->Status());
+                for (KeySet::const_iterator it = txn->writeset_.begin(); it != txn->writeset_.end(); ++it)
+                    expected[*it]++;
+                delete txn;
+            }
+        }
+
+        Storage storage;
+        storage.InitStorage();
+        CommandLogReplayer replayer(path);
+        EXPECT_TRUE(replayer.Replay(&storage) > 0);
+        EXPECT_EQ(num_txns, replayer.NumTxns());
+
+        Value value;
+        int mismatches = 0;
+        for (map<Key, Value>::iterator it = expected.begin(); it != expected.end(); ++it)
+        {
+            if (!storage.Read(it->first, &value) || value != it->second) ++mismatches;
+        }
+        EXPECT_EQ(0, mismatches);
+
+        // Replaying from the last batch on is a no-op.
+        EXPECT_EQ(0, replayer.Replay(&storage, replayer.LastBatchId()));
+
+        unlink(path.c_str());
+    }
+    END;
+}
+
+// Logged schedules replay in their queue order, residuals last, and txns of
+// unknown type are left out instead of killing the scheduler.
+TEST(CommandLogSchedule)
+{
+    string path = "/tmp/strife_command_log_schedule_test." + IntToString(getpid());
+    AtomicQueue<AtomicQueue<Txn*>*> worklist;
+    AtomicQueue<Txn*> residuals;
+    AtomicQueue<Txn*>* queue = new AtomicQueue<Txn*>();
+    Txn* txn;
+    {
+        CommandLog log(path, false);
+        queue->Push(new Put(map<Key, Value>{{1, 5}}));
+        queue->Push(new Put(map<Key, Value>{{1, 7}}));
+        worklist.Push(queue);
+        residuals.Push(new Put(map<Key, Value>{{2, 3}}));
+        residuals.Push(new UnknownPut(map<Key, Value>{{2, 4}}));
+        uint64 batch_id = log.LogSchedule(worklist, residuals, 0);
+        EXPECT_EQ(1, batch_id);
+        EXPECT_EQ(1, log.NumSkipped());
+        EXPECT_EQ(1, worklist.Size());
+        EXPECT_EQ(2, queue->Size());
+        EXPECT_EQ(2, residuals.Size());
+        while (queue->Pop(&txn)) delete txn;
+        while (residuals.Pop(&txn)) delete txn;
+
+        // The residual moves to the next batch, which never gets logged.
+        queue->Push(new Put(map<Key, Value>{{1, 9}}));
+        residuals.Push(new Put(map<Key, Value>{{2, 8}}));
+        batch_id = log.LogSchedule(worklist, residuals, CommandLog::kDeferResiduals);
+        EXPECT_EQ(2, batch_id);
+        while (queue->Pop(&txn)) delete txn;
+        while (residuals.Pop(&txn)) delete txn;
+    }
+    worklist.Pop(&queue);
+    delete queue;
+
+    Storage storage;
+    storage.InitStorage();
+    CommandLogReplayer replayer(path);
+    EXPECT_EQ(2, replayer.Replay(&storage));
+    EXPECT_EQ(5, replayer.NumTxns());
+    Value value = 0;
+    EXPECT_TRUE(storage.Read(1, &value));
+    EXPECT_EQ(9, value);
+    EXPECT_TRUE(storage.Read(2, &value));
+    EXPECT_EQ(3, value);
+
+    unlink(path.c_str());
+    END;
+}
+
+int main(int argc, char** argv)
+{
+    TxnCodecRoundTrip();
+    CommandLogReplaySTRIFE();
+    CommandLogSchedule();
+}
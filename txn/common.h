@@ -8,6 +8,7 @@
 #include <unistd.h>
 #include <cstdio>
 #include <cstdlib>
+#include <cstring>
 #include <iostream>
 #include <string>
 #include <utility>
@@ -63,6 +64,22 @@ static inline double RandomDouble(double max)
     return max * (static_cast<double>(rand()) / static_cast<double>(RAND_MAX));
 }
 
+// Reinterprets the bits of a double as an uint64 (and back), used to serialize
+// txn parameters.
+static inline uint64 DoubleToBits(double d)
+{
+    uint64 bits;
+    memcpy(&bits, &d, sizeof(bits));
+    return bits;
+}
+
+static inline double BitsToDouble(uint64 bits)
+{
+    double d;
+    memcpy(&d, &bits, sizeof(d));
+    return d;
+}
+
 // Sleep for 'duration' seconds.
 static inline void Sleep(double duration) { usleep(1000000 * duration); }
 // Returns a human-readable string representation of an int.
@@ -0,0 +1,99 @@
+#include "txn/key_set.h"
+
+#include <algorithm>
+#include <string.h>
+
+KeySet::KeySet(const KeySet& other) : keys_(inline_), size_(0), capacity_(kInline) { *this = other; }
+
+KeySet::KeySet(const set<Key>& keys) : keys_(inline_), size_(0), capacity_(kInline)
+{
+    Reserve(keys.size());
+    for (set<Key>::const_iterator it = keys.begin(); it != keys.end(); ++it) keys_[size_++] = *it;
+}
+
+KeySet& KeySet::operator=(const KeySet& other)
+{
+    if (this == &other) return *this;
+    Reserve(other.size_);
+    memcpy(keys_, other.keys_, other.size_ * sizeof(Key));
+    size_ = other.size_;
+    return *this;
+}
+
+void KeySet::Reserve(uint32 capacity)
+{
+    if (capacity <= capacity_) return;
+    capacity  = std::max(capacity, 2 * capacity_);
+    Key* keys = new Key[capacity];
+    memcpy(keys, keys_, size_ * sizeof(Key));
+    if (keys_ != inline_) delete[] keys_;
+    keys_     = keys;
+    capacity_ = capacity;
+}
+
+uint32 KeySet::insert(Key key)
+{
+    uint32 i = std::lower_bound(keys_, keys_ + size_, key) - keys_;
+    if (i < size_ && keys_[i] == key) return i;
+
+    Reserve(size_ + 1);
+    memmove(keys_ + i + 1, keys_ + i, (size_ - i) * sizeof(Key));
+    keys_[i] = key;
+    ++size_;
+    return i;
+}
+
+int KeySet::IndexOf(Key key) const
+{
+    // Sets are small, a scan beats the branches of a binary search.
+    if (size_ <= 16)
+    {
+        for (uint32 i = 0; i < size_; i++)
+            if (keys_[i] >= key) return keys_[i] == key ? (int)i : -1;
+        return -1;
+    }
+    const Key* it = std::lower_bound(keys_, keys_ + size_, key);
+    return it != keys_ + size_ && *it == key ? (int)(it - keys_) : -1;
+}
+
+bool KeySet::operator==(const KeySet& other) const
+{
+    return size_ == other.size_ && memcmp(keys_, other.keys_, size_ * sizeof(Key)) == 0;
+}
+
+KeyValueMap::KeyValueMap(const KeyValueMap& other) : values_(inline_values_) { *this = other; }
+
+KeyValueMap& KeyValueMap::operator=(const KeyValueMap& other)
+{
+    if (this == &other) return *this;
+    uint32 capacity = keys_.capacity_;
+    keys_           = other.keys_;
+    if (keys_.capacity_ != capacity)
+    {
+        if (values_ != inline_values_) delete[] values_;
+        values_ = new Value[keys_.capacity_];
+    }
+    memcpy(values_, other.values_, keys_.size_ * sizeof(Value));
+    return *this;
+}
+
+Value& KeyValueMap::operator[](Key key)
+{
+    uint32 size = keys_.size_;
+    uint32 i    = std::lower_bound(keys_.keys_, keys_.keys_ + size, key) - keys_.keys_;
+    if (i < size && keys_.keys_[i] == key) return values_[i];
+
+    // Grow the values along with the keys.
+    uint32 capacity = keys_.capacity_;
+    keys_.insert(key);
+    if (keys_.capacity_ != capacity)
+    {
+        Value* values = new Value[keys_.capacity_];
+        memcpy(values, values_, size * sizeof(Value));
+        if (values_ != inline_values_) delete[] values_;
+        values_ = values;
+    }
+    memmove(values_ + i + 1, values_ + i, (size - i) * sizeof(Value));
+    values_[i] = 0;
+    return values_[i];
+}
@@ -0,0 +1,133 @@
+// Flat containers for the read/write sets and the read/write results of a
+// txn. Keys are kept sorted in one array with room for kInline keys inside the
+// object, so the sets of typical txns don't allocate at all and are walked
+// sequentially. The interfaces follow the std::set / std::map subset the txn
+// code uses.
+
+#ifndef _KEY_SET_H_
+#define _KEY_SET_H_
+
+#include <set>
+#include <utility>
+
+#include "txn/common.h"
+
+using std::set;
+
+class KeySet
+{
+   public:
+    typedef const Key* const_iterator;
+    typedef const Key* iterator;
+
+    static const uint32 kInline = 32;
+
+    KeySet() : keys_(inline_), size_(0), capacity_(kInline) {}
+    KeySet(const KeySet& other);
+    KeySet(const set<Key>& keys);
+    ~KeySet()
+    {
+        if (keys_ != inline_) delete[] keys_;
+    }
+    KeySet& operator=(const KeySet& other);
+
+    // Adds 'key' unless present. Returns its position.
+    uint32 insert(Key key);
+
+    // Position of 'key', or -1 if absent.
+    int IndexOf(Key key) const;
+    size_t count(Key key) const { return IndexOf(key) < 0 ? 0 : 1; }
+
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+    // Keeps the storage.
+    void clear() { size_ = 0; }
+
+    const Key* begin() const { return keys_; }
+    const Key* end() const { return keys_ + size_; }
+    Key operator[](uint32 i) const { return keys_[i]; }
+
+    bool operator==(const KeySet& other) const;
+    bool operator!=(const KeySet& other) const { return !(*this == other); }
+
+   private:
+    friend class KeyValueMap;
+
+    // Makes room for at least 'capacity' keys.
+    void Reserve(uint32 capacity);
+
+    Key* keys_;
+    uint32 size_;
+    uint32 capacity_;
+    Key inline_[kInline];
+};
+
+// Sorted keys with a parallel array of values.
+class KeyValueMap
+{
+   public:
+    // Iterates over (key, value) pairs like a const std::map iterator.
+    class const_iterator
+    {
+       public:
+        const_iterator(const KeyValueMap* map, uint32 i) : map_(map), i_(i) { Load(); }
+        const std::pair<Key, Value>& operator*() const { return entry_; }
+        const std::pair<Key, Value>* operator->() const { return &entry_; }
+        const_iterator& operator++()
+        {
+            ++i_;
+            Load();
+            return *this;
+        }
+        bool operator==(const const_iterator& other) const { return i_ == other.i_; }
+        bool operator!=(const const_iterator& other) const { return i_ != other.i_; }
+
+       private:
+        void Load()
+        {
+            if (i_ < map_->keys_.size_) entry_ = std::make_pair(map_->keys_.keys_[i_], map_->values_[i_]);
+        }
+
+        const KeyValueMap* map_;
+        uint32 i_;
+        std::pair<Key, Value> entry_;
+    };
+    typedef const_iterator iterator;
+
+    KeyValueMap() : values_(inline_values_) {}
+    KeyValueMap(const KeyValueMap& other);
+    ~KeyValueMap()
+    {
+        if (values_ != inline_values_) delete[] values_;
+    }
+    KeyValueMap& operator=(const KeyValueMap& other);
+
+    // Value of 'key', inserted as 0 if absent.
+    Value& operator[](Key key);
+
+    // Sets '*value' to the value of 'key' and returns true if present.
+    bool Get(Key key, Value* value) const
+    {
+        int i = keys_.IndexOf(key);
+        if (i < 0) return false;
+        *value = values_[i];
+        return true;
+    }
+    size_t count(Key key) const { return keys_.count(key); }
+
+    size_t size() const { return keys_.size(); }
+    bool empty() const { return keys_.empty(); }
+    void clear() { keys_.clear(); }
+
+    const_iterator begin() const { return const_iterator(this, 0); }
+    const_iterator end() const { return const_iterator(this, keys_.size_); }
+
+    const KeySet& keys() const { return keys_; }
+
+   private:
+    KeySet keys_;
+    Value* values_;
+    Value inline_values_[KeySet::kInline];
+};
+
+#endif  // _KEY_SET_H_
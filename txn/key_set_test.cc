@@ -0,0 +1,100 @@
+#include "txn/key_set.h"
+
+#include <map>
+
+#include "utils/testing.h"
+
+using std::map;
+
+TEST(KeySet_SortedUnique)
+{
+    KeySet keys;
+    EXPECT_TRUE(keys.empty());
+    keys.insert(7);
+    keys.insert(3);
+    keys.insert(9);
+    keys.insert(3);
+    EXPECT_EQ(3, (int)keys.size());
+    EXPECT_EQ(3, keys[0]);
+    EXPECT_EQ(7, keys[1]);
+    EXPECT_EQ(9, keys[2]);
+    EXPECT_EQ(1, (int)keys.count(7));
+    EXPECT_EQ(0, (int)keys.count(8));
+    EXPECT_EQ(-1, keys.IndexOf(10));
+    EXPECT_EQ(2, keys.IndexOf(9));
+
+    set<Key> std_keys;
+    std_keys.insert(9);
+    std_keys.insert(7);
+    std_keys.insert(3);
+    EXPECT_TRUE(keys == KeySet(std_keys));
+    keys.clear();
+    EXPECT_TRUE(keys.empty());
+    END;
+}
+
+TEST(KeySet_Grows)
+{
+    // Past the inline keys, in both directions, with binary searches.
+    KeySet keys;
+    for (Key key = 0; key < 200; key += 2) keys.insert(200 - key);
+    for (Key key = 1; key < 200; key += 2) keys.insert(key);
+    EXPECT_EQ(200, (int)keys.size());
+    Key expected = 1;
+    for (KeySet::const_iterator it = keys.begin(); it != keys.end(); ++it) EXPECT_EQ(expected++, *it);
+    EXPECT_EQ(99, keys.IndexOf(100));
+    EXPECT_EQ(0, (int)keys.count(0));
+
+    KeySet copy(keys);
+    EXPECT_TRUE(copy == keys);
+    copy.insert(1000);
+    EXPECT_TRUE(copy != keys);
+    keys = copy;
+    EXPECT_EQ(201, (int)keys.size());
+    END;
+}
+
+TEST(KeyValueMap_MatchesMap)
+{
+    KeyValueMap values;
+    map<Key, Value> expected;
+    for (int i = 0; i < 500; i++)
+    {
+        Key key = (i * 7919) % 101;
+        values[key] += i;
+        expected[key] += i;
+    }
+    EXPECT_EQ(expected.size(), values.size());
+
+    map<Key, Value>::iterator e = expected.begin();
+    for (KeyValueMap::const_iterator it = values.begin(); it != values.end(); ++it, ++e)
+    {
+        EXPECT_EQ(e->first, it->first);
+        EXPECT_EQ(e->second, it->second);
+    }
+
+    Value value;
+    EXPECT_TRUE(values.Get(5, &value));
+    EXPECT_EQ(expected[5], value);
+    EXPECT_FALSE(values.Get(500, &value));
+
+    // Copies, into inline and grown maps alike.
+    KeyValueMap small;
+    small[1] = 1;
+    KeyValueMap copy(values);
+    small = values;
+    EXPECT_EQ(values.size(), copy.size());
+    EXPECT_EQ(values.size(), small.size());
+    EXPECT_TRUE(small.Get(5, &value));
+    EXPECT_EQ(expected[5], value);
+    values = KeyValueMap();
+    EXPECT_TRUE(values.empty());
+    END;
+}
+
+int main(int argc, char** argv)
+{
+    KeySet_SortedUnique();
+    KeySet_Grows();
+    KeyValueMap_MatchesMap();
+}
@@ -0,0 +1,146 @@
+#include "txn/load_generator.h"
+
+#include <math.h>
+
+ZipfianDistribution::ZipfianDistribution(uint64 n, double theta) : n_(n), theta_(theta)
+{
+    if (n < 1 || theta < 0 || theta >= 1) DIE("Bad Zipfian parameters n " << n << " theta " << theta);
+    alpha_          = 1 / (1 - theta);
+    zetan_          = Zeta(n, theta);
+    eta_            = (1 - pow(2.0 / n, 1 - theta)) / (1 - Zeta(2, theta) / zetan_);
+    half_pow_theta_ = 1 + pow(0.5, theta);
+}
+
+double ZipfianDistribution::Zeta(uint64 n, double theta)
+{
+    double sum = 0;
+    for (uint64 i = 1; i <= n; i++) sum += 1 / pow(static_cast<double>(i), theta);
+    return sum;
+}
+
+uint64 ZipfianDistribution::Next(FastRandom* random) const
+{
+    double u  = random->NextDouble();
+    double uz = u * zetan_;
+    if (uz < 1) return 0;
+    if (uz < half_pow_theta_ && n_ > 1) return 1;
+    uint64 rank = static_cast<uint64>(n_ * pow(eta_ * u - eta_ + 1, alpha_));
+    return rank < n_ ? rank : n_ - 1;
+}
+
+RMW* RMWKeyLoadGen::Fill(RMW* txn) { return FillKeys(txn, wsetsize_, 0); }
+
+RMW* RMWKeyLoadGen::FillKeys(RMW* txn, int wsetsize, Key origin)
+{
+    FastRandom* random = &FastRandom::ThreadLocal();
+    txn->InitKeys(rsetsize_, wsetsize, wait_time_, [this, random, origin]() { return NextKey(random, origin); });
+    return txn;
+}
+
+RMW* LatestLoadGen::Fill(RMW* txn)
+{
+    Key newest = inserts_.fetch_add(1) % dbsize_;
+    if (wsetsize_ == 0) return FillKeys(txn, wsetsize_, newest);
+
+    // The other keys are at least one behind the insert, so never collide with it.
+    FillKeys(txn, wsetsize_ - 1, newest);
+    txn->writeset_.insert(newest);
+    return txn;
+}
+
+Key LatestLoadGen::NextKey(FastRandom* random, Key origin)
+{
+    return (origin + dbsize_ - 1 - zipf_.Next(random)) % dbsize_;
+}
+
+ShiftingHotspotLoadGen::ShiftingHotspotLoadGen(int dbsize, int rsetsize, int wsetsize, int hotsetsize, int hotpct,
+                                               double shift_period, double wait_time)
+    : RMWKeyLoadGen(rsetsize, wsetsize, wait_time),
+      dbsize_(dbsize),
+      hotsetsize_(hotsetsize),
+      hotpct_(hotpct),
+      shift_period_(shift_period),
+      start_(GetTime())
+{
+    if (hotsetsize < 1 || hotsetsize > dbsize) DIE("Bad hot set size " << hotsetsize);
+    // Every key is hot, so the hot set must hold the keys of a whole txn.
+    if (hotpct >= 100 && hotsetsize < rsetsize + wsetsize)
+        DIE("Hot set of " << hotsetsize << " keys can't hold the " << rsetsize + wsetsize << " keys of a txn");
+}
+
+Key ShiftingHotspotLoadGen::HotStart(double now) const
+{
+    uint64 ranges = dbsize_ / hotsetsize_;
+    uint64 epoch  = shift_period_ > 0 ? static_cast<uint64>((now - start_) / shift_period_) : 0;
+    // The epoch, scrambled (splitmix64), picks the range.
+    uint64 z = epoch * 0x9e3779b97f4a7c15ull + 0x9e3779b97f4a7c15ull;
+    z        = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+    z        = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+    z ^= z >> 31;
+    return (z % ranges) * hotsetsize_;
+}
+
+RMW* ShiftingHotspotLoadGen::Fill(RMW* txn) { return FillKeys(txn, wsetsize_, HotStart(GetTime())); }
+
+Key ShiftingHotspotLoadGen::NextKey(FastRandom* random, Key origin)
+{
+    if (static_cast<int>(random->Uniform(100)) < hotpct_) return origin + random->Uniform(hotsetsize_);
+    return random->Uniform(dbsize_);
+}
+
+TpccLoadGen::TpccLoadGen(const TpccLayout& layout, int neworder_pct, double wait_time)
+    : layout_(layout), neworder_pct_(neworder_pct), wait_time_(wait_time)
+{
+    if (layout.Items() < 15) DIE("TPC-C needs at least 15 items, not " << layout.Items());
+    // The run time constants C of NURand.
+    FastRandom random(rand());
+    c_customer_ = random.Uniform(1024);
+    c_item_     = random.Uniform(8192);
+}
+
+Txn* TpccLoadGen::NewTxn()
+{
+    FastRandom* random = &FastRandom::ThreadLocal();
+    if (static_cast<int>(random->Uniform(100)) < neworder_pct_) return NewOrder(random);
+    return Payment(random);
+}
+
+TpccNewOrder* TpccLoadGen::NewOrder(FastRandom* random)
+{
+    int w = random->Uniform(layout_.Warehouses());
+    int d = random->Uniform(layout_.Districts());
+    int c = NURand(random, 1023, c_customer_, layout_.Customers());
+
+    int count = 5 + random->Uniform(11);
+    vector<TpccOrderLine> lines;
+    std::set<int> items;
+    while (static_cast<int>(lines.size()) < count)
+    {
+        int item = NURand(random, 8191, c_item_, layout_.Items());
+        if (!items.insert(item).second) continue;
+        int supply = w;
+        if (layout_.Warehouses() > 1 && random->Uniform(100) == 0) supply = OtherWarehouse(random, w);
+        lines.push_back(TpccOrderLine(layout_.ItemKey(item), layout_.StockKey(supply, item), 1 + random->Uniform(10)));
+    }
+    bool rollback = random->Uniform(100) == 0;
+    return new TpccNewOrder(layout_.WarehouseKey(w), layout_.DistrictKey(w, d), layout_.CustomerKey(w, d, c), lines,
+                            rollback, wait_time_);
+}
+
+TpccPayment* TpccLoadGen::Payment(FastRandom* random)
+{
+    int w = random->Uniform(layout_.Warehouses());
+    int d = random->Uniform(layout_.Districts());
+    int c = NURand(random, 1023, c_customer_, layout_.Customers());
+
+    // A customer of another warehouse pays at this one.
+    int cw = w, cd = d;
+    if (layout_.Warehouses() > 1 && random->Uniform(100) < 15)
+    {
+        cw = OtherWarehouse(random, w);
+        cd = random->Uniform(layout_.Districts());
+    }
+    uint64 amount = 100 + random->Uniform(500000 - 100 + 1);
+    return new TpccPayment(layout_.WarehouseKey(w), layout_.DistrictKey(w, d), layout_.CustomerKey(cw, cd, c), amount,
+                           wait_time_);
+}
@@ -2,8 +2,12 @@
 #define _LOAD_GENERATOR_H_
 
 
+#include "txn/tpcc.h"
 #include "txn/txn.h"
+#include "txn/txn_pool.h"
 #include "txn_types.h"
+#include "utils/random.h"
+#include <atomic>
 #include <set>
 
 
@@ -13,6 +17,9 @@ class LoadGen
    public:
     virtual ~LoadGen() {}
     virtual Txn* NewTxn() = 0;
+    // Like NewTxn(), taking the txn from 'pool' when the generator knows how
+    // to fill a recycled one.
+    virtual Txn* NewPooledTxn(TxnPool* pool) { return NewTxn(); }
 };
 
 class RMWLoadGen : public LoadGen
@@ -24,6 +31,13 @@ class RMWLoadGen : public LoadGen
     }
 
     virtual Txn* NewTxn() { return new RMW(dbsize_, rsetsize_, wsetsize_, wait_time_); }
+    virtual Txn* NewPooledTxn(TxnPool* pool)
+    {
+        RMW* txn = pool->Acquire<RMW>();
+        txn->Init(dbsize_, rsetsize_, wsetsize_, wait_time_);
+        return txn;
+    }
+
    private:
     int dbsize_;
     int rsetsize_;
@@ -50,6 +64,16 @@ class RMWLoadGen2 : public LoadGen
             return new RMW(dbsize_, 0, wsetsize_, 0);
     }
 
+    virtual Txn* NewPooledTxn(TxnPool* pool)
+    {
+        RMW* txn = pool->Acquire<RMW>();
+        if (rand() % 100 < 80)
+            txn->Init(dbsize_, rsetsize_, 0, wait_time_);
+        else
+            txn->Init(dbsize_, 0, wsetsize_, 0);
+        return txn;
+    }
+
    private:
     int dbsize_;
     int rsetsize_;
@@ -121,4 +145,150 @@ class RMWLoadGenHot : public LoadGen
    protected:
     set<Key> hotset_;
 };
-#endif
\ No newline at end of file
+
+// Ranks in [0, n) drawn from a Zipfian distribution, rank 0 the most likely:
+// P(rank i) ~ 1 / (i + 1)^theta, for 0 <= theta < 1 (theta 0 is uniform,
+// YCSB uses 0.99). YCSB's generator (Gray et al., "Quickly generating
+// billion-record synthetic databases"): O(n) setup, O(1) per draw.
+class ZipfianDistribution
+{
+   public:
+    ZipfianDistribution(uint64 n, double theta);
+    uint64 Next(FastRandom* random) const;
+
+    // Sum of 1 / i^theta for i in [1, n].
+    static double Zeta(uint64 n, double theta);
+
+   private:
+    uint64 n_;
+    double theta_;
+    double alpha_;
+    double zetan_;
+    double eta_;
+    double half_pow_theta_;
+};
+
+// RMW txns over keys drawn by NextKey() from the per thread FastRandom.
+class RMWKeyLoadGen : public LoadGen
+{
+   public:
+    RMWKeyLoadGen(int rsetsize, int wsetsize, double wait_time)
+        : rsetsize_(rsetsize), wsetsize_(wsetsize), wait_time_(wait_time)
+    {
+    }
+
+    virtual Txn* NewTxn() { return Fill(new RMW()); }
+    virtual Txn* NewPooledTxn(TxnPool* pool) { return Fill(pool->Acquire<RMW>()); }
+
+   protected:
+    virtual RMW* Fill(RMW* txn);
+    // Draws the keys of 'txn' from NextKey(random, 'origin'), 'origin' being
+    // whatever the subclass picked for the whole txn (e.g. its hot range).
+    RMW* FillKeys(RMW* txn, int wsetsize, Key origin);
+    virtual Key NextKey(FastRandom* random, Key origin) = 0;
+
+    int rsetsize_;
+    int wsetsize_;
+    double wait_time_;
+};
+
+// Keys Zipfian over [0, dbsize): key 0 is the hottest.
+class ZipfianLoadGen : public RMWKeyLoadGen
+{
+   public:
+    ZipfianLoadGen(int dbsize, int rsetsize, int wsetsize, double theta, double wait_time)
+        : RMWKeyLoadGen(rsetsize, wsetsize, wait_time), zipf_(dbsize, theta)
+    {
+    }
+
+   protected:
+    virtual Key NextKey(FastRandom* random, Key origin) { return zipf_.Next(random); }
+
+   private:
+    ZipfianDistribution zipf_;
+};
+
+// YCSB's "latest": every txn writes ("inserts") the next key, treating
+// [0, dbsize) as a ring, and its other keys are Zipfian in their distance to
+// that key, so the hot spot keeps moving forward with the inserts.
+class LatestLoadGen : public RMWKeyLoadGen
+{
+   public:
+    // The other keys are 1 to dbsize - 1 behind the insert.
+    LatestLoadGen(int dbsize, int rsetsize, int wsetsize, double theta, double wait_time)
+        : RMWKeyLoadGen(rsetsize, wsetsize, wait_time), dbsize_(dbsize), zipf_(dbsize - 1, theta), inserts_(0)
+    {
+    }
+
+   protected:
+    virtual RMW* Fill(RMW* txn);
+    // 'origin' is the key the txn inserts.
+    virtual Key NextKey(FastRandom* random, Key origin);
+
+   private:
+    uint64 dbsize_;
+    ZipfianDistribution zipf_;
+    std::atomic<uint64> inserts_;
+};
+
+// 'hotpct' percent of the keys fall in a hot range of 'hotsetsize' keys, the
+// others anywhere in [0, dbsize). Every 'shift_period' seconds the hot range
+// jumps to another, pseudo randomly chosen, range of the key space.
+class ShiftingHotspotLoadGen : public RMWKeyLoadGen
+{
+   public:
+    ShiftingHotspotLoadGen(int dbsize, int rsetsize, int wsetsize, int hotsetsize, int hotpct, double shift_period,
+                           double wait_time);
+
+    // First key of the hot range at time 'now' (GetTime()).
+    Key HotStart(double now) const;
+
+   protected:
+    virtual RMW* Fill(RMW* txn);
+    // 'origin' is the first key of the hot range when the txn was made.
+    virtual Key NextKey(FastRandom* random, Key origin);
+
+   private:
+    uint64 dbsize_;
+    uint64 hotsetsize_;
+    int hotpct_;
+    double shift_period_;
+    double start_;
+};
+
+// TPC-C NewOrder and Payment txns over 'layout' ('neworder_pct' percent
+// NewOrders), with the spec's input rules: a uniform home warehouse and
+// district, NURand customers and items, 5-15 order lines of which 1% come
+// from a remote warehouse, 1% rolled back NewOrders and 15% Payments for a
+// remote customer. Contention is per warehouse: every NewOrder writes its
+// district and every Payment its warehouse, so it falls as warehouses grow.
+class TpccLoadGen : public LoadGen
+{
+   public:
+    TpccLoadGen(const TpccLayout& layout, int neworder_pct = 50, double wait_time = 0);
+
+    virtual Txn* NewTxn();
+
+    TpccNewOrder* NewOrder(FastRandom* random);
+    TpccPayment* Payment(FastRandom* random);
+
+   private:
+    // TPC-C's non uniform random in [0, n).
+    uint64 NURand(FastRandom* random, uint64 a, uint64 c, uint64 n) const
+    {
+        return ((random->Uniform(a + 1) | random->Uniform(n)) + c) % n;
+    }
+
+    // A warehouse other than 'w' (there must be one).
+    int OtherWarehouse(FastRandom* random, int w) const
+    {
+        return (w + 1 + random->Uniform(layout_.Warehouses() - 1)) % layout_.Warehouses();
+    }
+
+    TpccLayout layout_;
+    int neworder_pct_;
+    double wait_time_;
+    uint64 c_customer_;
+    uint64 c_item_;
+};
+#endif
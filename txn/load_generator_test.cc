@@ -0,0 +1,168 @@
+#include "txn/load_generator.h"
+
+#include <math.h>
+#include <pthread.h>
+
+#include "utils/testing.h"
+
+TEST(FastRandom_Ranges)
+{
+    FastRandom random(42);
+    FastRandom same(42);
+    vector<int> counts(10, 0);
+    for (int i = 0; i < 100000; i++)
+    {
+        uint64 n = random.Uniform(10);
+        EXPECT_TRUE(n < 10);
+        counts[n]++;
+        double d = same.NextDouble();
+        EXPECT_TRUE(d >= 0 && d < 1);
+    }
+    for (int i = 0; i < 10; i++) EXPECT_TRUE(counts[i] > 9000 && counts[i] < 11000);
+    END;
+}
+
+static void* FirstNumber(void* arg)
+{
+    *reinterpret_cast<uint64*>(arg) = FastRandom::ThreadLocal().Next();
+    return NULL;
+}
+
+TEST(FastRandom_PerThread)
+{
+    uint64 first[2];
+    pthread_t threads[2];
+    for (int i = 0; i < 2; i++) pthread_create(&threads[i], NULL, FirstNumber, &first[i]);
+    for (int i = 0; i < 2; i++) pthread_join(threads[i], NULL);
+    EXPECT_TRUE(first[0] != first[1]);
+    END;
+}
+
+TEST(Zipfian_Distribution)
+{
+    uint64 n = 1000;
+    double theta = 0.99;
+    ZipfianDistribution zipf(n, theta);
+    FastRandom random(7);
+    vector<int> counts(n, 0);
+    int draws = 200000;
+    for (int i = 0; i < draws; i++)
+    {
+        uint64 rank = zipf.Next(&random);
+        EXPECT_TRUE(rank < n);
+        counts[rank]++;
+    }
+
+    // P(rank 0) = 1 / zeta(n), P(rank 1) = P(rank 0) / 2^theta.
+    double p0 = 1 / ZipfianDistribution::Zeta(n, theta);
+    EXPECT_TRUE(fabs(counts[0] / (double)draws - p0) < 0.01);
+    EXPECT_TRUE(fabs(counts[1] / (double)draws - p0 / pow(2, theta)) < 0.01);
+    EXPECT_TRUE(counts[0] > counts[10] && counts[10] > counts[500]);
+
+    // theta 0 is uniform.
+    ZipfianDistribution uniform(n, 0);
+    int low = 0;
+    for (int i = 0; i < draws; i++) low += uniform.Next(&random) < n / 2;
+    EXPECT_TRUE(low > draws * 0.48 && low < draws * 0.52);
+    END;
+}
+
+TEST(ZipfianLoadGen_Keys)
+{
+    ZipfianLoadGen lg(1000, 3, 2, 0.99, 0);
+    TxnPool pool;
+    for (int i = 0; i < 100; i++)
+    {
+        Txn* txn = i % 2 ? lg.NewTxn() : lg.NewPooledTxn(&pool);
+        EXPECT_EQ(2, (int)txn->writeset_.size());
+        for (KeySet::const_iterator it = txn->writeset_.begin(); it != txn->writeset_.end(); ++it)
+            EXPECT_TRUE(*it < 1000);
+        pool.Release(txn);
+    }
+    END;
+}
+
+TEST(LatestLoadGen_Inserts)
+{
+    // Two generators on one thread don't share their inserts.
+    LatestLoadGen lg(100, 1, 3, 0.99, 0);
+    LatestLoadGen other(10, 0, 2, 0.99, 0);
+    for (int i = 0; i < 250; i++)
+    {
+        Txn* txn = lg.NewTxn();
+        EXPECT_EQ(3, (int)txn->writeset_.size());
+        // Inserts go around the key ring.
+        EXPECT_EQ(1, (int)txn->writeset_.count(i % 100));
+        delete txn;
+
+        txn = other.NewTxn();
+        EXPECT_EQ(1, (int)txn->writeset_.count(i % 10));
+        for (KeySet::const_iterator it = txn->writeset_.begin(); it != txn->writeset_.end(); ++it)
+            EXPECT_TRUE(*it < 10);
+        delete txn;
+    }
+    END;
+}
+
+TEST(LatestLoadGen_SmallRing)
+{
+    // The farthest distance Zipfian draws is still behind the insert.
+    LatestLoadGen lg(8, 3, 4, 0.99, 0);
+    for (int i = 0; i < 1000; i++)
+    {
+        Txn* txn = lg.NewTxn();
+        txn->CheckReadWriteSets();  // dies if the insert is also read
+        EXPECT_EQ(1, (int)txn->writeset_.count(i % 8));
+        EXPECT_EQ(4, (int)txn->writeset_.size());
+        delete txn;
+    }
+    END;
+}
+
+// Whether all the write keys of 'txn' are in [hot_start, hot_start + hotsetsize).
+static bool InHotRange(Txn* txn, Key hot_start, int hotsetsize)
+{
+    for (KeySet::const_iterator it = txn->writeset_.begin(); it != txn->writeset_.end(); ++it)
+        if (*it < hot_start || *it >= hot_start + hotsetsize) return false;
+    return true;
+}
+
+// Checks a new txn has its keys in the hot range of the time it was made.
+static void CheckHotTxn(ShiftingHotspotLoadGen* lg)
+{
+    Key before = lg->HotStart(GetTime());
+    Txn* txn   = lg->NewTxn();
+    Key after  = lg->HotStart(GetTime());
+    EXPECT_EQ(4, (int)txn->writeset_.size());
+    EXPECT_TRUE(InHotRange(txn, before, 100) || InHotRange(txn, after, 100));
+    delete txn;
+}
+
+TEST(ShiftingHotspotLoadGen_Shifts)
+{
+    ShiftingHotspotLoadGen lg(100000, 0, 4, 100, 100, 0.05, 0);
+    double start  = GetTime();
+    Key hot_start = lg.HotStart(start);
+    EXPECT_EQ(0, (int)(hot_start % 100));
+    CheckHotTxn(&lg);
+
+    // A few periods later the hot range has moved (the ranges of two epochs
+    // coincide with probability 1/1000).
+    int moved = 0;
+    for (int epoch = 1; epoch <= 3; epoch++) moved += lg.HotStart(start + 0.05 * epoch + 0.01) != hot_start;
+    EXPECT_TRUE(moved >= 2);
+    Sleep(0.12);
+    CheckHotTxn(&lg);
+    END;
+}
+
+int main(int argc, char** argv)
+{
+    FastRandom_Ranges();
+    FastRandom_PerThread();
+    Zipfian_Distribution();
+    ZipfianLoadGen_Keys();
+    LatestLoadGen_Inserts();
+    LatestLoadGen_SmallRing();
+    ShiftingHotspotLoadGen_Shifts();
+}
@@ -1,72 +1,375 @@
 
 // Lock manager implementing deterministic two-phase locking as described in
 // 'The Case for Determinism in Database Systems'.
+#include <algorithm>
 #include <iostream>
 
 #include "txn/lock_manager.h"
 
+void LockManager::BeginRequests(Txn* txn)
+{
+    ready_mutex_.Lock();
+    txn_waits_[txn]++;
+    ready_mutex_.Unlock();
+}
+
+void LockManager::EndRequests(Txn* txn)
+{
+    ready_mutex_.Lock();
+    Granted(txn);
+    ready_mutex_.Unlock();
+}
+
+bool LockManager::NextReady(Txn** txn)
+{
+    ready_mutex_.Lock();
+    bool ready = !ready_txns_->empty();
+    if (ready)
+    {
+        *txn = ready_txns_->front();
+        ready_txns_->pop_front();
+    }
+    ready_mutex_.Unlock();
+    return ready;
+}
+
+void LockManager::Granted(Txn* txn)
+{
+    unordered_map<Txn*, int>::iterator it = txn_waits_.find(txn);
+    if (it == txn_waits_.end()) return;
+    if (--it->second == 0)
+    {
+        txn_waits_.erase(it);
+        ready_txns_->push_back(txn);
+    }
+}
+
+LockMode LockManager::Holders(const deque<LockRequest>& requests, vector<Txn*>* owners)
+{
+    owners->clear();
+    if (requests.empty()) return UNLOCKED;
+    if (requests.front().mode_ == EXCLUSIVE)
+    {
+        owners->push_back(requests.front().txn_);
+        return EXCLUSIVE;
+    }
+    for (deque<LockRequest>::const_iterator it = requests.begin(); it != requests.end() && it->mode_ == SHARED; ++it)
+        owners->push_back(it->txn_);
+    return SHARED;
+}
+
+bool LockManager::Request(Txn* txn, const Key& key, LockMode mode)
+{
+    LockTableBucket* bucket = Bucket(key);
+    bucket->latch_.Lock();
+    deque<LockRequest>*& requests = bucket->requests_[key];
+    if (requests == nullptr) requests = new deque<LockRequest>();
+    requests->push_back(LockRequest(mode, txn));
+
+    // Granted if it is first, or a read behind reads only.
+    bool granted = requests->size() == 1;
+    if (!granted && mode == SHARED)
+    {
+        granted = true;
+        for (deque<LockRequest>::iterator it = requests->begin(); granted && it != requests->end() - 1; ++it)
+            granted = it->mode_ == SHARED;
+    }
+    if (!granted)
+    {
+        ready_mutex_.Lock();
+        txn_waits_[txn]++;
+        ready_mutex_.Unlock();
+    }
+    bucket->latch_.Unlock();
+    return granted;
+}
+
+void LockManager::RemoveRequest(Txn* txn, const Key& key)
+{
+    LockTableBucket* bucket = Bucket(key);
+    bucket->latch_.Lock();
+    unordered_map<Key, deque<LockRequest>*>::iterator entry = bucket->requests_.find(key);
+    if (entry == bucket->requests_.end())
+    {
+        bucket->latch_.Unlock();
+        return;
+    }
+    deque<LockRequest>* requests = entry->second;
+
+    vector<Txn*> before, after;
+    Holders(*requests, &before);
+    for (deque<LockRequest>::iterator it = requests->begin(); it != requests->end(); ++it)
+    {
+        if (it->txn_ == txn)
+        {
+            requests->erase(it);
+            break;
+        }
+    }
+    Holders(*requests, &after);
+
+    ready_mutex_.Lock();
+    if (std::find(before.begin(), before.end(), txn) == before.end())
+    {
+        // A cancelled request: 'txn' isn't waiting anymore.
+        txn_waits_.erase(txn);
+    }
+    for (size_t i = 0; i < after.size(); i++)
+        if (std::find(before.begin(), before.end(), after[i]) == before.end()) Granted(after[i]);
+    ready_mutex_.Unlock();
+
+    if (requests->empty())
+    {
+        delete requests;
+        bucket->requests_.erase(entry);
+    }
+    bucket->latch_.Unlock();
+}
+
+LockMode LockManager::StatusOf(const Key& key, vector<Txn*>* owners)
+{
+    LockTableBucket* bucket = Bucket(key);
+    bucket->latch_.Lock();
+    unordered_map<Key, deque<LockRequest>*>::iterator entry = bucket->requests_.find(key);
+    LockMode mode = UNLOCKED;
+    if (entry != bucket->requests_.end())
+        mode = Holders(*entry->second, owners);
+    else
+        owners->clear();
+    bucket->latch_.Unlock();
+    return mode;
+}
+
 LockManagerA::LockManagerA(deque<Txn*>* ready_txns) { ready_txns_ = ready_txns; }
 bool LockManagerA::WriteLock(Txn* txn, const Key& key)
 {
-    return true; 
+    return Request(txn, key, EXCLUSIVE);
 }
 
 bool LockManagerA::ReadLock(Txn* txn, const Key& key)
 {
     // Since Part 1A implements ONLY exclusive locks, calls to ReadLock can
     // simply use the same logic as 'WriteLock'.
-    return true;
+    return WriteLock(txn, key);
 }
 
 void LockManagerA::Release(Txn* txn, const Key& key)
 {
-
+    RemoveRequest(txn, key);
 }
 
 // NOTE: The owners input vector is NOT assumed to be empty.
 LockMode LockManagerA::Status(const Key& key, vector<Txn*>* owners)
 {
-    return UNLOCKED;
+    return StatusOf(key, owners);
 }
 
 LockManagerB::LockManagerB(deque<Txn*>* ready_txns) { ready_txns_ = ready_txns; }
 bool LockManagerB::WriteLock(Txn* txn, const Key& key)
 {
-    return true;
+    return Request(txn, key, EXCLUSIVE);
 }
 
 bool LockManagerB::ReadLock(Txn* txn, const Key& key)
 {
-    return true;
+    return Request(txn, key, SHARED);
 }
 
 void LockManagerB::Release(Txn* txn, const Key& key)
 {
+    RemoveRequest(txn, key);
 }
 
 // NOTE: The owners input vector is NOT assumed to be empty.
 LockMode LockManagerB::Status(const Key& key, vector<Txn*>* owners)
 {
-    return UNLOCKED;
+    return StatusOf(key, owners);
+}
+
+LockManagerC::LockManagerC(LockPolicy policy)
+    : policy_(policy), words_(new std::atomic<uint64>[kTableSize]), parks_(new ParkSlot[kParkSlots])
+{
+    for (uint64 i = 0; i < kTableSize; i++) words_[i].store(0, std::memory_order_relaxed);
+}
+
+LockManagerC::~LockManagerC()
+{
+    delete[] words_;
+    delete[] parks_;
+}
+
+// Readers record the smallest id among the holders since the word was last
+// free, which may be older than the remaining ones: wait-die then gives up
+// more often than needed, which is safe.
+bool LockManagerC::TryLock(uint64 index, bool exclusive, uint64 holder, uint64* current)
+{
+    std::atomic<uint64>* word = &words_[index];
+    holder                    = (holder & (kHolderMask >> kHolderShift)) << kHolderShift;
+    if (exclusive)
+    {
+        *current = 0;
+        return word->compare_exchange_strong(*current, kWriter | holder, std::memory_order_acquire);
+    }
+
+    *current = word->load(std::memory_order_relaxed);
+    while (!(*current & kWriter))
+    {
+        uint64 oldest = *current & kHolderMask;
+        if (*current != 0 && oldest < holder) holder = oldest;
+        if (word->compare_exchange_weak(*current, holder | ((*current & kReaderMask) + 1), std::memory_order_acquire))
+            return true;
+    }
+    return false;
+}
+
+void LockManagerC::Unlock(uint64 index, bool exclusive)
+{
+    std::atomic<uint64>* word = &words_[index];
+    if (exclusive)
+    {
+        word->store(0, std::memory_order_release);
+    }
+    else
+    {
+        // The last reader clears the holder id too.
+        uint64 current = word->load(std::memory_order_relaxed);
+        while (!word->compare_exchange_weak(current, (current & kReaderMask) == 1 ? 0 : current - 1,
+                                            std::memory_order_release))
+        {
+        }
+    }
+
+    if (policy_ == LOCK_SPIN_PARK)
+    {
+        // Pairs with the fence in Wait(): either the sleeper sees the word
+        // released, or this sees the sleeper.
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        ParkSlot* slot = &parks_[index % kParkSlots];
+        if (slot->waiters_.load(std::memory_order_relaxed) != 0)
+        {
+            slot->mutex_.Lock();
+            slot->cond_.notify_all();
+            slot->mutex_.Unlock();
+        }
+    }
 }
 
-LockManagerC::LockManagerC() { }
 bool LockManagerC::WriteLock(Txn* txn, const Key& key)
 {
-    return true; 
+    uint64 current;
+    return TryLock(key & (kTableSize - 1), true, 0, &current);
 }
 
 bool LockManagerC::ReadLock(Txn* txn, const Key& key)
 {
-    return true;
+    uint64 current;
+    return TryLock(key & (kTableSize - 1), false, 0, &current);
 }
 
 void LockManagerC::Release(Txn* txn, const Key& key)
 {
-
+    // While 'txn' holds the lock, the writer bit is set iff 'txn' is the writer.
+    uint64 index = key & (kTableSize - 1);
+    Unlock(index, words_[index].load(std::memory_order_relaxed) & kWriter);
 }
 
 LockMode LockManagerC::Status(const Key& key, vector<Txn*>* owners)
 {
-    return UNLOCKED;
-}
\ No newline at end of file
+    owners->clear();
+    uint64 word = Word(key)->load(std::memory_order_acquire);
+    if (word & kWriter) return EXCLUSIVE;
+    return (word & kReaderMask) == 0 ? UNLOCKED : SHARED;
+}
+
+void LockManagerC::Plan(const KeySet& readset, const KeySet& writeset, LockPlan* plan)
+{
+    vector<uint64>& entries = plan->entries_;
+    entries.clear();
+    for (KeySet::const_iterator it = readset.begin(); it != readset.end(); ++it)
+        entries.push_back((*it & (kTableSize - 1)) << 1);
+    for (KeySet::const_iterator it = writeset.begin(); it != writeset.end(); ++it)
+        entries.push_back(((*it & (kTableSize - 1)) << 1) | 1);
+    std::sort(entries.begin(), entries.end());
+
+    // An exclusive entry sorts right after the shared one for the same word,
+    // so keeping the last entry per word keeps the strongest mode.
+    size_t n = 0;
+    for (size_t i = 0; i < entries.size(); i++)
+    {
+        if (n != 0 && (entries[n - 1] >> 1) == (entries[i] >> 1))
+            entries[n - 1] = entries[i];
+        else
+            entries[n++] = entries[i];
+    }
+    entries.resize(n);
+}
+
+bool LockManagerC::Wait(uint64 index, bool exclusive, uint64 txn_id)
+{
+    uint64 current;
+    switch (policy_)
+    {
+        case LOCK_SPIN:
+            while (!TryLock(index, exclusive, txn_id, &current))
+            {
+            }
+            return true;
+
+        case LOCK_NO_WAIT:
+            return TryLock(index, exclusive, txn_id, &current);
+
+        case LOCK_WAIT_DIE:
+            // Holder id 0 (unknown) is never younger.
+            while (!TryLock(index, exclusive, txn_id, &current))
+            {
+                if ((txn_id & (kHolderMask >> kHolderShift)) >= (current & kHolderMask) >> kHolderShift) return false;
+            }
+            return true;
+
+        case LOCK_SPIN_PARK:
+        {
+            for (int i = 0; i < kSpinLimit; i++)
+                if (TryLock(index, exclusive, txn_id, &current)) return true;
+
+            ParkSlot* slot = &parks_[index % kParkSlots];
+            slot->waiters_.fetch_add(1);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            slot->mutex_.Lock();
+            while (!TryLock(index, exclusive, txn_id, &current)) slot->cond_.wait(slot->mutex_);
+            slot->mutex_.Unlock();
+            slot->waiters_.fetch_sub(1);
+            return true;
+        }
+
+        default:
+            DIE("Invalid LockPolicy: " << policy_);
+    }
+}
+
+bool LockManagerC::Acquire(const LockPlan& plan, uint64 txn_id)
+{
+    const vector<uint64>& entries = plan.entries_;
+    for (size_t i = 0; i < entries.size() && i < kPrefetchDistance; i++)
+        __builtin_prefetch(&words_[entries[i] >> 1], 1);
+
+    for (size_t i = 0; i < entries.size(); i++)
+    {
+        if (i + kPrefetchDistance < entries.size())
+            __builtin_prefetch(&words_[entries[i + kPrefetchDistance] >> 1], 1);
+
+        uint64 current;
+        if (TryLock(entries[i] >> 1, entries[i] & 1, txn_id, &current)) continue;
+        if (!Wait(entries[i] >> 1, entries[i] & 1, txn_id))
+        {
+            while (i-- > 0) Unlock(entries[i] >> 1, entries[i] & 1);
+            return false;
+        }
+    }
+    return true;
+}
+
+void LockManagerC::ReleaseAll(const LockPlan& plan)
+{
+    const vector<uint64>& entries = plan.entries_;
+    for (size_t i = 0; i < entries.size(); i++) Unlock(entries[i] >> 1, entries[i] & 1);
+}
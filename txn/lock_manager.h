@@ -4,16 +4,20 @@
 #ifndef _LOCK_MANAGER_H_
 #define _LOCK_MANAGER_H_
 
+#include <atomic>
 #include <deque>
 #include <map>
+#include <set>
 #include <unordered_map>
 #include <vector>
 
 #include "txn/common.h"
 #include "txn/txn.h"
+#include "utils/global.h"
 #include "utils/mutex.h"
 
 using std::map;
+using std::set;
 using std::deque;
 using std::vector;
 using std::unordered_map;
@@ -68,6 +72,16 @@ class LockManager
     // held, SHARED or EXCLUSIVE if it is, depending on the current state.
     virtual LockMode Status(const Key& key, vector<Txn*>* owners) = 0;
 
+    // Bracket all lock requests of 'txn' when other threads may Release()
+    // concurrently, so 'txn' isn't made ready while it is still requesting.
+    // EndRequests() appends 'txn' to 'ready_txns_' if all its locks were
+    // granted by then; otherwise the Release() granting the last one does.
+    void BeginRequests(Txn* txn);
+    void EndRequests(Txn* txn);
+
+    // Pops the next txn of 'ready_txns_'. Returns false if there is none.
+    bool NextReady(Txn** txn);
+
    protected:
     // The LockManager's lock table tracks all lock requests. For a given key, if
     // 'lock_table_' contains a nonempty deque, then the item with that key is
@@ -101,7 +115,33 @@ class LockManager
         Txn* txn_;       // Pointer to txn requesting the lock.
         LockMode mode_;  // Specifies whether this is a read or write lock request.
     };
-    unordered_map<Key, deque<LockRequest>*> lock_table_;
+
+    // The lock table is partitioned by key into buckets, each with its own
+    // latch, so requests on different keys rarely contend. Empty deques are
+    // removed.
+    static const int kLockTableBuckets = 1024;
+    struct LockTableBucket
+    {
+        Mutex latch_;
+        unordered_map<Key, deque<LockRequest>*> requests_;
+    };
+    LockTableBucket lock_table_[kLockTableBuckets];
+
+    LockTableBucket* Bucket(const Key& key) { return &lock_table_[key % kLockTableBuckets]; }
+
+    // Appends a request to the queue of 'key' and returns true if it is
+    // granted right away, else counts it in 'txn_waits_'.
+    bool Request(Txn* txn, const Key& key, LockMode mode);
+
+    // Removes the request of 'txn' from the queue of 'key' and grants the
+    // requests it was blocking.
+    void RemoveRequest(Txn* txn, const Key& key);
+
+    // Status() of the lock table.
+    LockMode StatusOf(const Key& key, vector<Txn*>* owners);
+
+    // Current holders of the lock described by 'requests'.
+    static LockMode Holders(const deque<LockRequest>& requests, vector<Txn*>* owners);
 
     // Queue of pointers to transactions that:
     //  (a) were previously blocked on acquiring at least one lock, and
@@ -112,6 +152,14 @@ class LockManager
     // 'txn_waits_' are invalided by any call to Release() with the entry's
     // txn.
     unordered_map<Txn*, int> txn_waits_;
+
+    // Guards 'txn_waits_' and 'ready_txns_'. Taken after a bucket latch.
+    Mutex ready_mutex_;
+
+   private:
+    // Counts one lock less for 'txn' to wait for, making it ready at zero.
+    // Requires: 'ready_mutex_' is held.
+    void Granted(Txn* txn);
 };
 
 // Version of the LockManager implementing ONLY exclusive locks.
@@ -138,18 +186,95 @@ class LockManagerB : public LockManager
     virtual LockMode Status(const Key& key, vector<Txn*>* owners);
 };
 
+// The locks a txn takes from a LockManagerC, built once per txn: the lock words
+// of its read and write sets in increasing index order, each once, in the
+// strongest mode requested for any key mapping to it. Each entry is
+// (word index << 1) | exclusive. Reusing one plan across txns keeps its
+// storage.
+struct LockPlan
+{
+    vector<uint64> entries_;
+};
+
+// What LockManagerC::Acquire() does when a lock of the plan is taken.
+enum LockPolicy
+{
+    LOCK_SPIN      = 0,  // retry until it's free
+    LOCK_NO_WAIT   = 1,  // give up right away
+    LOCK_WAIT_DIE  = 2,  // wait if older than the holders, else give up
+    LOCK_SPIN_PARK = 3,  // retry kSpinLimit times, then sleep until released
+};
+
+// Version of the LockManager used by the STRIFE executors (STRIFE_LM/PLM): no
+// queues, every key maps to a 64-bit lock word in a fixed-size table, so
+// locking is a single CAS and nothing is allocated. A word holds a writer
+// bit, the id of the oldest holder (for wait-die) and a reader count.
+// Requests don't wait: they return false if the lock is taken and the caller
+// retries. Keys are direct-mapped, keys below kTableSize never share a word.
+// Txns locking key by key must not lock two keys sharing a word in
+// conflicting modes, and should lock in increasing key order to avoid
+// deadlocks; LockPlans take care of both.
 class LockManagerC : public LockManager
 {
    public:
-    explicit LockManagerC();
-    inline virtual ~LockManagerC() {}
+    explicit LockManagerC(LockPolicy policy = LOCK_SPIN);
+    virtual ~LockManagerC();
     virtual bool ReadLock(Txn* txn, const Key& key);
     virtual bool WriteLock(Txn* txn, const Key& key);
+    // Releases the lock 'txn' holds on 'key' (in either mode).
     virtual void Release(Txn* txn, const Key& key);
+    // Lock words don't record the holders, '*owners' is left empty.
     virtual LockMode Status(const Key& key, vector<Txn*>* owners);
-private:
-    Mutex mutex_;
 
+    // Sets '*plan' to the locks needed for 'readset' and 'writeset'.
+    static void Plan(const KeySet& readset, const KeySet& writeset, LockPlan* plan);
+
+    // Takes every lock of 'plan' in order for txn 'txn_id' (smaller ids are
+    // older), waiting on taken ones as the policy says, and prefetching the
+    // words kPrefetchDistance entries ahead. Returns false, holding nothing,
+    // if the policy gave up: the txn should be retried. Deadlock free as long
+    // as all txns lock through plans.
+    bool Acquire(const LockPlan& plan, uint64 txn_id);
+
+    // Releases every lock of 'plan'.
+    void ReleaseAll(const LockPlan& plan);
+
+    static const uint64 kTableSize  = 1 << 20;
+    static const uint64 kWriter     = 1ull << 63;
+    static const int kHolderShift   = 32;
+    static const uint64 kHolderMask = 0x7fffffffull << kHolderShift;
+    static const uint64 kReaderMask = 0xffffffffull;
+    static const int kSpinLimit     = 1024;
+
+   private:
+    static const size_t kPrefetchDistance = 4;
+    static const uint64 kParkSlots        = 1024;
+
+    // Threads sleeping on the words mapping to the slot.
+    struct ParkSlot
+    {
+        ParkSlot() : waiters_(0) {}
+        Mutex mutex_;
+        CondVariable cond_;
+        std::atomic<int> waiters_;
+    };
+
+    std::atomic<uint64>* Word(const Key& key) { return &words_[key & (kTableSize - 1)]; }
+
+    // Takes word 'index' once for txn 'holder' (0: unknown). On failure,
+    // '*current' is the word that was in the way.
+    bool TryLock(uint64 index, bool exclusive, uint64 holder, uint64* current);
+    void Unlock(uint64 index, bool exclusive);
+
+    // Waits for word 'index' as the policy says. Returns false if 'txn_id'
+    // should give up.
+    bool Wait(uint64 index, bool exclusive, uint64 txn_id);
+
+    LockPolicy policy_;
+    std::atomic<uint64>* words_;
+    ParkSlot* parks_;
+
+    DISALLOW_CLASS_COPY_AND_ASSIGN(LockManagerC);
 };
 
 #endif  // _LOCK_MANAGER_H_
@@ -1,5 +1,6 @@
 #include "txn/lock_manager.h"
 
+#include <pthread.h>
 #include <set>
 #include <string>
 
@@ -187,10 +188,237 @@ TEST(LockManagerB_LocksReleasedOutOfOrder)
     END;
 }
 
+// Locks granted while a txn is still requesting don't make it ready early.
+TEST(LockManager_RequestsBracket)
+{
+    deque<Txn*> ready_txns;
+    LockManagerB lm(&ready_txns);
+    Txn* t1 = reinterpret_cast<Txn*>(1);
+    Txn* t2 = reinterpret_cast<Txn*>(2);
+    Txn* txn;
+
+    lm.BeginRequests(t1);
+    lm.WriteLock(t1, 101);
+    lm.EndRequests(t1);
+    EXPECT_TRUE(lm.NextReady(&txn));
+    EXPECT_EQ(t1, txn);
+
+    lm.BeginRequests(t2);
+    lm.ReadLock(t2, 101);
+    lm.Release(t1, 101);  // t2 gets key 101 but still has to request 102
+    EXPECT_FALSE(lm.NextReady(&txn));
+    lm.WriteLock(t2, 102);
+    lm.EndRequests(t2);
+    EXPECT_TRUE(lm.NextReady(&txn));
+    EXPECT_EQ(t2, txn);
+    EXPECT_FALSE(lm.NextReady(&txn));
+    END;
+}
+
+TEST(LockManagerC_LockWords)
+{
+    LockManagerC lm;
+    vector<Txn*> owners;
+    Txn* t1 = reinterpret_cast<Txn*>(1);
+    Txn* t2 = reinterpret_cast<Txn*>(2);
+
+    EXPECT_EQ(UNLOCKED, lm.Status(101, &owners));
+    EXPECT_TRUE(lm.ReadLock(t1, 101));
+    EXPECT_TRUE(lm.ReadLock(t2, 101));
+    EXPECT_EQ(SHARED, lm.Status(101, &owners));
+    EXPECT_FALSE(lm.WriteLock(t2, 101));
+
+    lm.Release(t1, 101);
+    lm.Release(t2, 101);
+    EXPECT_TRUE(lm.WriteLock(t2, 101));
+    EXPECT_EQ(EXCLUSIVE, lm.Status(101, &owners));
+    EXPECT_FALSE(lm.ReadLock(t1, 101));
+    EXPECT_FALSE(lm.WriteLock(t1, 101));
+    EXPECT_TRUE(lm.WriteLock(t1, 102));
+
+    lm.Release(t2, 101);
+    lm.Release(t1, 102);
+    EXPECT_EQ(UNLOCKED, lm.Status(101, &owners));
+    EXPECT_EQ(UNLOCKED, lm.Status(102, &owners));
+    END;
+}
+
+TEST(LockManagerC_LockPlan)
+{
+    LockManagerC lm;
+    vector<Txn*> owners;
+    set<Key> readset;
+    set<Key> writeset;
+    readset.insert(9);
+    readset.insert(3);
+    readset.insert(5);
+    readset.insert(7 + LockManagerC::kTableSize);
+    writeset.insert(5);
+    writeset.insert(1);
+    writeset.insert(7);
+
+    // Sorted by word, one entry per word, exclusive wins.
+    LockPlan plan;
+    LockManagerC::Plan(readset, writeset, &plan);
+    EXPECT_EQ(5, (int)plan.entries_.size());
+    uint64 expected[] = {(1 << 1) | 1, 3 << 1, (5 << 1) | 1, (7 << 1) | 1, 9 << 1};
+    for (int i = 0; i < 5 && i < (int)plan.entries_.size(); i++) EXPECT_EQ(expected[i], plan.entries_[i]);
+
+    EXPECT_TRUE(lm.Acquire(plan, 1));
+    EXPECT_EQ(EXCLUSIVE, lm.Status(1, &owners));
+    EXPECT_EQ(SHARED, lm.Status(3, &owners));
+    EXPECT_EQ(EXCLUSIVE, lm.Status(5, &owners));
+    EXPECT_EQ(EXCLUSIVE, lm.Status(7, &owners));
+    EXPECT_EQ(SHARED, lm.Status(9, &owners));
+    lm.ReleaseAll(plan);
+    for (Key key = 0; key < 10; key++) EXPECT_EQ(UNLOCKED, lm.Status(key, &owners));
+
+    // Plans are reused: rebuilding drops the previous entries.
+    LockManagerC::Plan(set<Key>(), writeset, &plan);
+    EXPECT_EQ(3, (int)plan.entries_.size());
+    END;
+}
+
+static LockPlan MakePlan(Key read, Key write)
+{
+    set<Key> readset;
+    set<Key> writeset;
+    readset.insert(read);
+    writeset.insert(write);
+    LockPlan plan;
+    LockManagerC::Plan(readset, writeset, &plan);
+    return plan;
+}
+
+TEST(LockManagerC_NoWait)
+{
+    LockManagerC lm(LOCK_NO_WAIT);
+    vector<Txn*> owners;
+    LockPlan holder = MakePlan(1, 5);
+    LockPlan other  = MakePlan(1, 5);
+
+    EXPECT_TRUE(lm.Acquire(holder, 7));
+    // Shares key 1, then gives up on key 5 and drops key 1 again.
+    EXPECT_FALSE(lm.Acquire(other, 3));
+    EXPECT_EQ(SHARED, lm.Status(1, &owners));
+    lm.ReleaseAll(holder);
+    EXPECT_EQ(UNLOCKED, lm.Status(1, &owners));
+    EXPECT_TRUE(lm.Acquire(other, 3));
+    lm.ReleaseAll(other);
+    END;
+}
+
+struct ReleaseLaterArgs
+{
+    LockManagerC* lm;
+    LockPlan* plan;
+};
+
+static void* ReleaseLater(void* arg)
+{
+    ReleaseLaterArgs* args = reinterpret_cast<ReleaseLaterArgs*>(arg);
+    Sleep(0.01);
+    args->lm->ReleaseAll(*args->plan);
+    return NULL;
+}
+
+// Txn 'waiter' acquires 'plan' while txn 'holder' holds it and releases it
+// from another thread a bit later.
+static bool AcquireWhileHeld(LockManagerC* lm, LockPlan* plan, uint64 holder, uint64 waiter)
+{
+    EXPECT_TRUE(lm->Acquire(*plan, holder));
+    ReleaseLaterArgs args = {lm, plan};
+    pthread_t thread;
+    pthread_create(&thread, NULL, ReleaseLater, &args);
+    bool acquired = lm->Acquire(*plan, waiter);
+    pthread_join(thread, NULL);
+    if (acquired) lm->ReleaseAll(*plan);
+    return acquired;
+}
+
+TEST(LockManagerC_WaitDie)
+{
+    LockManagerC lm(LOCK_WAIT_DIE);
+    vector<Txn*> owners;
+    LockPlan plan = MakePlan(1, 5);
+
+    // Older txns wait, younger ones die.
+    EXPECT_TRUE(AcquireWhileHeld(&lm, &plan, 7, 3));
+    EXPECT_FALSE(AcquireWhileHeld(&lm, &plan, 7, 9));
+    EXPECT_EQ(UNLOCKED, lm.Status(5, &owners));
+
+    // Against readers, the oldest one counts.
+    LockPlan readers = MakePlan(5, 6);
+    LockPlan writer  = MakePlan(1, 5);
+    EXPECT_TRUE(lm.Acquire(readers, 4));
+    EXPECT_FALSE(lm.Acquire(writer, 6));
+    lm.ReleaseAll(readers);
+    EXPECT_EQ(UNLOCKED, lm.Status(5, &owners));
+    END;
+}
+
+TEST(LockManagerC_SpinPark)
+{
+    LockManagerC lm(LOCK_SPIN_PARK);
+    vector<Txn*> owners;
+    LockPlan plan = MakePlan(1, 5);
+
+    // The waiter runs out of spins long before the holder releases.
+    EXPECT_TRUE(AcquireWhileHeld(&lm, &plan, 3, 7));
+    EXPECT_TRUE(AcquireWhileHeld(&lm, &plan, 7, 3));
+    EXPECT_EQ(UNLOCKED, lm.Status(5, &owners));
+    END;
+}
+
+struct LockWordArgs
+{
+    LockManagerC* lm;
+    int* counter;
+};
+
+static void* IncrementUnderLock(void* arg)
+{
+    LockWordArgs* args = reinterpret_cast<LockWordArgs*>(arg);
+    Txn* txn           = reinterpret_cast<Txn*>(arg);
+    for (int i = 0; i < 100000; i++)
+    {
+        while (!args->lm->WriteLock(txn, 7))
+        {
+        }
+        (*args->counter)++;
+        args->lm->Release(txn, 7);
+    }
+    return NULL;
+}
+
+TEST(LockManagerC_MutualExclusion)
+{
+    LockManagerC lm;
+    int counter = 0;
+    LockWordArgs args[4];
+    pthread_t threads[4];
+    for (int t = 0; t < 4; t++)
+    {
+        args[t].lm      = &lm;
+        args[t].counter = &counter;
+        pthread_create(&threads[t], NULL, IncrementUnderLock, &args[t]);
+    }
+    for (int t = 0; t < 4; t++) pthread_join(threads[t], NULL);
+    EXPECT_EQ(400000, counter);
+    END;
+}
+
 int main(int argc, char** argv)
 {
-    // LockManagerA_SimpleLocking();
-    // LockManagerA_LocksReleasedOutOfOrder();
-    // LockManagerB_SimpleLocking();
-    // LockManagerB_LocksReleasedOutOfOrder();
+    LockManagerA_SimpleLocking();
+    LockManagerA_LocksReleasedOutOfOrder();
+    LockManagerB_SimpleLocking();
+    LockManagerB_LocksReleasedOutOfOrder();
+    LockManager_RequestsBracket();
+    LockManagerC_LockWords();
+    LockManagerC_MutualExclusion();
+    LockManagerC_LockPlan();
+    LockManagerC_NoWait();
+    LockManagerC_WaitDie();
+    LockManagerC_SpinPark();
 }
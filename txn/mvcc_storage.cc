@@ -1,7 +1,67 @@
 
-
 #include "txn/mvcc_storage.h"
 #include <assert.h>
+#include <thread>
+
+VersionSlab::~VersionSlab()
+{
+    for (int i = 0; i < kShards; i++)
+        for (size_t j = 0; j < shards_[i].chunks_.size(); j++) delete[] shards_[i].chunks_[j];
+}
+
+Version* VersionSlab::Alloc(Key key)
+{
+    Shard* shard = &shards_[key % kShards];
+    shard->mutex_.Lock();
+    if (shard->free_ == nullptr)
+    {
+        Version* chunk = new Version[kChunkVersions];
+        shard->chunks_.push_back(chunk);
+        for (int i = 0; i < kChunkVersions; i++)
+            chunk[i].next_.store(i + 1 < kChunkVersions ? &chunk[i + 1] : nullptr, std::memory_order_relaxed);
+        shard->free_ = chunk;
+    }
+    Version* version = shard->free_;
+    shard->free_     = version->next_.load(std::memory_order_relaxed);
+    shard->mutex_.Unlock();
+    return version;
+}
+
+void VersionSlab::Free(Key key, Version* version)
+{
+    Shard* shard = &shards_[key % kShards];
+    shard->mutex_.Lock();
+    version->next_.store(shard->free_, std::memory_order_relaxed);
+    shard->free_ = version;
+    shard->mutex_.Unlock();
+}
+
+TxnWatermark::TxnWatermark() : next_start_(1), low_(1)
+{
+    for (int i = 0; i < kWindow; i++) done_[i].store(-1, std::memory_order_relaxed);
+}
+
+void TxnWatermark::Start(int id)
+{
+    while (id - LowWatermark() >= kWindow) std::this_thread::yield();
+    for (int skipped = next_start_.load(std::memory_order_relaxed); skipped < id; skipped++)
+        done_[skipped % kWindow].store(skipped, std::memory_order_release);
+    next_start_.store(id + 1, std::memory_order_release);
+}
+
+void TxnWatermark::Finish(int id) { done_[id % kWindow].store(id, std::memory_order_release); }
+
+int TxnWatermark::LowWatermark()
+{
+    mutex_.Lock();
+    int end = next_start_.load(std::memory_order_acquire);
+    while (low_ < end && done_[low_ % kWindow].load(std::memory_order_acquire) == low_) low_++;
+    int low = low_;
+    mutex_.Unlock();
+    return low;
+}
+
+MVCCStorage::MVCCStorage() : heads_(new VersionHead[MAX_DB_SIZE]), snapshot_id_(0), checkpointing_(false) {}
 
 // Init the storage
 void MVCCStorage::InitStorage()
@@ -9,139 +69,233 @@ void MVCCStorage::InitStorage()
     for (int i = 0; i < 1000000; i++)
     {
         Write(i, 0, 0);
-        Mutex* key_mutex = new Mutex();
-        mutexs_[i]       = key_mutex;
     }
 }
 
-// Free memory.
+// Free memory. Versions are owned by the slab.
 MVCCStorage::~MVCCStorage()
 {
-    for (unordered_map<Key, deque<Version*>*>::iterator it = mvcc_data_.begin(); it != mvcc_data_.end(); ++it)
-    {
-        for (deque<Version*>::iterator iter_queue = it->second->begin(); iter_queue != it->second->end(); ++iter_queue)
-        {
-            delete *iter_queue;
-            *iter_queue = nullptr;
-        }
+    delete[] heads_;
+    for (unordered_map<Key, VersionHead*>::iterator it = overflow_.begin(); it != overflow_.end(); ++it)
         delete it->second;
-        it->second = nullptr;
-    }
+    overflow_.clear();
+}
 
-    mvcc_data_.clear();
+MVCCStorage::VersionHead* MVCCStorage::Head(Key key, bool create)
+{
+    if (key < MAX_DB_SIZE) return &heads_[key];
 
-    for (unordered_map<Key, Mutex*>::iterator it = mutexs_.begin(); it != mutexs_.end(); ++it)
-    {
-        delete it->second;
-        it->second = nullptr;
-    }
+    VersionHead* head = nullptr;
+    overflow_mutex_.ReadLock();
+    unordered_map<Key, VersionHead*>::iterator it = overflow_.find(key);
+    if (it != overflow_.end()) head = it->second;
+    overflow_mutex_.Unlock();
+    if (head != nullptr || !create) return head;
 
-    mutexs_.clear();
+    overflow_mutex_.WriteLock();
+    VersionHead*& slot = overflow_[key];
+    if (slot == nullptr) slot = new VersionHead();
+    head = slot;
+    overflow_mutex_.Unlock();
+    return head;
 }
 
-// Lock the key to protect its version_list. Remember to lock the key when you read/update the version_list
-void MVCCStorage::Lock(Key key) { mutexs_[key]->Lock(); }
-// Unlock the key.
-void MVCCStorage::Unlock(Key key) { mutexs_[key]->Unlock(); }
-// MVCC Read
-bool MVCCStorage::Read(Key key, Value* result, int txn_unique_id)
+// Lock the key to protect its version_list. Remember to lock the key when you update the version_list
+void MVCCStorage::Lock(Key key) { Head(key, true)->mutex_.Lock(); }
+// Unlock the key, ending the write (if any) started by CheckWrite().
+void MVCCStorage::Unlock(Key key)
 {
-    //
-    // Implement this method!
+    VersionHead* head = Head(key, false);
+    head->pending_id_.store(0, std::memory_order_release);
+    head->mutex_.Unlock();
+}
 
-    // Hint: Iterate the version_lists and return the verion whose write timestamp
-    // (version_id) is the largest write timestamp less than or equal to txn_unique_id.
-    unordered_map<Key, deque<Version*>*>::iterator iter_map = mvcc_data_.find(key);
-    assert(iter_map != mvcc_data_.end());
+// MVCC Read: returns the version whose write timestamp (version_id) is the
+// largest one less than or equal to txn_unique_id, and raises its max_read_id.
+//
+// Readers don't lock. The race with a writer w (version_id < w <= txn_unique_id)
+// is closed Dekker style: the reader publishes max_read_id and then loads
+// pending_id, w publishes pending_id in CheckWrite() and then loads max_read_id,
+// so either w aborts or the reader waits for w and reads again.
+bool MVCCStorage::Read(Key key, Value* result, int txn_unique_id)
+{
+    VersionHead* head = Head(key, false);
+    if (head == nullptr) return false;
 
-    deque<Version*>::iterator iter_queue = iter_map->second->begin();
-    for (; iter_queue != iter_map->second->end(); ++iter_queue)
+    while (true)
     {
-        if ((*iter_queue)->version_id_ <= txn_unique_id)
+        Version* version = head->newest_.load(std::memory_order_acquire);
+        while (version != nullptr && version->version_id_ > txn_unique_id)
+            version = version->next_.load(std::memory_order_acquire);
+        if (version == nullptr) return false;
+
+        int max_read = version->max_read_id_.load();
+        while (max_read < txn_unique_id && !version->max_read_id_.compare_exchange_weak(max_read, txn_unique_id))
         {
-            *result = (*iter_queue)->value_;
-            if((*iter_queue)->max_read_id_ < txn_unique_id)
-                (*iter_queue)->max_read_id_ = txn_unique_id;
+        }
+
+        int pending = head->pending_id_.load();
+        if (pending == 0 || pending <= version->version_id_ || pending > txn_unique_id)
+        {
+            *result = version->value_.load(std::memory_order_relaxed);
             return true;
         }
+        while (head->pending_id_.load(std::memory_order_acquire) == pending) std::this_thread::yield();
     }
-    assert(false);
-    return true;
 }
 
 // Check whether apply or abort the write
 bool MVCCStorage::CheckWrite(Key key, int txn_unique_id)
 {
-    //
-    // Implement this method!
-
-    // Hint: Before all writes are applied, we need to make sure that each write
+    // Before all writes are applied, we need to make sure that each write
     // can be safely applied based on MVCC timestamp ordering protocol. This method
-    // only checks one key, so you should call this method for each key in the
-    // write_set. Return true if this key passes the check, return false if not.
-    // Note that you don't have to call Lock(key) in this method, just
-    // call Lock(key) before you call this method and call Unlock(key) afterward.
-    unordered_map<Key, deque<Version*>*>::iterator iter_map = mvcc_data_.find(key);
-    assert(iter_map != mvcc_data_.end());
-    deque<Version*>::iterator iter_queue = iter_map->second->begin();
-    for (; iter_queue != iter_map->second->end(); ++iter_queue)
-    {
-        if ((*iter_queue)->version_id_ <= txn_unique_id)
-        {
-            if ((*iter_queue)->max_read_id_ > txn_unique_id)
-                return false;
-            else
-            {
-                return true;
-            }
-        }
-    }       
-    assert(false);
-    return true;
+    // only checks one key, so call this method for each key in the write_set.
+    // Call Lock(key) before you call this method and Unlock(key) afterward.
+    VersionHead* head = Head(key, false);
+    head->pending_id_.store(txn_unique_id);
+
+    Version* version = head->newest_.load(std::memory_order_relaxed);
+    while (version != nullptr && version->version_id_ > txn_unique_id)
+        version = version->next_.load(std::memory_order_relaxed);
+    return version == nullptr || version->max_read_id_.load() <= txn_unique_id;
 }
 
-// MVCC Write, call this method only if CheckWrite return true.
+// MVCC Write, call this method only if CheckWrite return true. InitStorage()
+// also calls this method to init storage.
+// Call Lock(key) before you call this method and Unlock(key) afterward.
 void MVCCStorage::Write(Key key, Value value, int txn_unique_id)
 {
-    //
-    // Implement this method!
-
-    // Hint: Insert a new version (malloc a Version and specify its value/version_id/max_read_id)
-    // into the version_lists. Note that InitStorage() also calls this method to init storage.
-    // Note that you don't have to call Lock(key) in this method, just
-    // call Lock(key) before you call this method and call Unlock(key) afterward.
-    // Note that the performance would be much better if you organize the versions in decreasing order.
-    
-    unordered_map<Key, deque<Version*>*>::iterator iter_map = mvcc_data_.find(key);
-    if (iter_map != mvcc_data_.end())
+    VersionHead* head = Head(key, true);
+
+    // Versions are in decreasing order, the new one usually becomes the head.
+    Version* prev = nullptr;
+    Version* next = head->newest_.load(std::memory_order_relaxed);
+    while (next != nullptr && next->version_id_ > txn_unique_id)
     {
-        deque<Version*>::iterator iter_que = iter_map->second->begin();
-        for(; iter_que != iter_map->second->end(); ++iter_que)
-        {
-            if ((*iter_que)->version_id_ <= txn_unique_id)
-            {
-                if ((*iter_que)->version_id_ == txn_unique_id)
-                {
-                    (*iter_que)->value_ = value;
-                }
-                else
-                {
-                    Version* new_ver = new Version;
-                    *new_ver = {value, txn_unique_id, txn_unique_id};  
-                    iter_map->second->insert(iter_que, new_ver);
-                }
-                return;
-            }
-        }
-        assert(false);
+        prev = next;
+        next = next->next_.load(std::memory_order_relaxed);
     }
-    else
+    if (next != nullptr && next->version_id_ == txn_unique_id)
     {
-        Version* new_ver = new Version;
-        *new_ver = {value, txn_unique_id, txn_unique_id};
-        deque<Version*>* new_queue = new deque<Version*>;
-        new_queue->push_back(new_ver);
-        mvcc_data_.insert(std::make_pair(key, new_queue));
+        next->value_.store(value, std::memory_order_relaxed);
         return;
     }
+
+    if ((next != nullptr || prev != nullptr) && !head->dirty_)
+    {
+        head->dirty_ = true;
+        dirty_keys_.Push(key);
+    }
+
+    Version* version = slab_.Alloc(key);
+    version->value_.store(value, std::memory_order_relaxed);
+    version->max_read_id_.store(txn_unique_id, std::memory_order_relaxed);
+    version->version_id_ = txn_unique_id;
+    version->next_.store(next, std::memory_order_relaxed);
+
+    // Publish only once the version is complete.
+    if (prev == nullptr)
+        head->newest_.store(version, std::memory_order_release);
+    else
+        prev->next_.store(version, std::memory_order_release);
+}
+
+// Called while no txn runs, so the newest versions are the image.
+void MVCCStorage::BeginCheckpoint()
+{
+    snapshot_id_ = 0;
+    for (int i = 0; i < MAX_DB_SIZE; i++)
+    {
+        Version* version = heads_[i].newest_.load(std::memory_order_acquire);
+        if (version != nullptr && version->version_id_ > snapshot_id_) snapshot_id_ = version->version_id_;
+    }
+    for (unordered_map<Key, VersionHead*>::iterator it = overflow_.begin(); it != overflow_.end(); ++it)
+    {
+        Version* version = it->second->newest_.load(std::memory_order_acquire);
+        if (version != nullptr && version->version_id_ > snapshot_id_) snapshot_id_ = version->version_id_;
+    }
+    checkpointing_.store(true);
+}
+
+void MVCCStorage::EndCheckpoint() { checkpointing_.store(false); }
+
+void MVCCStorage::ScanCheckpoint(const std::function<void(Key, Value)>& fn)
+{
+    for (int i = 0; i < MAX_DB_SIZE; i++)
+    {
+        Version* version = heads_[i].newest_.load(std::memory_order_acquire);
+        while (version != nullptr && version->version_id_ > snapshot_id_)
+            version = version->next_.load(std::memory_order_acquire);
+        if (version != nullptr) fn(i, version->value_.load(std::memory_order_relaxed));
+    }
+    overflow_mutex_.ReadLock();
+    for (unordered_map<Key, VersionHead*>::iterator it = overflow_.begin(); it != overflow_.end(); ++it)
+    {
+        Version* version = it->second->newest_.load(std::memory_order_acquire);
+        while (version != nullptr && version->version_id_ > snapshot_id_)
+            version = version->next_.load(std::memory_order_acquire);
+        if (version != nullptr) fn(it->first, version->value_.load(std::memory_order_relaxed));
+    }
+    overflow_mutex_.Unlock();
+}
+
+// Readers with id >= 'low_watermark' stop at the newest version with id <=
+// 'low_watermark' at the latest, so the versions behind it can be reused
+// right away.
+void MVCCStorage::CollectGarbage(int low_watermark)
+{
+    if (checkpointing_.load() && snapshot_id_ < low_watermark) low_watermark = snapshot_id_;
+
+    MVCCGCStats stats;
+    Key key;
+    for (int n = dirty_keys_.Size(); n > 0 && dirty_keys_.Pop(&key); n--)
+    {
+        VersionHead* head = Head(key, false);
+        uint64 length     = 0;
+        Version* garbage  = nullptr;
+
+        head->mutex_.Lock();
+        Version* version = head->newest_.load(std::memory_order_relaxed);
+        for (; version != nullptr && version->version_id_ > low_watermark; ++length)
+            version = version->next_.load(std::memory_order_relaxed);
+        if (version != nullptr)
+        {
+            garbage = version->next_.load(std::memory_order_relaxed);
+            version->next_.store(nullptr, std::memory_order_release);
+            ++length;
+        }
+        // Keys with versions newer than the watermark are visited again.
+        head->dirty_ = length > 1;
+        if (head->dirty_) dirty_keys_.Push(key);
+        head->mutex_.Unlock();
+
+        while (garbage != nullptr)
+        {
+            Version* next = garbage->next_.load(std::memory_order_relaxed);
+            slab_.Free(key, garbage);
+            garbage = next;
+            ++length;
+            ++stats.versions_reclaimed_;
+        }
+
+        ++stats.keys_visited_;
+        stats.chain_length_sum_ += length;
+        if (length > stats.max_chain_length_) stats.max_chain_length_ = length;
+    }
+
+    gc_mutex_.Lock();
+    gc_stats_.runs_++;
+    gc_stats_.keys_visited_ += stats.keys_visited_;
+    gc_stats_.versions_reclaimed_ += stats.versions_reclaimed_;
+    gc_stats_.chain_length_sum_ += stats.chain_length_sum_;
+    if (stats.max_chain_length_ > gc_stats_.max_chain_length_) gc_stats_.max_chain_length_ = stats.max_chain_length_;
+    gc_mutex_.Unlock();
+}
+
+MVCCGCStats MVCCStorage::GCStats()
+{
+    gc_mutex_.Lock();
+    MVCCGCStats stats = gc_stats_;
+    gc_mutex_.Unlock();
+    return stats;
 }
@@ -2,14 +2,100 @@
 #ifndef _MVCC_STORAGE_H_
 #define _MVCC_STORAGE_H_
 
+#include <atomic>
+#include <vector>
+
 #include "txn/storage.h"
+#include "utils/atomic.h"
+#include "utils/global.h"
+
+using std::vector;
 
-// MVCC 'version' structure
+// MVCC 'version' structure. Versions of a key form a singly linked list,
+// newest (largest version_id_) first. Readers walk the list without taking
+// the key's lock, so the fields they look at are atomic.
 struct Version
 {
-    Value value_;      // The value of this version
-    int max_read_id_;  // Largest timestamp of a transaction that read the version
-    int version_id_;   // Timestamp of the transaction that created(wrote) the version
+    std::atomic<Value> value_;      // The value of this version
+    std::atomic<int> max_read_id_;  // Largest timestamp of a transaction that read the version
+    int version_id_;                // Timestamp of the transaction that created(wrote) the version
+    std::atomic<Version*> next_;    // Next older version (or next free version in the slab)
+};
+
+// Allocates Versions from large chunks instead of one heap allocation per
+// write. Free lists are sharded by key so writers of different keys rarely
+// share a mutex. Chunks are only returned to the heap when the slab dies.
+class VersionSlab
+{
+   public:
+    VersionSlab() {}
+    ~VersionSlab();
+
+    Version* Alloc(Key key);
+    void Free(Key key, Version* version);
+
+   private:
+    static const int kShards        = 64;
+    static const int kChunkVersions = 4096;
+
+    struct Shard
+    {
+        Shard() : free_(nullptr) {}
+        Mutex mutex_;
+        Version* free_;
+        vector<Version*> chunks_;
+    };
+
+    Shard shards_[kShards];
+
+    DISALLOW_CLASS_COPY_AND_ASSIGN(VersionSlab);
+};
+
+// Tracks the low watermark of the txns reading from an MVCCStorage: the
+// smallest id that may still read. Txns start in increasing id order, from a
+// single thread, and may finish in any order. Versions that aren't visible at
+// the watermark are garbage.
+class TxnWatermark
+{
+   public:
+    TxnWatermark();
+
+    // Called before txn 'id' reads. Ids skipped between two calls count as
+    // finished. Blocks while 'id' is more than kWindow ids ahead of the
+    // watermark.
+    void Start(int id);
+
+    // Called once txn 'id' doesn't read anymore.
+    void Finish(int id);
+
+    // Returns an id such that all txns with smaller ids have finished and no
+    // txn with a smaller id will start.
+    int LowWatermark();
+
+   private:
+    static const int kWindow = 1 << 16;
+
+    // done_[id % kWindow] == id once txn 'id' has finished.
+    std::atomic<int> done_[kWindow];
+    std::atomic<int> next_start_;
+
+    // Guards 'low_', which LowWatermark() advances over finished ids.
+    Mutex mutex_;
+    int low_;
+
+    DISALLOW_CLASS_COPY_AND_ASSIGN(TxnWatermark);
+};
+
+// Garbage collection counters of an MVCCStorage.
+struct MVCCGCStats
+{
+    MVCCGCStats() : runs_(0), keys_visited_(0), versions_reclaimed_(0), chain_length_sum_(0), max_chain_length_(0) {}
+
+    uint64 runs_;
+    uint64 keys_visited_;        // keys whose version chain was inspected
+    uint64 versions_reclaimed_;  // versions returned to the slab
+    uint64 chain_length_sum_;    // chain lengths of the visited keys, before collection
+    uint64 max_chain_length_;
 };
 
 // MVCC storage
@@ -19,6 +105,7 @@ class MVCCStorage : public Storage
     // If there exists a record for the specified key, sets '*result' equal to
     // the value associated with the key and returns true, else returns false;
     // The third parameter is the txn_unique_id(txn timestamp), which is used for MVCC.
+    // Doesn't take the key's lock.
     virtual bool Read(Key key, Value* result, int txn_unique_id = 0);
 
     // Inserts a new version with key and value
@@ -40,16 +127,61 @@ class MVCCStorage : public Storage
     // Check whether apply or abort the write
     virtual bool CheckWrite(Key key, int txn_unique_id);
 
+    // Checkpoints read the versions visible to the newest txn that had written
+    // when the checkpoint began, so no pre-images are needed.
+    virtual void BeginCheckpoint();
+    virtual void ScanCheckpoint(const std::function<void(Key, Value)>& fn);
+    virtual void EndCheckpoint();
+
+    // Reclaims the versions no txn with id >= 'low_watermark' can read, that
+    // is all but the newest version with id <= 'low_watermark' and the newer
+    // ones. Only keys written since they were last collected are visited.
+    // Safe to run concurrently with txns, but not with another collection.
+    void CollectGarbage(int low_watermark);
+
+    MVCCGCStats GCStats();
+
+    MVCCStorage();
     virtual ~MVCCStorage();
 
    private:
     friend class TxnProcessor;
 
-    // Storage for MVCC, each key has a linklist of versions
-    unordered_map<Key, deque<Version*>*> mvcc_data_;
+    // Per key state. 'pending_id_' is the timestamp of the txn between
+    // CheckWrite() and Unlock() on the key (0 if none): a reader that would
+    // see that txn's write waits for it instead of reading past it.
+    struct VersionHead
+    {
+        VersionHead() : newest_(nullptr), pending_id_(0), dirty_(false) {}
+        std::atomic<Version*> newest_;
+        std::atomic<int> pending_id_;
+        // Set when the key is queued in 'dirty_keys_', guarded by 'mutex_'.
+        bool dirty_;
+        Mutex mutex_;
+    };
+
+    // Returns the head of 'key', creating it if 'create' is set (else nullptr
+    // for unknown keys).
+    VersionHead* Head(Key key, bool create);
+
+    // Heads of the keys below MAX_DB_SIZE live in one array; others (rare) in
+    // a map guarded by 'overflow_mutex_'.
+    VersionHead* heads_;
+    unordered_map<Key, VersionHead*> overflow_;
+    MutexRW overflow_mutex_;
+
+    VersionSlab slab_;
+
+    // Keys with more than one version, to be visited by the next collection.
+    AtomicQueue<Key> dirty_keys_;
+
+    // Newest version id when the running checkpoint began. The collector
+    // doesn't go past it while 'checkpointing_' is set.
+    int snapshot_id_;
+    std::atomic<bool> checkpointing_;
 
-    // Mutexs for each key
-    unordered_map<Key, Mutex*> mutexs_;
+    Mutex gc_mutex_;  // guards 'gc_stats_'
+    MVCCGCStats gc_stats_;
 };
 
 #endif  // _MVCC_STORAGE_H_
@@ -0,0 +1,238 @@
+#include "txn/mvcc_storage.h"
+
+#include <pthread.h>
+#include <set>
+
+#include "txn/load_generator.h"
+#include "txn/txn_processor.h"
+#include "utils/testing.h"
+
+using std::set;
+
+TEST(MVCCStorage_VersionVisibility)
+{
+    MVCCStorage storage;
+    Value value;
+    storage.Write(1, 10, 0);
+    storage.Write(1, 30, 30);
+    storage.Write(1, 20, 20);  // inserted between existing versions
+
+    EXPECT_TRUE(storage.Read(1, &value, 5));
+    EXPECT_EQ(10, value);
+    EXPECT_TRUE(storage.Read(1, &value, 25));
+    EXPECT_EQ(20, value);
+    EXPECT_TRUE(storage.Read(1, &value, 40));
+    EXPECT_EQ(30, value);
+    EXPECT_FALSE(storage.Read(2, &value, 40));
+
+    // Keys beyond the inline heads work the same way.
+    storage.Write(MAX_DB_SIZE + 7, 1, 3);
+    EXPECT_FALSE(storage.Read(MAX_DB_SIZE + 7, &value, 2));
+    EXPECT_TRUE(storage.Read(MAX_DB_SIZE + 7, &value, 3));
+    EXPECT_EQ(1, value);
+    END;
+}
+
+TEST(MVCCStorage_CheckWrite)
+{
+    MVCCStorage storage;
+    Value value;
+    storage.Write(1, 0, 0);
+    storage.Write(1, 50, 50);
+
+    // Txn 10 read version 0, so txn 5 can't write behind it...
+    EXPECT_TRUE(storage.Read(1, &value, 10));
+    storage.Lock(1);
+    EXPECT_FALSE(storage.CheckWrite(1, 5));
+    storage.Unlock(1);
+
+    // ... but txn 20 can, and becomes visible to later readers.
+    storage.Lock(1);
+    EXPECT_TRUE(storage.CheckWrite(1, 20));
+    storage.Write(1, 20, 20);
+    storage.Unlock(1);
+    EXPECT_TRUE(storage.Read(1, &value, 30));
+    EXPECT_EQ(20, value);
+
+    // The version read by txn 60 is the newest one, so txn 55 is rejected.
+    EXPECT_TRUE(storage.Read(1, &value, 60));
+    EXPECT_EQ(50, value);
+    storage.Lock(1);
+    EXPECT_FALSE(storage.CheckWrite(1, 55));
+    storage.Unlock(1);
+    END;
+}
+
+// Lock-free readers racing a writer. Afterwards, no committed write may fall
+// between the version a reader saw and the reader's own timestamp.
+struct ReadRecord
+{
+    Key key;
+    int id;
+    Value value;
+};
+
+struct ReaderArgs
+{
+    MVCCStorage* storage;
+    std::atomic<int>* clock;
+    vector<ReadRecord> reads;
+};
+
+static const int kWrites = 20000;
+
+static void* ReaderThread(void* arg)
+{
+    ReaderArgs* args = reinterpret_cast<ReaderArgs*>(arg);
+    for (int i = 0; i < kWrites; i++)
+    {
+        // Versions have value == id. Readers use odd ids just ahead of the writer.
+        ReadRecord read;
+        read.key = i % 16;
+        read.id  = args->clock->load() + 1 + 2 * (i % 8);
+        if (!args->storage->Read(read.key, &read.value, read.id)) read.value = kWrites * 4;
+        args->reads.push_back(read);
+    }
+    return NULL;
+}
+
+TEST(MVCCStorage_ConcurrentReaders)
+{
+    MVCCStorage storage;
+    std::atomic<int> clock(0);
+    for (Key k = 0; k < 16; k++) storage.Write(k, 0, 0);
+
+    ReaderArgs args[4];
+    pthread_t threads[4];
+    for (int t = 0; t < 4; t++)
+    {
+        args[t].storage = &storage;
+        args[t].clock   = &clock;
+        pthread_create(&threads[t], NULL, ReaderThread, &args[t]);
+    }
+
+    map<Key, set<int> > committed;
+    for (int i = 1; i < kWrites; i++)
+    {
+        Key key = i % 16;
+        clock.store(2 * i);
+        storage.Lock(key);
+        if (storage.CheckWrite(key, 2 * i))
+        {
+            storage.Write(key, 2 * i, 2 * i);
+            committed[key].insert(2 * i);
+        }
+        storage.Unlock(key);
+    }
+
+    int errors = 0;
+    for (int t = 0; t < 4; t++)
+    {
+        pthread_join(threads[t], NULL);
+        for (size_t i = 0; i < args[t].reads.size(); i++)
+        {
+            const ReadRecord& read = args[t].reads[i];
+            set<int>& writes       = committed[read.key];
+            set<int>::iterator it  = writes.upper_bound(static_cast<int>(read.value));
+            if (read.value > static_cast<Value>(read.id) || (it != writes.end() && *it <= read.id)) errors++;
+        }
+    }
+    EXPECT_EQ(0, errors);
+    END;
+}
+
+TEST(TxnWatermark_OutOfOrderFinish)
+{
+    TxnWatermark watermark;
+    EXPECT_EQ(1, watermark.LowWatermark());
+
+    watermark.Start(1);
+    watermark.Start(2);
+    watermark.Start(5);  // 3 and 4 never run
+    watermark.Finish(2);
+    EXPECT_EQ(1, watermark.LowWatermark());
+    watermark.Finish(1);
+    EXPECT_EQ(5, watermark.LowWatermark());
+    watermark.Finish(5);
+    EXPECT_EQ(6, watermark.LowWatermark());
+
+    // Ids wrap around the window.
+    for (int id = 6; id < 200000; id++)
+    {
+        watermark.Start(id);
+        watermark.Finish(id);
+    }
+    EXPECT_EQ(200000, watermark.LowWatermark());
+    END;
+}
+
+TEST(MVCCStorage_CollectGarbage)
+{
+    MVCCStorage storage;
+    Value value;
+    for (int id = 0; id <= 100; id += 10)
+    {
+        storage.Lock(1);
+        storage.Write(1, id, id);
+        storage.Unlock(1);
+    }
+    storage.Write(2, 0, 0);
+
+    // Txns from 45 on need version 40 and the newer ones.
+    storage.CollectGarbage(45);
+    MVCCGCStats stats = storage.GCStats();
+    EXPECT_EQ(1, stats.runs_);
+    EXPECT_EQ(1, stats.keys_visited_);
+    EXPECT_EQ(4, stats.versions_reclaimed_);
+    EXPECT_EQ(11, stats.max_chain_length_);
+    EXPECT_TRUE(storage.Read(1, &value, 45));
+    EXPECT_EQ(40, value);
+    EXPECT_TRUE(storage.Read(1, &value, 100));
+    EXPECT_EQ(100, value);
+    EXPECT_FALSE(storage.Read(1, &value, 39));
+
+    // Only the newest version is left once the watermark passes it, and the
+    // key isn't visited again until it is written.
+    storage.CollectGarbage(1000);
+    storage.CollectGarbage(1000);
+    stats = storage.GCStats();
+    EXPECT_EQ(3, stats.runs_);
+    EXPECT_EQ(2, stats.keys_visited_);
+    EXPECT_EQ(10, stats.versions_reclaimed_);
+    EXPECT_TRUE(storage.Read(1, &value, 1000));
+    EXPECT_EQ(100, value);
+    END;
+}
+
+// Long MVCC runs keep the version lists short.
+TEST(MVCCProcessor_GarbageCollection)
+{
+    TxnProcessorOptions options;
+    options.gc_interval_ = 0.001;
+    TxnProcessor p(MVCC, options);
+
+    RMWLoadGen lg(10, 0, 2, 0.00001);
+    for (int i = 0; i < 2000; i++) p.NewTxnRequest(lg.NewTxn());
+    for (int i = 0; i < 2000; i++)
+    {
+        Txn* txn = p.GetTxnResult();
+        EXPECT_EQ(COMMITTED, txn->Status());
+        delete txn;
+    }
+    Sleep(0.01);
+
+    MVCCGCStats stats = p.GCStats();
+    EXPECT_TRUE(stats.runs_ > 0);
+    EXPECT_TRUE(stats.versions_reclaimed_ > 3000);
+    END;
+}
+
+int main(int argc, char** argv)
+{
+    MVCCStorage_VersionVisibility();
+    MVCCStorage_CheckWrite();
+    MVCCStorage_ConcurrentReaders();
+    TxnWatermark_OutOfOrderFinish();
+    MVCCStorage_CollectGarbage();
+    MVCCProcessor_GarbageCollection();
+}
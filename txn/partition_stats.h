@@ -0,0 +1,40 @@
+// Profile of the STRIFE partitioner, shared by the clusterers and the txn_processor
+
+#ifndef _PARTITION_STATS_H_
+#define _PARTITION_STATS_H_
+
+#include "txn/common.h"
+#include "utils/histogram.h"
+#include "utils/perf_counters.h"
+
+
+// phases of PartitionBatch, in the order they run
+enum PartitionPhase
+{
+    PHASE_PREPARE = 0,
+    PHASE_SPOT,
+    PHASE_FUSE,
+    PHASE_MERGE,
+    PHASE_ALLOCATE,
+    PHASE_CLEANUP,
+    NUM_PARTITION_PHASES,
+};
+
+const char* PartitionPhaseToString(PartitionPhase phase);
+
+// profile of the partitioned batches, one sample per batch in every histogram
+struct PartitionStats
+{
+    PartitionStats() : batches_(0) {};
+    uint64 batches_;
+    Histogram phase_cycles_[NUM_PARTITION_PHASES];  // CycleClock ticks spent in each phase
+    PerfSample phase_events_[NUM_PARTITION_PHASES];  // hardware counters of each phase, summed (see EnablePerfCounters)
+    Histogram txns_;  // txns in the batch
+    Histogram data_nodes_;  // distinct keys written by the batch
+    Histogram special_clusters_;  // special clusters picked by Spot
+    Histogram merges_;  // special clusters joined by Merge
+    Histogram clusters_;  // conflict free queues handed to the workers
+    Histogram residuals_;  // txns left for the serial residual phase
+};
+
+#endif
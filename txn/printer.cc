@@ -3,7 +3,7 @@
 string LstToStr(AtomicQueue<Txn*> lst) {
 
     Txn *t; 
-    std::set<Key>::iterator it;
+    KeySet::const_iterator it;
     string s = "";
     while (lst.Size() > 0) {
         lst.Pop(&t);
@@ -32,7 +32,7 @@ void PrintResult(AtomicQueue<AtomicQueue<Txn*>*> worklist, AtomicQueue<Txn*> res
 
     std::cout << "worklist\n";
     int i = 0;
-    std::set<Key>::iterator it;
+    KeySet::const_iterator it;
 	while (worklist.Size() > 0) {
         std::cout << "list" << i << " Write Set\n";
         i += 1;
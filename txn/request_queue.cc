@@ -0,0 +1,141 @@
+#include "txn/request_queue.h"
+
+#include <utility>
+#include <vector>
+
+#include "utils/cycle_clock.h"
+
+static std::atomic<uint64> next_queue_id(1);
+
+RequestQueue::RequestQueue() : id_(next_queue_id.fetch_add(1)), num_rings_(0), next_unique_id_(1), next_ring_(0)
+{
+    for (int i = 0; i < kMaxProducers; i++) rings_[i].store(nullptr, std::memory_order_relaxed);
+}
+
+RequestQueue::~RequestQueue()
+{
+    for (int i = 0; i < kMaxProducers; i++) delete rings_[i].load();
+}
+
+RequestQueue::Producer* RequestQueue::LocalProducer()
+{
+    // (queue id, producer) of the queues this thread submitted to, newest last.
+    static thread_local std::vector<std::pair<uint64, Producer*> > cache;
+    for (size_t i = cache.size(); i-- > 0;)
+        if (cache[i].first == id_) return cache[i].second;
+
+    Producer* producer = nullptr;
+    int index          = num_rings_.fetch_add(1);
+    if (index < kMaxProducers)
+    {
+        producer = new Producer();
+        rings_[index].store(producer, std::memory_order_release);
+    }
+    cache.push_back(std::make_pair(id_, producer));
+    return producer;
+}
+
+void RequestQueue::Push(Txn* txn)
+{
+    Producer* producer = LocalProducer();
+    if (producer == nullptr)
+    {
+        shared_.Push(txn);
+        return;
+    }
+    // Once spilled, keep spilling until the scheduler has drained the
+    // overflow, or this txn would overtake the spilled ones.
+    if (!producer->spilled_.load(std::memory_order_acquire) && producer->ring_.TryPush(txn)) return;
+    producer->mutex_.Lock();
+    producer->overflow_.push_back(txn);
+    producer->spilled_.store(true, std::memory_order_release);
+    producer->mutex_.Unlock();
+}
+
+void RequestQueue::PushShared(Txn* txn) { shared_.Push(txn); }
+
+void RequestQueue::GatherFrom(Producer* producer, size_t quota)
+{
+    Txn* txn;
+    size_t i = 0;
+    for (; i < quota && producer->ring_.TryPop(&txn); i++)
+    {
+        txn->unique_id_ = next_unique_id_++;
+        backlog_.push_back(txn);
+    }
+    // The overflow is newer than anything in the ring, so it only goes once
+    // the ring is empty.
+    if (i == quota || !producer->spilled_.load(std::memory_order_acquire)) return;
+    producer->mutex_.Lock();
+    for (; i < quota && !producer->overflow_.empty(); i++)
+    {
+        txn = producer->overflow_.front();
+        producer->overflow_.pop_front();
+        txn->unique_id_ = next_unique_id_++;
+        backlog_.push_back(txn);
+    }
+    if (producer->overflow_.empty()) producer->spilled_.store(false, std::memory_order_release);
+    producer->mutex_.Unlock();
+}
+
+bool RequestQueue::Gather(size_t limit)
+{
+    if (backlog_.size() >= limit) return false;
+    size_t before = backlog_.size();
+
+    // Restarts first, then the rings round-robin from where the last gather
+    // stopped, a bounded number of txns from each.
+    Txn* txn;
+    while (backlog_.size() < limit && shared_.Pop(&txn))
+    {
+        txn->unique_id_ = next_unique_id_++;
+        backlog_.push_back(txn);
+    }
+
+    int num_rings = num_rings_.load(std::memory_order_acquire);
+    if (num_rings > kMaxProducers) num_rings = kMaxProducers;
+    for (int n = 0; n < num_rings && backlog_.size() < limit; n++)
+    {
+        Producer* producer = rings_[next_ring_].load(std::memory_order_acquire);
+        next_ring_         = (next_ring_ + 1) % num_rings;
+        if (producer == nullptr) continue;
+
+        size_t quota = (limit - backlog_.size()) / (num_rings - n);
+        if (quota == 0) quota = 1;
+        GatherFrom(producer, quota);
+    }
+    return backlog_.size() > before;
+}
+
+bool RequestQueue::Pop(Txn** txn)
+{
+    if (backlog_.empty()) Gather(kGatherLimit);
+    if (backlog_.empty()) return false;
+    *txn = backlog_.front();
+    backlog_.pop_front();
+    (*txn)->stage_time_[TXN_BATCHED] = CycleClock::Now();
+    return true;
+}
+
+int RequestQueue::Pop_n(AtomicQueue<Txn*>& result, int n)
+{
+    // A gather takes at most a quota of each ring, keep going until the batch
+    // is full or nothing is pending.
+    while ((int)backlog_.size() < n)
+        if (!Gather(n)) break;
+    uint64 now = CycleClock::Now();
+    int popped = 0;
+    for (; popped < n && !backlog_.empty(); popped++)
+    {
+        backlog_.front()->stage_time_[TXN_BATCHED] = now;
+        result.Push(backlog_.front());
+        backlog_.pop_front();
+    }
+    return popped;
+}
+
+int RequestQueue::Size()
+{
+    Gather(kGatherLimit);
+    return backlog_.size();
+}
@@ -0,0 +1,94 @@
+// Incoming txn requests of a TxnProcessor. Every client thread submits into
+// its own lock-free SPSC ring, so producers never share a lock; the scheduler
+// thread (the only consumer) gathers the rings round-robin into a private
+// backlog, stamping each txn with the next unique id as it goes. Ids are thus
+// assigned without atomics, and requests leave the queue in id order, which
+// the MVCC watermark relies on.
+//
+// A producer whose ring is full (e.g. a result callback resubmitting from a
+// worker while the scheduler waits on that worker) never blocks: it spills
+// into its ring's mutex guarded overflow, which the scheduler drains once the
+// ring is empty, so each producer's txns still leave in submission order.
+//
+// Threads beyond kMaxProducers, and txns resubmitted by workers (restarts),
+// go through a shared mutex guarded queue instead. Rings are not recycled:
+// once kMaxProducers threads have pushed, later threads use the shared queue
+// for the life of the RequestQueue, and every thread keeps one cache entry
+// per RequestQueue it pushed to (see LocalProducer()).
+
+#ifndef _REQUEST_QUEUE_H_
+#define _REQUEST_QUEUE_H_
+
+#include <atomic>
+#include <deque>
+
+#include "txn/txn.h"
+#include "utils/atomic.h"
+#include "utils/global.h"
+#include "utils/mutex.h"
+
+using std::deque;
+
+class RequestQueue
+{
+   public:
+    RequestQueue();
+    // Txns still queued are not deleted.
+    ~RequestQueue();
+
+    // Producer side, from any thread. Never blocks on a full ring.
+    void Push(Txn* txn);
+
+    // Producer side for txns that must not wait on a full ring (workers
+    // restarting a txn).
+    void PushShared(Txn* txn);
+
+    // Consumer side, only from the scheduler thread. Popped txns are stamped
+    // TXN_BATCHED.
+    bool Pop(Txn** txn);
+    int Pop_n(AtomicQueue<Txn*>& result, int n);
+    int Size();
+
+    static const int kMaxProducers   = 64;
+    static const size_t kRingSize    = 4096;
+    static const size_t kGatherLimit = 4096;
+
+   private:
+    // The ring of one producer thread, and where it spills when full.
+    struct Producer
+    {
+        Producer() : ring_(kRingSize), spilled_(false) {}
+        SpscRing<Txn*> ring_;
+        std::atomic<bool> spilled_;  // overflow_ may be non-empty, newer than the ring
+        Mutex mutex_;
+        deque<Txn*> overflow_;
+    };
+
+    // Returns the calling thread's producer, registering one on first use
+    // (nullptr once kMaxProducers exist).
+    Producer* LocalProducer();
+
+    // Moves pending requests into 'backlog_' until it holds 'limit' txns.
+    // Returns false if nothing was pending.
+    bool Gather(size_t limit);
+
+    // Moves up to 'quota' of the producer's requests into 'backlog_'.
+    void GatherFrom(Producer* producer, size_t quota);
+
+    // Distinguishes queues in the threads' ring caches, even when a queue is
+    // allocated where a destroyed one was.
+    uint64 id_;
+
+    std::atomic<Producer*> rings_[kMaxProducers];
+    std::atomic<int> num_rings_;
+    AtomicQueue<Txn*> shared_;
+
+    // Consumer state.
+    deque<Txn*> backlog_;
+    uint64 next_unique_id_;
+    int next_ring_;
+
+    DISALLOW_CLASS_COPY_AND_ASSIGN(RequestQueue);
+};
+
+#endif  // _REQUEST_QUEUE_H_
@@ -0,0 +1,158 @@
+#include "txn/request_queue.h"
+
+#include <pthread.h>
+#include <map>
+
+#include "txn/txn_processor.h"
+#include "txn/txn_types.h"
+#include "utils/testing.h"
+
+using std::map;
+
+static const int kTxnsPerProducer = 5000;
+
+struct ProducerArgs
+{
+    RequestQueue* queue;
+    vector<Txn*> txns;
+};
+
+static void* Produce(void* arg)
+{
+    ProducerArgs* args = reinterpret_cast<ProducerArgs*>(arg);
+    for (size_t i = 0; i < args->txns.size(); i++) args->queue->Push(args->txns[i]);
+    return NULL;
+}
+
+// 'num_producers' threads push concurrently with the consumer; ids must be
+// 1, 2, ... in pop order and every producer's txns must come out in order.
+static void CheckProducers(int num_producers)
+{
+    RequestQueue queue;
+    vector<ProducerArgs> args(num_producers);
+    map<Txn*, std::pair<int, int> > origin;
+    for (int p = 0; p < num_producers; p++)
+    {
+        args[p].queue = &queue;
+        for (int i = 0; i < kTxnsPerProducer; i++)
+        {
+            Txn* txn = new Noop();
+            args[p].txns.push_back(txn);
+            origin[txn] = std::make_pair(p, i);
+        }
+    }
+
+    vector<pthread_t> threads(num_producers);
+    for (int p = 0; p < num_producers; p++) pthread_create(&threads[p], NULL, Produce, &args[p]);
+
+    vector<int> next(num_producers, 0);
+    uint64 expected_id = 1;
+    int total          = num_producers * kTxnsPerProducer;
+    AtomicQueue<Txn*> batch;
+    while ((int)expected_id <= total)
+    {
+        Txn* txn;
+        if (expected_id % 2 == 0 ? !queue.Pop(&txn) : queue.Pop_n(batch, 1) == 0 || !batch.Pop(&txn)) continue;
+        EXPECT_EQ(expected_id, txn->unique_id_);
+        ++expected_id;
+        std::pair<int, int> from = origin[txn];
+        EXPECT_EQ(next[from.first], from.second);
+        next[from.first] = from.second + 1;
+    }
+    for (int p = 0; p < num_producers; p++) pthread_join(threads[p], NULL);
+    EXPECT_EQ(0, queue.Size());
+    for (map<Txn*, std::pair<int, int> >::iterator it = origin.begin(); it != origin.end(); ++it) delete it->first;
+}
+
+TEST(RequestQueue_Producers)
+{
+    CheckProducers(1);
+    CheckProducers(8);
+    END;
+}
+
+TEST(RequestQueue_MoreProducersThanRings)
+{
+    CheckProducers(RequestQueue::kMaxProducers + 4);
+    END;
+}
+
+TEST(RequestQueue_SharedFirst)
+{
+    RequestQueue queue;
+    Noop a, b, c;
+    queue.Push(&a);
+    queue.PushShared(&b);
+    queue.Push(&c);
+
+    // Restarts are gathered ahead of the rings.
+    Txn* txn;
+    EXPECT_TRUE(queue.Pop(&txn));
+    EXPECT_TRUE(txn == &b);
+    EXPECT_EQ(1, txn->unique_id_);
+    EXPECT_EQ(2, queue.Size());
+    EXPECT_TRUE(queue.Pop(&txn));
+    EXPECT_TRUE(txn == &a);
+    EXPECT_TRUE(queue.Pop(&txn));
+    EXPECT_TRUE(txn == &c);
+    EXPECT_EQ(3, txn->unique_id_);
+    EXPECT_FALSE(queue.Pop(&txn));
+    END;
+}
+
+// Producers that fill their rings spill over without blocking, and a single
+// Pop_n takes a whole STRIFE batch across several gathers, in order.
+TEST(RequestQueue_FullBatch)
+{
+    RequestQueue queue;
+    int num_producers = 2;
+    int per_producer  = RequestQueue::kRingSize + 500;
+    vector<ProducerArgs> args(num_producers);
+    map<Txn*, std::pair<int, int> > origin;
+    for (int p = 0; p < num_producers; p++)
+    {
+        args[p].queue = &queue;
+        for (int i = 0; i < per_producer; i++)
+        {
+            Txn* txn = new Noop();
+            args[p].txns.push_back(txn);
+            origin[txn] = std::make_pair(p, i);
+        }
+    }
+    // Nothing consumes while they push.
+    vector<pthread_t> threads(num_producers);
+    for (int p = 0; p < num_producers; p++) pthread_create(&threads[p], NULL, Produce, &args[p]);
+    for (int p = 0; p < num_producers; p++) pthread_join(threads[p], NULL);
+
+    int total = num_producers * per_producer;
+    EXPECT_TRUE(total > (int)RequestQueue::kGatherLimit && total <= BATCH_SIZE);
+    AtomicQueue<Txn*> batch;
+    int popped = queue.Pop_n(batch, BATCH_SIZE);
+    EXPECT_EQ(total, popped);
+    vector<int> next(num_producers, 0);
+    Txn* txn;
+    for (uint64 id = 1; batch.Pop(&txn); id++)
+    {
+        EXPECT_EQ(id, txn->unique_id_);
+        std::pair<int, int> from = origin[txn];
+        EXPECT_EQ(next[from.first], from.second);
+        next[from.first] = from.second + 1;
+    }
+    EXPECT_EQ(0, queue.Size());
+
+    // Once drained, a producer goes back to its ring.
+    Noop a;
+    queue.Push(&a);
+    EXPECT_TRUE(queue.Pop(&txn));
+    EXPECT_TRUE(txn == &a);
+    for (map<Txn*, std::pair<int, int> >::iterator it = origin.begin(); it != origin.end(); ++it) delete it->first;
+    END;
+}
+
+int main(int argc, char** argv)
+{
+    RequestQueue_Producers();
+    RequestQueue_MoreProducersThanRings();
+    RequestQueue_SharedFirst();
+    RequestQueue_FullBatch();
+}
@@ -3,9 +3,10 @@
 
 bool Storage::Read(Key key, Value* result, int txn_unique_id)
 {
-    if (data_.count(key))
+    unordered_map<Key, Entry>::iterator it = data_.find(key);
+    if (it != data_.end())
     {
-        *result = data_[key];
+        *result = it->second.value_;
         return true;
     }
     else
@@ -17,14 +18,22 @@ bool Storage::Read(Key key, Value* result, int txn_unique_id)
 // Write value and timestamps
 void Storage::Write(Key key, Value value, int txn_unique_id)
 {
-    data_[key]       = value;
-    timestamps_[key] = GetTime();
+    size_t size  = data_.size();
+    Entry* entry = &data_[key];
+    if (checkpointing_.load(std::memory_order_acquire) &&
+        entry->checkpoint_epoch_.load(std::memory_order_acquire) != checkpoint_epoch_)
+    {
+        SavePreImage(key, entry, data_.size() != size);
+    }
+    entry->value_     = value;
+    entry->timestamp_ = GetTime();
 }
 
 double Storage::Timestamp(Key key)
 {
-    if (timestamps_.count(key) == 0) return 0;
-    return timestamps_[key];
+    unordered_map<Key, Entry>::iterator it = data_.find(key);
+    if (it == data_.end()) return 0;
+    return it->second.timestamp_;
 }
 
 // Init the storage
@@ -35,3 +44,60 @@ void Storage::InitStorage()
         Write(i, 0, 0);
     }
 }
+
+void Storage::SavePreImage(Key key, Entry* entry, bool inserted)
+{
+    int stripe = key % kCheckpointStripes;
+    checkpoint_mutex_[stripe].Lock();
+    if (entry->checkpoint_epoch_.load(std::memory_order_relaxed) != checkpoint_epoch_)
+    {
+        if (!inserted) pre_images_[stripe][key] = entry->value_;
+        entry->checkpoint_epoch_.store(checkpoint_epoch_, std::memory_order_release);
+    }
+    checkpoint_mutex_[stripe].Unlock();
+}
+
+void Storage::BeginCheckpoint()
+{
+    for (int i = 0; i < kCheckpointStripes; i++) pre_images_[i].clear();
+    ++checkpoint_epoch_;
+    checkpointing_.store(true, std::memory_order_release);
+}
+
+void Storage::ScanCheckpoint(const std::function<void(Key, Value)>& fn)
+{
+    for (unordered_map<Key, Entry>::iterator it = data_.begin(); it != data_.end(); ++it)
+    {
+        int stripe   = it->first % kCheckpointStripes;
+        bool present = true;
+        Value value;
+
+        checkpoint_mutex_[stripe].Lock();
+        if (it->second.checkpoint_epoch_.load(std::memory_order_relaxed) == checkpoint_epoch_)
+        {
+            // Overwritten (or inserted) since the checkpoint began.
+            unordered_map<Key, Value>::iterator pre = pre_images_[stripe].find(it->first);
+            present = pre != pre_images_[stripe].end();
+            if (present) value = pre->second;
+        }
+        else
+        {
+            value = it->second.value_;
+            it->second.checkpoint_epoch_.store(checkpoint_epoch_, std::memory_order_release);
+        }
+        checkpoint_mutex_[stripe].Unlock();
+
+        if (present) fn(it->first, value);
+    }
+}
+
+void Storage::EndCheckpoint()
+{
+    checkpointing_.store(false, std::memory_order_release);
+    for (int i = 0; i < kCheckpointStripes; i++)
+    {
+        checkpoint_mutex_[i].Lock();
+        pre_images_[i].clear();
+        checkpoint_mutex_[i].Unlock();
+    }
+}
@@ -3,7 +3,9 @@
 #define _STORAGE_H_
 
 #include <limits.h>
+#include <atomic>
 #include <deque>
+#include <functional>
 #include <map>
 #include <unordered_map>
 
@@ -35,19 +37,58 @@ class Storage
     // Init storage
     virtual void InitStorage();
 
+    Storage() : checkpointing_(false), checkpoint_epoch_(0) {}
     virtual ~Storage() {}
     // The following methods are only used for MVCC
     virtual void Lock(Key key) {}
     virtual void Unlock(Key key) {}
     virtual bool CheckWrite(Key key, int txn_unique_id) { return true; }
+
+    // The following methods are used by the Checkpointer.
+    //
+    // Fixes the image of the storage that the next ScanCheckpoint() call
+    // returns. Must be called while no txn is executing (e.g. at a STRIFE
+    // batch boundary); txns may run again as soon as it returns.
+    virtual void BeginCheckpoint();
+
+    // Calls 'fn' for every record of the image fixed by BeginCheckpoint(),
+    // while txns keep writing to the storage. Like the parallel executors, it
+    // requires that no new keys are inserted concurrently.
+    virtual void ScanCheckpoint(const std::function<void(Key, Value)>& fn);
+
+    // Stops saving pre-images for the current checkpoint.
+    virtual void EndCheckpoint();
+
    private:
     friend class TxnProcessor;
 
-    // Collection of <key, value> pairs. Use this for single-version storage
-    unordered_map<Key, Value> data_;
+    // A record and the metadata kept with it.
+    struct Entry
+    {
+        Entry() : value_(0), timestamp_(0), checkpoint_epoch_(0) {}
+        Value value_;
+        // Timestamp at which the record was last updated.
+        double timestamp_;
+        // Epoch of the last checkpoint that copied the record (or its
+        // pre-image), so every record is copied at most once per checkpoint.
+        std::atomic<uint32> checkpoint_epoch_;
+    };
+
+    // Copy-on-write for records that haven't been copied by the running
+    // checkpoint yet: saves the current value as the pre-image.
+    void SavePreImage(Key key, Entry* entry, bool inserted);
+
+    // Collection of <key, entry> pairs. Use this for single-version storage
+    unordered_map<Key, Entry> data_;
 
-    // Timestamps at which each key was last updated.
-    unordered_map<Key, double> timestamps_;
+    // Checkpoint state. Pre-images live in striped maps, each guarded by its
+    // own mutex; a key without a pre-image whose epoch is current was inserted
+    // after the checkpoint began and isn't part of the image.
+    static const int kCheckpointStripes = 256;
+    std::atomic<bool> checkpointing_;
+    uint32 checkpoint_epoch_;
+    Mutex checkpoint_mutex_[kCheckpointStripes];
+    unordered_map<Key, Value> pre_images_[kCheckpointStripes];
 };
 
 #endif  // _STORAGE_H_
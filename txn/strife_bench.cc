@@ -0,0 +1,58 @@
+// Runs a benchmark sweep of the TxnProcessor and writes the results as CSV or
+// JSON (see txn/benchmark.h for the settings). Command line settings apply
+// after the spec file's.
+//
+// usage: strife_bench [--spec <file>] [key=value ...]
+
+#include <fstream>
+
+#include "txn/benchmark.h"
+
+int main(int argc, char** argv)
+{
+    BenchSpec spec;
+    string error;
+    for (int i = 1; i < argc; i++)
+    {
+        string arg = argv[i];
+        bool ok;
+        if (arg == "--spec" && i + 1 < argc)
+            ok = spec.Load(argv[++i], &error);
+        else
+            ok = spec.Set(arg, &error);
+        if (!ok)
+        {
+            std::cerr << error << std::endl;
+            std::cerr << "usage: " << argv[0] << " [--spec <file>] [key=value ...]" << std::endl;
+            return 1;
+        }
+    }
+
+    // A closed loop or a trace has no offered load to sweep.
+    vector<double> rates = spec.arrival_ == "closed" || spec.arrival_ == "trace" ? vector<double>(1, 0) : spec.rates_;
+
+    vector<BenchResult> results;
+    for (size_t m = 0; m < spec.modes_.size(); m++)
+    {
+        for (size_t t = 0; t < spec.threads_.size(); t++)
+        {
+            for (size_t r = 0; r < rates.size(); r++)
+            {
+                std::cerr << ModeName(spec.modes_[m]) << " x " << spec.threads_[t] << " threads";
+                if (rates[r] > 0) std::cerr << " at " << rates[r] << " txns/s";
+                std::cerr << std::endl;
+                results.push_back(RunBenchmark(spec, spec.modes_[m], spec.threads_[t], rates[r]));
+            }
+        }
+    }
+
+    if (spec.output_.empty())
+    {
+        WriteResults(spec, results, std::cout);
+        return 0;
+    }
+    std::ofstream out(spec.output_.c_str());
+    if (!out) DIE("Can't write " << spec.output_);
+    WriteResults(spec, results, out);
+    return 0;
+}
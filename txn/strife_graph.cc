@@ -0,0 +1,106 @@
+// Analyses the conflict graphs a TxnProcessor exported (graph_path_, or
+// strife_bench graphs=): the cluster sizes of the partitions, why txns ended
+// up residual, and how they compare with the finest partition without
+// residuals (the connected components of each batch). Then replays Merge and
+// Allocate over the same batches at other alphas, exact for ClustererSerial,
+// to pick one.
+// With --dot, writes the graph of one batch in Graphviz DOT instead.
+//
+// usage: strife_graph <graphs> [--alphas=0.05,0.1,...] [--dot=<batch id>]
+
+#include <stdlib.h>
+
+#include <iomanip>
+#include <sstream>
+
+#include "txn/batch_graph.h"
+
+static void PrintDistribution(const char* name, const Histogram& h)
+{
+    std::cout << std::left << std::setw(24) << name << std::right << " mean " << std::setw(8) << h.Mean() << "  p50 "
+              << std::setw(6) << h.Percentile(50) << "  p99 " << std::setw(6) << h.Percentile(99) << "  max "
+              << std::setw(6) << h.Max() << std::endl;
+}
+
+static void Usage(const char* argv0)
+{
+    std::cerr << "usage: " << argv0 << " <graphs> [--alphas=0.05,0.1,...] [--dot=<batch id>]" << std::endl;
+    exit(1);
+}
+
+int main(int argc, char** argv)
+{
+    if (argc < 2) Usage(argv[0]);
+    vector<float> alphas = {0.05, 0.1, 0.2, 0.3, 0.5};
+    bool dot             = false;
+    uint64 dot_batch     = 0;
+    for (int i = 2; i < argc; i++)
+    {
+        string arg = argv[i];
+        if (arg.compare(0, 9, "--alphas=") == 0)
+        {
+            alphas.clear();
+            std::stringstream list(arg.substr(9));
+            string alpha;
+            while (std::getline(list, alpha, ',')) alphas.push_back(atof(alpha.c_str()));
+        }
+        else if (arg.compare(0, 6, "--dot=") == 0)
+        {
+            dot       = true;
+            dot_batch = strtoull(arg.c_str() + 6, nullptr, 10);
+        }
+        else
+        {
+            Usage(argv[0]);
+        }
+    }
+
+    BatchGraphReader reader(argv[1]);
+    BatchGraph graph;
+    BatchGraphReport actual;
+    vector<BatchGraphReport> replays(alphas.size());
+    float alpha = 0;
+    uint32 k    = 0;
+    while (reader.Next(&graph))
+    {
+        if (dot)
+        {
+            if (graph.batch_id_ != dot_batch) continue;
+            WriteDot(graph, std::cout);
+            return 0;
+        }
+        alpha = graph.alpha_;
+        k     = graph.k_;
+        actual.Merge(Analyze(graph));
+        for (size_t i = 0; i < alphas.size(); i++) replays[i].Merge(AnalyzeAlpha(graph, alphas[i]));
+    }
+    if (dot) DIE("No batch " << dot_batch << " in " << argv[1]);
+    if (actual.batches_ == 0) DIE("No batches in " << argv[1]);
+
+    std::cout << std::fixed << std::setprecision(1);
+    std::cout << actual.batches_ << " batches, " << actual.txns_ << " txns (k=" << k << ", alpha=" << alpha << ")"
+              << std::endl;
+    PrintDistribution("clusters per batch", actual.clusters_);
+    PrintDistribution("txns per cluster", actual.cluster_txns_);
+    PrintDistribution("components per batch", actual.components_);
+    PrintDistribution("txns per component", actual.component_txns_);
+
+    uint64 residuals = actual.Residuals();
+    std::cout << "residuals " << residuals << " (" << 100.0 * residuals / actual.txns_ << "%):";
+    for (int c = 0; c < NUM_RESIDUAL_CAUSES; c++)
+        std::cout << " " << ResidualCauseToString(static_cast<ResidualCause>(c)) << " " << actual.residuals_[c];
+    std::cout << std::endl;
+    std::cout << "speedup bound " << actual.Speedup() << "x, by components " << actual.ComponentSpeedup() << "x"
+              << std::endl;
+
+    std::cout << std::endl << "   alpha  residual%   alpha  stray  clusters/batch  max txns/cluster  speedup" << std::endl;
+    for (size_t i = 0; i < alphas.size(); i++)
+    {
+        const BatchGraphReport& r = replays[i];
+        std::cout << std::setw(8) << std::setprecision(2) << alphas[i] << std::setprecision(1) << std::setw(11)
+                  << 100.0 * r.Residuals() / r.txns_ << std::setw(8) << r.residuals_[RESIDUAL_ALPHA] << std::setw(7)
+                  << r.residuals_[RESIDUAL_STRAY] << std::setw(16) << r.clusters_.Mean() << std::setw(18)
+                  << r.cluster_txns_.Max() << std::setw(8) << r.Speedup() << "x" << std::endl;
+    }
+    return 0;
+}
@@ -3,9 +3,11 @@
 #ifndef _STRIFE_ITF_H_
 #define _STRIFE_ITF_H_
 
+#include "txn/partition_stats.h"
 #include "txn/txn_processor.h"
 #include "utils/atomic.h"
 
+class BatchGraphWriter;
 
 class ClustererItf 
 {
@@ -20,6 +22,19 @@ public:
     //
     // caution!!!: the  txn_requests will be changed inside the function since we have to pop the elements to iterate through this set
     virtual size_t PartitionBatch(AtomicQueue<Txn*> &txn_requests, AtomicQueue<AtomicQueue<Txn*>*> &worklist, AtomicQueue<Txn*> &residuals) = 0;
+
+    // snapshot of the profile of all the batches partitioned so far, safe to call
+    // while another thread is partitioning
+    virtual PartitionStats Stats() { return PartitionStats(); };
+
+    // also sample the hardware counters of the partitioning thread around
+    // every phase (into PartitionStats::phase_events_); threads the clusterer
+    // hands work to aren't counted
+    virtual void EnablePerfCounters() {};
+
+    // also write the conflict graph of every batch to 'graphs' (see
+    // txn/batch_graph.h), which must outlive the clusterer's batches
+    virtual void ExportGraphs(BatchGraphWriter* graphs) {};
     virtual ~ClustererItf() {};
 };
 
@@ -37,7 +52,9 @@ struct Record {
 class UnionFindItf 
 {
 public:
-    virtual bool Union(Record *r1, Record *r2, bool relax) = 0;
+    // Sets '*linked', if given, to whether the two sets were joined by this
+    // call (false if they already were one).
+    virtual bool Union(Record *r1, Record *r2, bool relax, bool *linked = nullptr) = 0;
     virtual Record* Find(Record *r) = 0;
     virtual ~UnionFindItf() {};
 };
@@ -0,0 +1,369 @@
+// Microbenchmarks of the hot paths under the STRIFE schedulers, one case at a
+// time, to catch regressions a whole TxnProcessor run would average away:
+//
+//   partition     ClustererItf::PartitionBatch, per phase, across clusterers,
+//                 batch sizes and contention (Zipfian keys)
+//   union_find    UnionFind::Union and Find, from concurrent threads
+//   atomic_queue  AtomicQueue push/pop, from concurrent producers/consumers
+//   thread_pool   StaticThreadPool task dispatch
+//   storage       Storage reads and writes
+//
+// Every case runs 'warmup' untimed reps, then 'reps' timed ones, and reports
+// the median, min and max time per operation. Threads are pinned to distinct
+// CPUs (the StaticThreadPool pins its own), so runs are comparable.
+//
+// usage: strife_micro [--reps N] [--warmup N] [--threads N] [case prefix ...]
+
+#include <pthread.h>
+#include <stdlib.h>
+
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "txn/clusterer.h"
+#include "txn/load_generator.h"
+#include "txn/storage.h"
+#include "txn/union_find.h"
+#include "utils/atomic.h"
+#include "utils/cycle_clock.h"
+#include "utils/random.h"
+#include "utils/static_thread_pool.h"
+
+using std::string;
+using std::vector;
+
+struct MicroOptions
+{
+    MicroOptions() : reps_(5), warmup_(1), threads_(4) {}
+    int reps_;
+    int warmup_;
+    int threads_;
+    vector<string> cases_;  // case name prefixes to run (all if empty)
+
+    bool Selected(const string& name) const
+    {
+        if (cases_.empty()) return true;
+        for (size_t i = 0; i < cases_.size(); i++)
+            if (name.compare(0, cases_[i].size(), cases_[i]) == 0) return true;
+        return false;
+    }
+
+    // Whether any case under 'group' may be selected, e.g. to skip its setup.
+    bool SelectedGroup(const string& group) const
+    {
+        for (size_t i = 0; i < cases_.size(); i++)
+            if (cases_[i].compare(0, group.size(), group) == 0) return true;
+        return Selected(group);
+    }
+};
+
+// Pins the calling thread to 'cpu' (modulo the CPUs of the machine).
+static void PinThread(int cpu)
+{
+#if !defined(_MSC_VER) && !defined(__APPLE__)
+    int cpus = std::thread::hardware_concurrency();
+    if (cpus <= 0) return;
+    cpu_set_t cpuset;
+    CPU_ZERO(&cpuset);
+    CPU_SET(cpu % cpus, &cpuset);
+    pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &cpuset);
+#endif
+}
+
+// Runs 'body(thread)' on 'threads' pinned threads, released together, and
+// returns the CycleClock ticks from the release to the last one done.
+static uint64 RunThreads(int threads, const std::function<void(int)>& body)
+{
+    std::atomic<int> ready(0);
+    std::atomic<bool> go(false);
+    vector<std::thread> workers;
+    for (int t = 0; t < threads; t++)
+    {
+        workers.push_back(std::thread([&, t]() {
+            PinThread(t + 1);
+            ready++;
+            while (!go.load(std::memory_order_acquire)) std::this_thread::yield();
+            body(t);
+        }));
+    }
+    while (ready.load() < threads) std::this_thread::yield();
+    uint64 start = CycleClock::Now();
+    go.store(true, std::memory_order_release);
+    for (int t = 0; t < threads; t++) workers[t].join();
+    return CycleClock::Now() - start;
+}
+
+// Times the reps of one case. 'rep' runs one rep and returns its ticks (so it
+// can leave setup out); every rep performs 'ops' operations.
+static void Measure(const MicroOptions& options, const string& name, uint64 ops, const std::function<uint64()>& rep)
+{
+    for (int i = 0; i < options.warmup_; i++) rep();
+    vector<double> ns;
+    for (int i = 0; i < options.reps_; i++) ns.push_back(CycleClock::ToSeconds(rep()) * 1e9 / ops);
+    std::sort(ns.begin(), ns.end());
+
+    std::cout << std::left << std::setw(52) << name << std::right << std::fixed << std::setprecision(1)
+              << std::setw(12) << ns[ns.size() / 2] << std::setw(12) << ns.front() << std::setw(12) << ns.back()
+              << std::setw(10) << std::setprecision(2) << 1e3 / ns[ns.size() / 2] << std::endl;
+}
+
+static string Name(const string& name, const string& params)
+{
+    return params.empty() ? name : name + "/" + params;
+}
+
+// PartitionBatch of batches of RMW txns writing 'wsetsize' Zipfian keys.
+static void BenchPartition(const MicroOptions& options)
+{
+    const char* kinds[]   = {"serial", "serial_improved", "parallel"};
+    int batch_sizes[]     = {1000, 10000};
+    double thetas[]       = {0, 0.8, 0.99};
+    const int kWsetsize   = 10;
+    if (!options.SelectedGroup("partition")) return;
+    StaticThreadPool pool(options.threads_);
+
+    for (int t = 0; t < 3; t++)
+    {
+        ZipfianLoadGen lg(MAX_DB_SIZE, 0, kWsetsize, thetas[t], 0);
+        for (int b = 0; b < 2; b++)
+        {
+            vector<Txn*> txns;
+            for (int i = 0; i < batch_sizes[b]; i++) txns.push_back(lg.NewTxn());
+
+            for (int k = 0; k < 3; k++)
+            {
+                std::ostringstream name;
+                name << "partition/" << kinds[k] << "/batch=" << batch_sizes[b] << "/theta=" << thetas[t];
+                if (!options.Selected(name.str())) continue;
+
+                ClustererItf* clusterer;
+                if (k == 0)
+                    clusterer = new ClustererSerial();
+                else if (k == 1)
+                    clusterer = new ClustererSerialImproved();
+                else
+                    clusterer = new ClustererParallel(&pool);
+
+                auto rep = [&]() {
+                    AtomicQueue<Txn*> batch, residuals;
+                    AtomicQueue<AtomicQueue<Txn*>*> worklist;
+                    for (size_t i = 0; i < txns.size(); i++) batch.Push(txns[i]);
+                    uint64 start = CycleClock::Now();
+                    clusterer->PartitionBatch(batch, worklist, residuals);
+                    uint64 ticks = CycleClock::Now() - start;
+                    AtomicQueue<Txn*>* cluster;
+                    while (worklist.Pop(&cluster)) delete cluster;
+                    return ticks;
+                };
+
+                Measure(options, name.str(), txns.size(), rep);
+
+                // Phase medians, in us per batch, over the warmup and timed reps.
+                PartitionStats stats = clusterer->Stats();
+                std::ostringstream phases;
+                phases << std::fixed << std::setprecision(1);
+                for (int p = 0; p < NUM_PARTITION_PHASES; p++)
+                {
+                    phases << PartitionPhaseToString(static_cast<PartitionPhase>(p)) << "="
+                           << CycleClock::ToSeconds(stats.phase_cycles_[p].Percentile(50)) * 1e6 << "us ";
+                }
+                std::cout << std::setw(52) << "" << "  " << phases.str() << "clusters=" << stats.clusters_.Max()
+                          << " residuals=" << stats.residuals_.Max() << std::endl;
+                delete clusterer;
+            }
+            for (size_t i = 0; i < txns.size(); i++) delete txns[i];
+        }
+    }
+}
+
+// Unions of random pairs of a shared set of records, then Finds.
+static void BenchUnionFind(const MicroOptions& options)
+{
+    const int kRecords = 100000;
+    const int kOps     = 1000000;
+    vector<Record> records(kRecords);
+    UnionFind uf;
+
+    int thread_counts[] = {1, options.threads_};
+    for (int c = 0; c < 2; c++)
+    {
+        int threads = thread_counts[c];
+        std::ostringstream params;
+        params << "threads=" << threads;
+
+        string name = Name("union_find/union", params.str());
+        if (options.Selected(name))
+        {
+            Measure(options, name, kOps, [&]() {
+                for (int i = 0; i < kRecords; i++)
+                {
+                    records[i].id_     = i;
+                    records[i].parent_ = &records[i];
+                    records[i].rank_   = 0;
+                }
+                return RunThreads(threads, [&](int t) {
+                    FastRandom random(t + 1);
+                    for (int i = 0; i < kOps / threads; i++)
+                        uf.Union(&records[random.Uniform(kRecords)], &records[random.Uniform(kRecords)], true);
+                });
+            });
+        }
+
+        name = Name("union_find/find", params.str());
+        if (options.Selected(name))
+        {
+            // Chains of 16 records, so Find has paths to walk and compress.
+            Measure(options, name, kOps, [&]() {
+                for (int i = 0; i < kRecords; i++)
+                {
+                    records[i].id_     = i;
+                    records[i].parent_ = i % 16 == 15 ? &records[i] : &records[i + 1];
+                }
+                return RunThreads(threads, [&](int t) {
+                    FastRandom random(t + 1);
+                    for (int i = 0; i < kOps / threads; i++) uf.Find(&records[random.Uniform(kRecords)]);
+                });
+            });
+        }
+    }
+}
+
+// Items pushed by producers and popped by as many consumers.
+static void BenchAtomicQueue(const MicroOptions& options)
+{
+    const int kItems = 1000000;
+    int pair_counts[] = {1, std::max(1, options.threads_ / 2)};
+    for (int c = 0; c < 2; c++)
+    {
+        int pairs = pair_counts[c];
+        std::ostringstream params;
+        params << "producers=" << pairs << "/consumers=" << pairs;
+        string name = Name("atomic_queue/push_pop", params.str());
+        if (!options.Selected(name)) continue;
+
+        Measure(options, name, kItems, [&]() {
+            AtomicQueue<uint64> queue;
+            std::atomic<int> popped(0);
+            return RunThreads(2 * pairs, [&](int t) {
+                if (t < pairs)
+                {
+                    for (int i = 0; i < kItems / pairs; i++) queue.Push(i);
+                    return;
+                }
+                uint64 item;
+                while (popped.load(std::memory_order_relaxed) < kItems / pairs * pairs)
+                    if (queue.Pop(&item)) popped++;
+            });
+        });
+    }
+}
+
+// Empty tasks handed to the pool by one thread, until all have run.
+static void BenchThreadPool(const MicroOptions& options)
+{
+    const int kTasks = 200000;
+    std::ostringstream params;
+    params << "threads=" << options.threads_;
+    string name = Name("thread_pool/add_task", params.str());
+    if (!options.Selected(name)) return;
+
+    StaticThreadPool pool(options.threads_);
+    std::atomic<int> done(0);
+    Measure(options, name, kTasks, [&]() {
+        done.store(0);
+        uint64 start = CycleClock::Now();
+        for (int i = 0; i < kTasks; i++) pool.AddTask([&done]() { done++; });
+        while (done.load() < kTasks) std::this_thread::yield();
+        return CycleClock::Now() - start;
+    });
+}
+
+// Reads and writes of random keys of an initialized Storage. Concurrent
+// writers use disjoint keys, like the STRIFE executors.
+static void BenchStorage(const MicroOptions& options)
+{
+    const int kOps = 1000000;
+    if (!options.SelectedGroup("storage")) return;
+    // Keeps the reads from being optimized away.
+    static std::atomic<uint64> sink(0);
+    Storage storage;
+    storage.InitStorage();
+
+    int thread_counts[] = {1, options.threads_};
+    for (int c = 0; c < 2; c++)
+    {
+        int threads = thread_counts[c];
+        std::ostringstream params;
+        params << "threads=" << threads;
+
+        string name = Name("storage/read", params.str());
+        if (options.Selected(name))
+        {
+            Measure(options, name, kOps, [&]() {
+                return RunThreads(threads, [&](int t) {
+                    FastRandom random(t + 1);
+                    Value value, sum = 0;
+                    for (int i = 0; i < kOps / threads; i++)
+                        if (storage.Read(random.Uniform(MAX_DB_SIZE), &value)) sum += value;
+                    sink += sum;
+                });
+            });
+        }
+
+        name = Name("storage/write", params.str());
+        if (options.Selected(name))
+        {
+            Measure(options, name, kOps, [&]() {
+                return RunThreads(threads, [&](int t) {
+                    FastRandom random(t + 1);
+                    uint64 range = MAX_DB_SIZE / threads;
+                    for (int i = 0; i < kOps / threads; i++) storage.Write(t * range + random.Uniform(range), i);
+                });
+            });
+        }
+    }
+}
+
+int main(int argc, char** argv)
+{
+    MicroOptions options;
+    for (int i = 1; i < argc; i++)
+    {
+        string arg = argv[i];
+        int* value = nullptr;
+        if (arg == "--reps")
+            value = &options.reps_;
+        else if (arg == "--warmup")
+            value = &options.warmup_;
+        else if (arg == "--threads")
+            value = &options.threads_;
+        else if (arg.compare(0, 2, "--") != 0)
+            options.cases_.push_back(arg);
+
+        if (value != nullptr && i + 1 < argc) *value = atoi(argv[++i]);
+        if ((value == nullptr && arg.compare(0, 2, "--") == 0) || options.reps_ < 1 || options.warmup_ < 0 ||
+            options.threads_ < 1)
+        {
+            std::cerr << "usage: " << argv[0] << " [--reps N] [--warmup N] [--threads N] [case prefix ...]"
+                      << std::endl;
+            return 1;
+        }
+    }
+
+    PinThread(0);
+    std::cout << std::left << std::setw(52) << "case" << std::right << std::setw(12) << "ns/op" << std::setw(12)
+              << "min" << std::setw(12) << "max" << std::setw(10) << "Mops/s" << std::endl;
+    BenchPartition(options);
+    BenchUnionFind(options);
+    BenchAtomicQueue(options);
+    BenchThreadPool(options);
+    BenchStorage(options);
+    return 0;
+}
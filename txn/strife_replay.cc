@@ -0,0 +1,36 @@
+// Rebuilds the database from a STRIFE command log, optionally starting from a
+// checkpoint image, and reports what was replayed.
+//
+// usage: strife_replay <command_log> [<checkpoint>]
+
+#include "txn/checkpointer.h"
+#include "txn/command_log.h"
+#include "txn/storage.h"
+
+int main(int argc, char** argv)
+{
+    if (argc != 2 && argc != 3)
+    {
+        std::cerr << "usage: " << argv[0] << " <command_log> [<checkpoint>]" << std::endl;
+        return 1;
+    }
+
+    Storage storage;
+    storage.InitStorage();
+
+    double start         = GetTime();
+    uint64 checkpoint_id = 0;
+    if (argc == 3)
+    {
+        if (!Checkpointer::Load(argv[2], &storage, &checkpoint_id)) DIE("No valid checkpoint at " << argv[2]);
+        std::cout << "loaded checkpoint after batch " << checkpoint_id << std::endl;
+    }
+
+    CommandLogReplayer replayer(argv[1]);
+    uint64 batches  = replayer.Replay(&storage, checkpoint_id);
+    double duration = GetTime() - start;
+
+    std::cout << "replayed " << batches << " batches, " << replayer.NumTxns() << " txns (last batch "
+              << replayer.LastBatchId() << ") in " << duration << "s" << std::endl;
+    return 0;
+}
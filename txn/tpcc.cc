@@ -0,0 +1,182 @@
+#include "txn/tpcc.h"
+
+#include "utils/global.h"
+
+TpccLayout::TpccLayout(int warehouses, int districts, int customers, int items)
+    : warehouses_(warehouses), districts_(districts), customers_(customers), items_(items)
+{
+    if (warehouses < 1 || districts < 1 || customers < 1 || items < 1)
+        DIE("Bad TPC-C layout " << warehouses << "x" << districts << "x" << customers << "x" << items);
+    if (!Fits(warehouses, districts, customers, items))
+        DIE("TPC-C layout needs " << NumKeys() << " keys, more than " << MAX_DB_SIZE);
+}
+
+bool TpccLayout::Fits(int warehouses, int districts, int customers, int items)
+{
+    uint64 per_warehouse = 1 + districts + static_cast<uint64>(districts) * customers + items;
+    return items + warehouses * per_warehouse <= MAX_DB_SIZE;
+}
+
+namespace tpcc
+{
+uint64 StockQuantity(Value v, int item)
+{
+    uint64 quantity = Field(v, 0, 16);
+    return quantity != 0 ? quantity : 10 + (item * 7919ull) % 91;
+}
+
+uint64 ItemPrice(int item) { return 100 + (item * 104729ull) % 9901; }
+}  // namespace tpcc
+
+// Simulates the rest of the txn logic for 'time' seconds.
+static void BusyWait(double time)
+{
+    double begin = GetTime();
+    while (GetTime() - begin < time)
+    {
+        for (int i = 0; i < 1000; i++)
+        {
+            int x = 100;
+            x     = x + 2;
+            x     = x * x;
+        }
+    }
+}
+
+TpccNewOrder::TpccNewOrder(Key warehouse, Key district, Key customer, const vector<TpccOrderLine>& lines,
+                           bool rollback, double time)
+    : warehouse_(warehouse),
+      district_(district),
+      customer_(customer),
+      lines_(lines),
+      rollback_(rollback),
+      time_(time),
+      order_id_(0),
+      total_(0)
+{
+    readset_.insert(warehouse_);
+    readset_.insert(customer_);
+    writeset_.insert(district_);
+    for (size_t i = 0; i < lines_.size(); i++)
+    {
+        readset_.insert(lines_[i].item_);
+        writeset_.insert(lines_[i].stock_);
+    }
+}
+
+TpccNewOrder* TpccNewOrder::clone() const
+{
+    TpccNewOrder* clone = new TpccNewOrder(warehouse_, district_, customer_, lines_, rollback_, time_);
+    this->CopyTxnInternals(clone);
+    return clone;
+}
+
+void TpccNewOrder::Run()
+{
+    Value value = 0;
+    Read(warehouse_, &value);
+    Read(customer_, &value);
+
+    uint64 total = 0;
+    for (size_t i = 0; i < lines_.size(); i++)
+    {
+        Read(lines_[i].item_, &value);
+        total += tpcc::ItemPrice(lines_[i].item_) * lines_[i].quantity_;
+    }
+    if (rollback_) ABORT;
+
+    value = 0;
+    Read(district_, &value);
+    uint64 orders = tpcc::DistrictOrders(value);
+    Write(district_, tpcc::SetField(value, 0, 24, orders + 1));
+
+    for (size_t i = 0; i < lines_.size(); i++)
+    {
+        const TpccOrderLine& line = lines_[i];
+        value                     = 0;
+        Read(line.stock_, &value);
+        uint64 quantity = tpcc::StockQuantity(value, line.item_);
+        quantity        = quantity >= line.quantity_ + 10 ? quantity - line.quantity_ : quantity - line.quantity_ + 91;
+        value           = tpcc::SetField(value, 0, 16, quantity);
+        value           = tpcc::SetField(value, 16, 32, tpcc::StockYtd(value) + line.quantity_);
+        value           = tpcc::SetField(value, 48, 16, tpcc::StockOrders(value) + 1);
+        Write(line.stock_, value);
+    }
+
+    BusyWait(time_);
+    order_id_ = tpcc::kFirstOrderId + orders;
+    total_    = total;
+    COMMIT;
+}
+
+void TpccNewOrder::EncodeArgs(vector<uint64>* args) const
+{
+    args->push_back(warehouse_);
+    args->push_back(district_);
+    args->push_back(customer_);
+    args->push_back(rollback_);
+    args->push_back(DoubleToBits(time_));
+    for (size_t i = 0; i < lines_.size(); i++)
+    {
+        args->push_back(lines_[i].item_);
+        args->push_back(lines_[i].stock_);
+        args->push_back(lines_[i].quantity_);
+    }
+}
+
+TpccNewOrder* TpccNewOrder::Decode(const vector<uint64>& args)
+{
+    if (args.size() < 5 || (args.size() - 5) % 3 != 0) return nullptr;
+    vector<TpccOrderLine> lines;
+    for (size_t i = 5; i < args.size(); i += 3) lines.push_back(TpccOrderLine(args[i], args[i + 1], args[i + 2]));
+    return new TpccNewOrder(args[0], args[1], args[2], lines, args[3] != 0, BitsToDouble(args[4]));
+}
+
+TpccPayment::TpccPayment(Key warehouse, Key district, Key customer, uint64 amount, double time)
+    : warehouse_(warehouse), district_(district), customer_(customer), amount_(amount), time_(time)
+{
+    writeset_.insert(warehouse_);
+    writeset_.insert(district_);
+    writeset_.insert(customer_);
+}
+
+TpccPayment* TpccPayment::clone() const
+{
+    TpccPayment* clone = new TpccPayment(warehouse_, district_, customer_, amount_, time_);
+    this->CopyTxnInternals(clone);
+    return clone;
+}
+
+void TpccPayment::Run()
+{
+    Value value = 0;
+    Read(warehouse_, &value);
+    Write(warehouse_, value + amount_);
+
+    value = 0;
+    Read(district_, &value);
+    Write(district_, tpcc::SetField(value, 24, 40, tpcc::DistrictYtd(value) + amount_));
+
+    value = 0;
+    Read(customer_, &value);
+    value = tpcc::SetField(value, 0, 16, tpcc::CustomerPayments(value) + 1);
+    Write(customer_, tpcc::SetField(value, 16, 48, tpcc::CustomerYtd(value) + amount_));
+
+    BusyWait(time_);
+    COMMIT;
+}
+
+void TpccPayment::EncodeArgs(vector<uint64>* args) const
+{
+    args->push_back(warehouse_);
+    args->push_back(district_);
+    args->push_back(customer_);
+    args->push_back(amount_);
+    args->push_back(DoubleToBits(time_));
+}
+
+TpccPayment* TpccPayment::Decode(const vector<uint64>& args)
+{
+    if (args.size() != 5) return nullptr;
+    return new TpccPayment(args[0], args[1], args[2], args[3], BitsToDouble(args[4]));
+}
@@ -0,0 +1,172 @@
+// A subset of TPC-C: the NewOrder and Payment txns, which make up ~90% of the
+// standard mix and all of its contention, over a key encoding of the
+// ITEM, WAREHOUSE, DISTRICT, CUSTOMER and STOCK tables.
+//
+// Each row is one Key whose Value packs the columns the two txns update.
+// Storage starts with every key at 0, so a 0 row reads as freshly loaded.
+// Simplifications:
+//   - ORDER, NEW-ORDER, ORDER-LINE and HISTORY rows are not materialized;
+//     a NewOrder's inserts are only its district's next order id.
+//   - Payment picks customers by id, never by last name.
+//   - Cardinalities are scaled (TpccLayout) to fit MAX_DB_SIZE keys.
+
+#ifndef _TPCC_H_
+#define _TPCC_H_
+
+#include <vector>
+
+#include "txn/txn.h"
+
+using std::vector;
+
+// Key encoding. Items come first and are shared by all the warehouses; every
+// warehouse then has a contiguous range holding its warehouse row, districts,
+// customers and stock:
+//
+//   [items][w0: warehouse, districts, customers, stock][w1: ...]...
+//
+// Ids are 0 based.
+class TpccLayout
+{
+   public:
+    TpccLayout(int warehouses, int districts = 10, int customers = 300, int items = 10000);
+
+    // Whether such a layout fits in MAX_DB_SIZE keys.
+    static bool Fits(int warehouses, int districts = 10, int customers = 300, int items = 10000);
+
+    int Warehouses() const { return warehouses_; }
+    int Districts() const { return districts_; }
+    int Customers() const { return customers_; }
+    int Items() const { return items_; }
+
+    // Keys used by all the warehouses, all below MAX_DB_SIZE.
+    uint64 NumKeys() const { return items_ + static_cast<uint64>(warehouses_) * PerWarehouse(); }
+
+    Key ItemKey(int i) const { return i; }
+    Key WarehouseKey(int w) const { return Base(w); }
+    Key DistrictKey(int w, int d) const { return Base(w) + 1 + d; }
+    Key CustomerKey(int w, int d, int c) const
+    {
+        return Base(w) + 1 + districts_ + static_cast<uint64>(d) * customers_ + c;
+    }
+    Key StockKey(int w, int i) const
+    {
+        return Base(w) + 1 + districts_ + static_cast<uint64>(districts_) * customers_ + i;
+    }
+
+   private:
+    uint64 PerWarehouse() const { return 1 + districts_ + static_cast<uint64>(districts_) * customers_ + items_; }
+    uint64 Base(int w) const { return items_ + w * PerWarehouse(); }
+
+    int warehouses_;
+    int districts_;
+    int customers_;
+    int items_;
+};
+
+// Row values. Amounts are in cents; counters wrap within their fields.
+//
+//   warehouse: w_ytd
+//   district:  d_next_o_id - 3001 (bits 0-23), d_ytd (bits 24-63)
+//   customer:  c_payment_cnt (bits 0-15), c_ytd_payment (bits 16-63)
+//   stock:     s_quantity (bits 0-15, 0 before the first order),
+//              s_ytd (bits 16-47), s_order_cnt (bits 48-63)
+namespace tpcc
+{
+static const uint64 kFirstOrderId = 3001;
+
+static inline uint64 Field(Value v, int shift, int bits) { return (v >> shift) & ((1ull << bits) - 1); }
+static inline Value SetField(Value v, int shift, int bits, uint64 field)
+{
+    uint64 mask = ((1ull << bits) - 1) << shift;
+    return (v & ~mask) | ((field << shift) & mask);
+}
+
+static inline uint64 DistrictOrders(Value v) { return Field(v, 0, 24); }
+static inline uint64 DistrictYtd(Value v) { return Field(v, 24, 40); }
+static inline uint64 CustomerPayments(Value v) { return Field(v, 0, 16); }
+static inline uint64 CustomerYtd(Value v) { return Field(v, 16, 48); }
+static inline uint64 StockYtd(Value v) { return Field(v, 16, 32); }
+static inline uint64 StockOrders(Value v) { return Field(v, 48, 16); }
+
+// Quantity of the stock row of 'item', the load time quantity (10..100)
+// while the row is still 0.
+uint64 StockQuantity(Value v, int item);
+
+// Price of 'item', 1.00 to 100.00.
+uint64 ItemPrice(int item);
+}  // namespace tpcc
+
+// One order line of a NewOrder: the item's key, the key of the stock row it
+// comes from (remote if another warehouse's) and the quantity, 1..10.
+struct TpccOrderLine
+{
+    TpccOrderLine() : item_(0), stock_(0), quantity_(0) {}
+    TpccOrderLine(Key item, Key stock, uint64 quantity) : item_(item), stock_(stock), quantity_(quantity) {}
+    Key item_;
+    Key stock_;
+    uint64 quantity_;
+};
+
+// Reads the warehouse, customer and items, takes the district's next order
+// id and updates the stock of every line. A 'rollback' NewOrder (1% in
+// TPC-C, an unused item) aborts after its reads.
+class TpccNewOrder : public Txn
+{
+   public:
+    static const TxnType kType = TXN_TPCC_NEW_ORDER;
+
+    TpccNewOrder(Key warehouse, Key district, Key customer, const vector<TpccOrderLine>& lines, bool rollback,
+                 double time = 0);
+
+    TpccNewOrder* clone() const;
+    virtual void Run();
+
+    virtual TxnType Type() const { return kType; }
+    virtual void EncodeArgs(vector<uint64>* args) const;
+
+    // Rebuilds the txn from EncodeArgs() output, nullptr if malformed.
+    static TpccNewOrder* Decode(const vector<uint64>& args);
+
+    // Order id and total price (cents) of the last committed Run().
+    uint64 OrderId() const { return order_id_; }
+    uint64 Total() const { return total_; }
+
+   private:
+    Key warehouse_;
+    Key district_;
+    Key customer_;
+    vector<TpccOrderLine> lines_;
+    bool rollback_;
+    double time_;
+    uint64 order_id_;
+    uint64 total_;
+};
+
+// Adds 'amount' cents to the year to date of the warehouse, the district and
+// the customer (of another warehouse for 15% of the Payments in TPC-C).
+class TpccPayment : public Txn
+{
+   public:
+    static const TxnType kType = TXN_TPCC_PAYMENT;
+
+    TpccPayment(Key warehouse, Key district, Key customer, uint64 amount, double time = 0);
+
+    TpccPayment* clone() const;
+    virtual void Run();
+
+    virtual TxnType Type() const { return kType; }
+    virtual void EncodeArgs(vector<uint64>* args) const;
+
+    // Rebuilds the txn from EncodeArgs() output, nullptr if malformed.
+    static TpccPayment* Decode(const vector<uint64>& args);
+
+   private:
+    Key warehouse_;
+    Key district_;
+    Key customer_;
+    uint64 amount_;
+    double time_;
+};
+
+#endif  // _TPCC_H_
@@ -0,0 +1,220 @@
+#include "txn/tpcc.h"
+
+#include <set>
+
+#include "txn/command_log.h"
+#include "txn/load_generator.h"
+#include "txn/txn_processor.h"
+#include "utils/testing.h"
+
+TEST(Tpcc_Layout)
+{
+    TpccLayout layout(3, 4, 5, 20);
+    std::set<Key> keys;
+    for (int i = 0; i < layout.Items(); i++) keys.insert(layout.ItemKey(i));
+    for (int w = 0; w < layout.Warehouses(); w++)
+    {
+        keys.insert(layout.WarehouseKey(w));
+        for (int d = 0; d < layout.Districts(); d++)
+        {
+            keys.insert(layout.DistrictKey(w, d));
+            for (int c = 0; c < layout.Customers(); c++) keys.insert(layout.CustomerKey(w, d, c));
+        }
+        for (int i = 0; i < layout.Items(); i++) keys.insert(layout.StockKey(w, i));
+    }
+    // Every row has its own key, and the keys are dense.
+    EXPECT_EQ(layout.NumKeys(), keys.size());
+    EXPECT_EQ(layout.NumKeys() - 1, *keys.rbegin());
+
+    EXPECT_TRUE(TpccLayout::Fits(76));
+    EXPECT_FALSE(TpccLayout::Fits(77));
+    END;
+}
+
+TEST(Tpcc_Fields)
+{
+    Value v = tpcc::SetField(0, 0, 24, (1 << 24) + 5);
+    EXPECT_EQ(5, tpcc::DistrictOrders(v));
+    v = tpcc::SetField(v, 24, 40, 123456789);
+    EXPECT_EQ(5, tpcc::DistrictOrders(v));
+    EXPECT_EQ(123456789, tpcc::DistrictYtd(v));
+
+    // Unloaded stock has its load time quantity.
+    for (int i = 0; i < 1000; i++)
+    {
+        uint64 quantity = tpcc::StockQuantity(0, i);
+        EXPECT_TRUE(quantity >= 10 && quantity <= 100);
+        EXPECT_EQ(7, tpcc::StockQuantity(tpcc::SetField(0, 0, 16, 7), i));
+    }
+    END;
+}
+
+TEST(Tpcc_LoadGen)
+{
+    TpccLayout layout(4);
+    TpccLoadGen lg(layout);
+    FastRandom random(1);
+    Key span = layout.WarehouseKey(1) - layout.WarehouseKey(0);
+    int remote_payments = 0, remote_lines = 0, lines = 0;
+    for (int i = 0; i < 10000; i++)
+    {
+        TpccNewOrder* order = lg.NewOrder(&random);
+        int count           = order->writeset_.size() - 1;
+        EXPECT_TRUE(count >= 5 && count <= 15);
+        vector<uint64> args;
+        order->EncodeArgs(&args);
+        Key home = args[0];
+        for (size_t j = 5; j < args.size(); j += 3)
+        {
+            EXPECT_TRUE(args[j] < static_cast<uint64>(layout.Items()));
+            EXPECT_TRUE(args[j + 1] < layout.NumKeys());
+            EXPECT_TRUE(args[j + 2] >= 1 && args[j + 2] <= 10);
+            lines++;
+            if (args[j + 1] < home || args[j + 1] >= home + span) remote_lines++;
+        }
+        delete order;
+
+        TpccPayment* payment = lg.Payment(&random);
+        args.clear();
+        payment->EncodeArgs(&args);
+        EXPECT_TRUE(args[3] >= 100 && args[3] <= 500000);
+        if (args[2] < args[0] || args[2] >= args[0] + span) remote_payments++;
+        delete payment;
+    }
+    EXPECT_TRUE(remote_payments > 1200 && remote_payments < 1800);
+    EXPECT_TRUE(remote_lines > lines / 200 && remote_lines < lines / 50);
+    END;
+}
+
+TEST(Tpcc_Codec)
+{
+    TpccLayout layout(2);
+    TpccLoadGen lg(layout);
+    FastRandom random(2);
+    Txn* txns[] = {lg.NewOrder(&random), lg.Payment(&random)};
+
+    string buf;
+    for (int i = 0; i < 2; i++) TxnCodec::Encode(txns[i], &buf);
+    const char* pos = buf.data();
+    const char* end = pos + buf.size();
+    for (int i = 0; i < 2; i++)
+    {
+        Txn* txn = TxnCodec::Decode(&pos, end);
+        EXPECT_TRUE(txn != nullptr);
+        EXPECT_EQ(txns[i]->Type(), txn->Type());
+        EXPECT_TRUE(txn->writeset_ == txns[i]->writeset_);
+        vector<uint64> args1, args2;
+        txns[i]->EncodeArgs(&args1);
+        txn->EncodeArgs(&args2);
+        EXPECT_TRUE(args1 == args2);
+        delete txn;
+        delete txns[i];
+    }
+    EXPECT_TRUE(pos == end);
+    END;
+}
+
+// Reads every row of the layout. The STRIFE clusterer needs a write set, so
+// it also names the first key past the layout.
+class TpccSnapshot : public Txn
+{
+   public:
+    explicit TpccSnapshot(const TpccLayout& layout)
+    {
+        for (Key key = 0; key < layout.NumKeys(); key++) readset_.insert(key);
+        writeset_.insert(layout.NumKeys());
+    }
+
+    TpccSnapshot* clone() const
+    {
+        TpccSnapshot* clone = new TpccSnapshot(*this);
+        this->CopyTxnInternals(clone);
+        return clone;
+    }
+
+    virtual void Run()
+    {
+        for (KeySet::const_iterator it = readset_.begin(); it != readset_.end(); ++it) Read(*it, &values_[*it]);
+        COMMIT;
+    }
+
+    map<Key, Value> values_;
+};
+
+// Runs the mix and checks TPC-C's consistency conditions that survive the
+// subset: every warehouse's year to date is the sum of its districts', the
+// payments add up to the customers' and every committed NewOrder took one
+// order id and updated the stock of each of its lines.
+void CheckTpccConsistency(CCMode mode)
+{
+    TpccLayout layout(2, 3, 20, 100);
+    TpccLoadGen lg(layout);
+    TxnProcessor p(mode);
+
+    int num_txns = 2000;
+    for (int i = 0; i < num_txns; i++) p.NewTxnRequest(lg.NewTxn());
+    uint64 orders = 0, lines = 0, payments = 0;
+    for (int i = 0; i < num_txns; i++)
+    {
+        Txn* txn = p.GetTxnResult();
+        if (txn->Type() == TXN_TPCC_PAYMENT)
+        {
+            EXPECT_EQ(COMMITTED, txn->Status());
+            payments++;
+        }
+        else if (txn->Status() == COMMITTED)
+        {
+            orders++;
+            lines += txn->writeset_.size() - 1;
+        }
+        delete txn;
+    }
+
+    p.NewTxnRequest(new TpccSnapshot(layout));
+    TpccSnapshot* snapshot = static_cast<TpccSnapshot*>(p.GetTxnResult());
+    EXPECT_EQ(COMMITTED, snapshot->Status());
+    map<Key, Value>& v = snapshot->values_;
+
+    uint64 next_ids = 0, warehouse_ytd = 0, customer_ytd = 0, customer_payments = 0, stock_orders = 0;
+    for (int w = 0; w < layout.Warehouses(); w++)
+    {
+        uint64 district_ytd = 0;
+        for (int d = 0; d < layout.Districts(); d++)
+        {
+            next_ids += tpcc::DistrictOrders(v[layout.DistrictKey(w, d)]);
+            district_ytd += tpcc::DistrictYtd(v[layout.DistrictKey(w, d)]);
+            for (int c = 0; c < layout.Customers(); c++)
+            {
+                customer_ytd += tpcc::CustomerYtd(v[layout.CustomerKey(w, d, c)]);
+                customer_payments += tpcc::CustomerPayments(v[layout.CustomerKey(w, d, c)]);
+            }
+        }
+        EXPECT_EQ(v[layout.WarehouseKey(w)], district_ytd);
+        warehouse_ytd += v[layout.WarehouseKey(w)];
+        for (int i = 0; i < layout.Items(); i++) stock_orders += tpcc::StockOrders(v[layout.StockKey(w, i)]);
+    }
+    EXPECT_EQ(orders, next_ids);
+    EXPECT_EQ(lines, stock_orders);
+    EXPECT_EQ(payments, customer_payments);
+    EXPECT_EQ(warehouse_ytd, customer_ytd);
+    EXPECT_TRUE(orders > 0 && payments > 0);
+    delete snapshot;
+}
+
+TEST(Tpcc_Consistency)
+{
+    CheckTpccConsistency(SERIAL);
+    CheckTpccConsistency(LOCKING);
+    CheckTpccConsistency(MVCC);
+    CheckTpccConsistency(STRIFE_LM);
+    END;
+}
+
+int main(int argc, char** argv)
+{
+    Tpcc_Layout();
+    Tpcc_Fields();
+    Tpcc_LoadGen();
+    Tpcc_Codec();
+    Tpcc_Consistency();
+}
@@ -0,0 +1,150 @@
+#include "txn/trace.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "utils/cycle_clock.h"
+
+static const uint32 kTraceMagic   = 0x53545254;  // "STRT"
+static const uint32 kTraceVersion = 1;
+static const size_t kHeaderSize   = 2 * sizeof(uint32);
+
+// Records are written once this much is buffered.
+static const size_t kFlushSize = 1 << 20;
+
+TraceWriter::TraceWriter(const string& path) : first_arrival_(0), last_us_(0), records_(0), skipped_(0)
+{
+    file_ = fopen(path.c_str(), "wb");
+    if (file_ == nullptr) DIE("Can't open trace " << path);
+    uint32 header[2] = {kTraceMagic, kTraceVersion};
+    if (fwrite(header, kHeaderSize, 1, file_) != 1) DIE("Trace write failed.");
+}
+
+TraceWriter::~TraceWriter()
+{
+    FlushLocked();
+    fclose(file_);
+}
+
+void TraceWriter::Record(const Txn* txn, uint64 arrival)
+{
+    mutex_.Lock();
+    if (txn->Type() == TXN_UNKNOWN)
+    {
+        skipped_++;
+        mutex_.Unlock();
+        return;
+    }
+    if (records_ == 0) first_arrival_ = arrival;
+    uint64 us = arrival > first_arrival_ ? static_cast<uint64>(CycleClock::ToSeconds(arrival - first_arrival_) * 1e6)
+                                         : 0;
+    if (us < last_us_) us = last_us_;
+    TxnCodec::PutVarint(us - last_us_, &buffer_);
+    TxnCodec::Encode(txn, &buffer_);
+    last_us_ = us;
+    records_++;
+    if (buffer_.size() >= kFlushSize) FlushLocked();
+    mutex_.Unlock();
+}
+
+void TraceWriter::Flush()
+{
+    mutex_.Lock();
+    FlushLocked();
+    mutex_.Unlock();
+}
+
+void TraceWriter::FlushLocked()
+{
+    if (!buffer_.empty() && fwrite(buffer_.data(), buffer_.size(), 1, file_) != 1) DIE("Trace write failed.");
+    if (fflush(file_) != 0) DIE("Trace write failed.");
+    buffer_.clear();
+}
+
+uint64 TraceWriter::NumRecords()
+{
+    mutex_.Lock();
+    uint64 records = records_;
+    mutex_.Unlock();
+    return records;
+}
+
+uint64 TraceWriter::NumSkipped()
+{
+    mutex_.Lock();
+    uint64 skipped = skipped_;
+    mutex_.Unlock();
+    return skipped;
+}
+
+TraceReader::TraceReader(const string& path) : data_(nullptr), size_(0), pos_(nullptr), arrival_us_(0)
+{
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) DIE("Can't open trace " << path);
+    struct stat st;
+    if (fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < kHeaderSize) DIE("Not a trace: " << path);
+    size_ = st.st_size;
+    void* data = mmap(NULL, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) DIE("Can't map trace " << path);
+    // Records are read front to back, once per pass.
+    madvise(data, size_, MADV_SEQUENTIAL);
+    data_ = static_cast<char*>(data);
+
+    uint32 header[2];
+    memcpy(header, data_, kHeaderSize);
+    if (header[0] != kTraceMagic || header[1] != kTraceVersion) DIE("Not a trace: " << path);
+    Rewind();
+}
+
+TraceReader::~TraceReader() { munmap(data_, size_); }
+
+Txn* TraceReader::Next(double* arrival)
+{
+    const char* end = data_ + size_;
+    const char* pos = pos_;
+    uint64 delta;
+    if (!TxnCodec::GetVarint(&pos, end, &delta)) return nullptr;
+    Txn* txn = TxnCodec::Decode(&pos, end);
+    if (txn == nullptr) return nullptr;
+
+    pos_ = pos;
+    arrival_us_ += delta;
+    if (arrival != nullptr) *arrival = arrival_us_ / 1e6;
+    return txn;
+}
+
+void TraceReader::Rewind()
+{
+    pos_        = data_ + kHeaderSize;
+    arrival_us_ = 0;
+}
+
+TraceLoadGen::TraceLoadGen(const string& path, bool loop)
+    : reader_(path), loop_(loop), offset_(0), last_arrival_(0), pass_txns_(0)
+{
+}
+
+Txn* TraceLoadGen::Next(double* arrival)
+{
+    mutex_.Lock();
+    double at;
+    Txn* txn = reader_.Next(&at);
+    if (txn == nullptr && loop_ && pass_txns_ > 0)
+    {
+        reader_.Rewind();
+        offset_    = last_arrival_;
+        pass_txns_ = 0;
+        txn        = reader_.Next(&at);
+    }
+    if (txn != nullptr)
+    {
+        last_arrival_ = offset_ + at;
+        pass_txns_++;
+        if (arrival != nullptr) *arrival = last_arrival_;
+    }
+    mutex_.Unlock();
+    return txn;
+}
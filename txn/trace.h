@@ -0,0 +1,108 @@
+// Workload traces: the stream of txns submitted to a TxnProcessor, recorded
+// (TxnProcessorOptions::trace_path_) so it can be fed again, e.g. to compare
+// CCModes on the same input. A trace file is a header followed by one record
+// per txn, in submission order:
+//
+//   header: magic "STRT", format version (uint32 each)
+//   record: arrival delta (varint, microseconds after the previous record)
+//           TxnCodec encoding (type, read/write sets, type specific
+//           arguments such as the txn's busy wait time)
+//
+// Txns of types TxnCodec can't encode (TXN_UNKNOWN) are left out. There is no
+// checksum: a trace ends at the first record that doesn't decode.
+
+#ifndef _TRACE_H_
+#define _TRACE_H_
+
+#include <stdio.h>
+#include <string>
+
+#include "txn/command_log.h"
+#include "txn/load_generator.h"
+#include "txn/txn.h"
+#include "utils/mutex.h"
+
+using std::string;
+
+// Appends records to a new trace file. Thread safe.
+class TraceWriter
+{
+   public:
+    // Creates (truncates) the trace at 'path'.
+    explicit TraceWriter(const string& path);
+    // Flushes the buffered records.
+    ~TraceWriter();
+
+    // Appends 'txn', which arrived at CycleClock time 'arrival'. Arrivals
+    // earlier than the previous record's are recorded as simultaneous.
+    void Record(const Txn* txn, uint64 arrival);
+
+    // Writes the buffered records to the file.
+    void Flush();
+
+    uint64 NumRecords();
+    uint64 NumSkipped();
+
+   private:
+    void FlushLocked();
+
+    Mutex mutex_;
+    FILE* file_;
+    string buffer_;
+    uint64 first_arrival_;  // CycleClock time of the first record
+    uint64 last_us_;        // arrival of the last record, us after the first
+    uint64 records_;
+    uint64 skipped_;
+
+    DISALLOW_CLASS_COPY_AND_ASSIGN(TraceWriter);
+};
+
+// Reads the records of a trace file, memory mapped. Not thread safe.
+class TraceReader
+{
+   public:
+    // Dies if 'path' can't be mapped or isn't a trace.
+    explicit TraceReader(const string& path);
+    ~TraceReader();
+
+    // Returns the next txn, owned by the caller, and sets '*arrival' (if not
+    // null) to its arrival in seconds after the first record's. Returns
+    // nullptr at the end of the trace.
+    Txn* Next(double* arrival);
+
+    // Goes back to the first record.
+    void Rewind();
+
+   private:
+    char* data_;
+    size_t size_;
+    const char* pos_;
+    uint64 arrival_us_;
+
+    DISALLOW_CLASS_COPY_AND_ASSIGN(TraceReader);
+};
+
+// Replays the txns of a trace file, in order. With 'loop', it starts over at
+// the end of the trace (arrivals keep increasing), otherwise NewTxn() returns
+// nullptr once the trace is exhausted. Thread safe.
+class TraceLoadGen : public LoadGen
+{
+   public:
+    explicit TraceLoadGen(const string& path, bool loop = true);
+
+    virtual Txn* NewTxn() { return Next(nullptr); }
+
+    // Like NewTxn(), also setting '*arrival' (if not null) to the txn's
+    // arrival in seconds after the start of the trace.
+    Txn* Next(double* arrival);
+
+   private:
+    Mutex mutex_;
+    TraceReader reader_;
+    bool loop_;
+    double offset_;        // arrival of the start of the current pass
+    double last_arrival_;  // arrival of the last txn returned
+    uint64 pass_txns_;     // txns returned in the current pass
+};
+
+#endif  // _TRACE_H_
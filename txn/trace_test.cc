@@ -0,0 +1,141 @@
+#include "txn/trace.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <unistd.h>
+
+#include "txn/txn_processor.h"
+#include "txn/txn_types.h"
+#include "utils/cycle_clock.h"
+#include "utils/testing.h"
+
+static string TempPath(const char* name)
+{
+    char path[128];
+    snprintf(path, sizeof(path), "/tmp/strife_%s_%d", name, getpid());
+    return path;
+}
+
+TEST(Trace_RoundTrip)
+{
+    string path   = TempPath("trace");
+    uint64 second = static_cast<uint64>(CycleClock::PerSecond());
+    RMWLoadGen lg(1000, 2, 3, 0.0001);
+    vector<Txn*> txns;
+    {
+        TraceWriter writer(path);
+        for (int i = 0; i < 100; i++)
+        {
+            txns.push_back(lg.NewTxn());
+            // 10ms apart, except one arriving out of order.
+            writer.Record(txns.back(), 1000 * second + (i == 50 ? 0 : i * second / 100));
+        }
+        Expect expect(map<Key, Value>{{1, 0}});
+        writer.Record(&expect, 1000 * second + second);
+        EXPECT_EQ(101, writer.NumRecords());
+        EXPECT_EQ(0, writer.NumSkipped());
+    }
+
+    TraceReader reader(path);
+    for (int pass = 0; pass < 2; pass++)
+    {
+        double last = 0;
+        for (int i = 0; i < 100; i++)
+        {
+            double arrival;
+            Txn* txn = reader.Next(&arrival);
+            EXPECT_TRUE(txn != nullptr);
+            EXPECT_EQ(TXN_RMW, txn->Type());
+            EXPECT_TRUE(txn->writeset_ == txns[i]->writeset_);
+            EXPECT_TRUE(arrival >= last);
+            if (i != 50) EXPECT_TRUE(fabs(arrival - i / 100.0) < 0.001);
+            last = arrival;
+            delete txn;
+        }
+        Txn* txn = reader.Next(nullptr);
+        EXPECT_EQ(TXN_EXPECT, txn->Type());
+        delete txn;
+        EXPECT_TRUE(reader.Next(nullptr) == nullptr);
+        reader.Rewind();
+    }
+
+    for (size_t i = 0; i < txns.size(); i++) delete txns[i];
+    unlink(path.c_str());
+    END;
+}
+
+TEST(Trace_LoadGen)
+{
+    string path = TempPath("trace_lg");
+    {
+        TraceWriter writer(path);
+        map<Key, Value> m = {{7, 1}};
+        Put put(m);
+        writer.Record(&put, 1);
+        writer.Record(&put, 1 + static_cast<uint64>(CycleClock::PerSecond()));
+    }
+
+    // A looping replay keeps going, later passes arriving later.
+    TraceLoadGen loop(path);
+    double arrivals[6];
+    for (int i = 0; i < 6; i++)
+    {
+        Txn* txn = loop.Next(&arrivals[i]);
+        EXPECT_EQ(TXN_PUT, txn->Type());
+        delete txn;
+    }
+    EXPECT_TRUE(fabs(arrivals[1] - 1) < 0.001);
+    EXPECT_TRUE(fabs(arrivals[3] - 2) < 0.001);
+    EXPECT_TRUE(fabs(arrivals[5] - 3) < 0.001);
+
+    TraceLoadGen once(path, false);
+    delete once.NewTxn();
+    delete once.NewTxn();
+    EXPECT_TRUE(once.NewTxn() == nullptr);
+    unlink(path.c_str());
+    END;
+}
+
+// A TxnProcessor records what it was submitted, and replaying the recording
+// through another mode reaches the same database.
+TEST(Trace_RecordReplay)
+{
+    string path = TempPath("trace_rec");
+    RMWLoadGen lg(100, 0, 4, 0);
+    map<Key, Value> expected;
+    int num_txns = 1000;
+    {
+        TxnProcessorOptions options;
+        options.trace_path_ = path;
+        TxnProcessor p(SERIAL, options);
+        for (int i = 0; i < num_txns; i++) p.NewTxnRequest(lg.NewTxn());
+        for (int i = 0; i < num_txns; i++)
+        {
+            Txn* txn = p.GetTxnResult();
+            for (KeySet::const_iterator it = txn->writeset_.begin(); it != txn->writeset_.end(); ++it)
+                expected[*it]++;
+            delete txn;
+        }
+    }
+
+    TraceLoadGen replay(path, false);
+    TxnProcessor p(STRIFE_LM);
+    for (Txn* txn = replay.NewTxn(); txn != nullptr; txn = replay.NewTxn()) p.NewTxnRequest(txn);
+    for (int i = 0; i < num_txns; i++) delete p.GetTxnResult();
+
+    Txn* check = new Expect(expected);
+    check->writeset_.insert(100);
+    p.NewTxnRequest(check);
+    Txn* txn = p.GetTxnResult();
+    EXPECT_EQ(COMMITTED, txn->Status());
+    delete txn;
+    unlink(path.c_str());
+    END;
+}
+
+int main(int argc, char** argv)
+{
+    Trace_RoundTrip();
+    Trace_LoadGen();
+    Trace_RecordReplay();
+}
@@ -11,15 +11,7 @@ bool Txn::Read(const Key& key, Value* value)
 
     // 'reads_' has already been populated by TxnProcessor, so it should contain
     // the target value iff the record appears in the database.
-    if (reads_.count(key))
-    {
-        *value = reads_[key];
-        return true;
-    }
-    else
-    {
-        return false;
-    }
+    return reads_.Get(key, value);
 }
 
 void Txn::Write(const Key& key, const Value& value)
@@ -40,7 +32,7 @@ void Txn::Write(const Key& key, const Value& value)
 
 void Txn::CheckReadWriteSets()
 {
-    for (set<Key>::iterator it = writeset_.begin(); it != writeset_.end(); ++it)
+    for (KeySet::const_iterator it = writeset_.begin(); it != writeset_.end(); ++it)
     {
         if (readset_.count(*it) > 0)
         {
@@ -49,13 +41,28 @@ void Txn::CheckReadWriteSets()
     }
 }
 
+void Txn::Reset()
+{
+    readset_.clear();
+    writeset_.clear();
+    reads_.clear();
+    writes_.clear();
+    status_         = INCOMPLETE;
+    unique_id_      = 0;
+    occ_start_time_ = 0;
+    residual_       = false;
+    memset(stage_time_, 0, sizeof(stage_time_));
+}
+
 void Txn::CopyTxnInternals(Txn* txn) const
 {
-    txn->readset_        = set<Key>(this->readset_);
-    txn->writeset_       = set<Key>(this->writeset_);
-    txn->reads_          = map<Key, Value>(this->reads_);
-    txn->writes_         = map<Key, Value>(this->writes_);
+    txn->readset_        = this->readset_;
+    txn->writeset_       = this->writeset_;
+    txn->reads_          = this->reads_;
+    txn->writes_         = this->writes_;
     txn->status_         = this->status_;
     txn->unique_id_      = this->unique_id_;
     txn->occ_start_time_ = this->occ_start_time_;
+    txn->residual_       = this->residual_;
+    memcpy(txn->stage_time_, this->stage_time_, sizeof(stage_time_));
 }
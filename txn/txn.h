@@ -7,6 +7,7 @@
 #include <vector>
 
 #include "txn/common.h"
+#include "txn/key_set.h"
 
 using std::map;
 using std::set;
@@ -25,29 +26,76 @@ enum TxnStatus
     ABORTED     = 4,  // Aborted
 };
 
+// Points of a txn's way through a TxnProcessor, in order (see stage_time_).
+enum TxnStage
+{
+    TXN_SUBMITTED   = 0,  // Handed to NewTxnRequest(s)
+    TXN_BATCHED     = 1,  // Taken from the request queue by the scheduler
+    TXN_PARTITIONED = 2,  // Placed in a cluster or the residuals (STRIFE only)
+    TXN_STARTED     = 3,  // Execution began
+    TXN_COMMITTED   = 4,  // COMMITTED or ABORTED
+    TXN_RETURNED    = 5,  // Handed back to the client
+    NUM_TXN_STAGES  = 6,
+};
+
+// Concrete txn types that can be reconstructed from their parameters (used by
+// the command log to re-create txns on replay).
+enum TxnType
+{
+    TXN_UNKNOWN        = 0,  // Not loggable
+    TXN_NOOP           = 1,
+    TXN_EXPECT         = 2,
+    TXN_PUT            = 3,
+    TXN_RMW            = 4,
+    TXN_RMW_HOT        = 5,
+    TXN_RMW_PAR        = 6,
+    TXN_TPCC_NEW_ORDER = 7,
+    TXN_TPCC_PAYMENT   = 8,
+};
+
 class Txn
 {
    public:
     // Commit vote defauls to false. Only by calling "commit"
-    Txn() : status_(INCOMPLETE) {}
+    Txn() : residual_(false), status_(INCOMPLETE) { memset(stage_time_, 0, sizeof(stage_time_)); }
     virtual ~Txn() {}
     virtual Txn* clone() const = 0;  // Virtual constructor (copying)
 
     // Method containing all the transaction's method logic.
     virtual void Run() = 0;
 
+    // Returns the concrete type of the txn, TXN_UNKNOWN if it can't be logged.
+    virtual TxnType Type() const { return TXN_UNKNOWN; }
+
+    // Appends the type specific parameters (besides the read/write sets) needed
+    // to reconstruct the txn.
+    virtual void EncodeArgs(vector<uint64>* args) const {}
+
     // Returns the Txn's current execution status.
     TxnStatus Status() { return status_; }
     // Checks for overlap in read and write sets. If any key appears in both,
     // an error occurs.
     void CheckReadWriteSets();
+
+    // Empties the sets and results and makes the txn INCOMPLETE again,
+    // keeping the storage, so the object can be reused (see TxnPool).
+    void Reset();
     
     // Set of all keys that may be updated when executing the transaction.
-    set<Key> writeset_;
+    KeySet writeset_;
 
     // Unique, monotonically increasing transaction ID, assigned by TxnProcessor.
     uint64 unique_id_;
 
+    // CycleClock time the txn reached each stage, 0 for stages its
+    // TxnProcessor mode doesn't have. A restarted txn keeps its submission
+    // time and gets the later stages again.
+    uint64 stage_time_[NUM_TXN_STAGES];
+
+    // Whether a STRIFE scheduler ran the txn in the residual phase rather
+    // than in a conflict free cluster.
+    bool residual_;
+
    protected:
     // Copies the internals of this txn into a given transaction (i.e.
     // the readset, writeset, and so forth).  Be sure to modify this method
@@ -56,6 +104,8 @@ class Txn
 
     friend class TxnProcessor;
     friend class ClustererSerial;
+    friend class TxnCodec;
+    friend class CommandLogReplayer;
 
     // Method to be used inside 'Execute()' function when reading records from
     // the database. If record corresponding with specified 'key' exists, sets
@@ -96,13 +146,13 @@ class Txn
 
     // Set of all keys that may need to be read in order to execute the
     // transaction.
-    set<Key> readset_;
+    KeySet readset_;
 
     // Results of reads performed by the transaction.
-    map<Key, Value> reads_;
+    KeyValueMap reads_;
 
     // Key, Value pairs WRITTEN by the transaction.
-    map<Key, Value> writes_;
+    KeyValueMap writes_;
 
     // Transaction's current execution status.
     TxnStatus status_;
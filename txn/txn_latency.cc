@@ -0,0 +1,115 @@
+#include "txn/txn_latency.h"
+
+#include <atomic>
+#include <iomanip>
+
+#include "utils/cycle_clock.h"
+
+const char* TxnStageToString(TxnStage stage)
+{
+    switch (stage)
+    {
+        case TXN_SUBMITTED:
+            return "submitted";
+        case TXN_BATCHED:
+            return "batched";
+        case TXN_PARTITIONED:
+            return "partitioned";
+        case TXN_STARTED:
+            return "started";
+        case TXN_COMMITTED:
+            return "committed";
+        case TXN_RETURNED:
+            return "returned";
+        default:
+            return "unknown";
+    }
+}
+
+const char* LatencyPathToString(LatencyPath path)
+{
+    return path == PATH_RESIDUAL ? "residual" : "cluster";
+}
+
+void TxnLatencyStats::Merge(const TxnLatencyStats& other)
+{
+    for (int path = 0; path < NUM_LATENCY_PATHS; path++)
+    {
+        total_[path].Merge(other.total_[path]);
+        for (int stage = 0; stage < NUM_TXN_STAGES; stage++) stage_[path][stage].Merge(other.stage_[path][stage]);
+    }
+}
+
+static void ReportLine(std::ostream& out, const char* path, const char* stage, const Histogram& hist)
+{
+    double us = 1e6 / CycleClock::PerSecond();
+    out << std::left << std::setw(10) << path << std::setw(14) << stage << std::right << std::setw(10)
+        << hist.Count() << std::fixed << std::setprecision(1) << std::setw(12) << hist.Percentile(50) * us
+        << std::setw(12) << hist.Percentile(99) * us << std::setw(12) << hist.Percentile(99.9) * us
+        << std::setw(12) << hist.Max() * us << "\n";
+}
+
+void TxnLatencyStats::Report(std::ostream& out) const
+{
+    out << std::left << std::setw(10) << "path" << std::setw(14) << "stage" << std::right << std::setw(10) << "txns"
+        << std::setw(12) << "p50(us)" << std::setw(12) << "p99(us)" << std::setw(12) << "p999(us)" << std::setw(12)
+        << "max(us)"
+        << "\n";
+    for (int path = 0; path < NUM_LATENCY_PATHS; path++)
+    {
+        if (total_[path].Count() == 0) continue;
+        const char* name = LatencyPathToString(static_cast<LatencyPath>(path));
+        for (int stage = TXN_SUBMITTED + 1; stage < NUM_TXN_STAGES; stage++)
+        {
+            if (stage_[path][stage].Count() == 0) continue;
+            ReportLine(out, name, TxnStageToString(static_cast<TxnStage>(stage)), stage_[path][stage]);
+        }
+        ReportLine(out, name, "end-to-end", total_[path]);
+    }
+}
+
+TxnLatencyRecorder::TxnLatencyRecorder() : shards_(new Shard[kShards]) {}
+
+TxnLatencyRecorder::~TxnLatencyRecorder() { delete[] shards_; }
+
+TxnLatencyRecorder::Shard* TxnLatencyRecorder::LocalShard()
+{
+    static std::atomic<uint32> next_shard(0);
+    static thread_local uint32 shard = next_shard.fetch_add(1) % kShards;
+    return &shards_[shard];
+}
+
+void TxnLatencyRecorder::Record(const Txn* txn)
+{
+    const uint64* times = txn->stage_time_;
+    if (times[TXN_SUBMITTED] == 0 || times[TXN_RETURNED] == 0) return;
+    int path = txn->residual_ ? PATH_RESIDUAL : PATH_CLUSTER;
+
+    Shard* shard = LocalShard();
+    shard->mutex_.Lock();
+    TxnLatencyStats* stats = &shard->stats_;
+    // Stages the mode skipped are left out: their time goes to the next one.
+    // Counters of different cores may be a little apart, hence the clamping.
+    uint64 prev = times[TXN_SUBMITTED];
+    for (int stage = TXN_SUBMITTED + 1; stage < NUM_TXN_STAGES; stage++)
+    {
+        if (times[stage] == 0) continue;
+        stats->stage_[path][stage].Record(times[stage] > prev ? times[stage] - prev : 0);
+        prev = times[stage];
+    }
+    uint64 total = times[TXN_RETURNED] > times[TXN_SUBMITTED] ? times[TXN_RETURNED] - times[TXN_SUBMITTED] : 0;
+    stats->total_[path].Record(total);
+    shard->mutex_.Unlock();
+}
+
+TxnLatencyStats TxnLatencyRecorder::Snapshot()
+{
+    TxnLatencyStats stats;
+    for (size_t i = 0; i < kShards; i++)
+    {
+        shards_[i].mutex_.Lock();
+        stats.Merge(shards_[i].stats_);
+        shards_[i].mutex_.Unlock();
+    }
+    return stats;
+}
@@ -0,0 +1,75 @@
+// Latency of the txns of a TxnProcessor, per pipeline stage (see TxnStage).
+// Every returned txn adds the time it spent between each two consecutive
+// stages it went through, and from submission to return, to the histograms of
+// its path: run in a conflict free cluster (or by a non-STRIFE scheduler), or
+// in the STRIFE residual phase. Batching hides its tails behind throughput,
+// so the percentiles are what to look at.
+
+#ifndef _TXN_LATENCY_H_
+#define _TXN_LATENCY_H_
+
+#include <ostream>
+
+#include "txn/txn.h"
+#include "utils/global.h"
+#include "utils/histogram.h"
+#include "utils/mutex.h"
+
+enum LatencyPath
+{
+    PATH_CLUSTER      = 0,
+    PATH_RESIDUAL     = 1,
+    NUM_LATENCY_PATHS = 2,
+};
+
+const char* TxnStageToString(TxnStage stage);
+const char* LatencyPathToString(LatencyPath path);
+
+// Histograms of CycleClock ticks.
+struct TxnLatencyStats
+{
+    // Submission to return.
+    Histogram total_[NUM_LATENCY_PATHS];
+
+    // stage_[path][s]: from the previous stage the txn went through to s
+    // (stage_[path][TXN_SUBMITTED] stays empty).
+    Histogram stage_[NUM_LATENCY_PATHS][NUM_TXN_STAGES];
+
+    void Merge(const TxnLatencyStats& other);
+
+    // Writes count, p50, p99, p999 and max (in microseconds) of every stage
+    // and path that has samples.
+    void Report(std::ostream& out) const;
+};
+
+// Thread safe, sharded per thread like TxnPool.
+class TxnLatencyRecorder
+{
+   public:
+    TxnLatencyRecorder();
+    ~TxnLatencyRecorder();
+
+    // Adds the stage times of 'txn', which has reached TXN_RETURNED.
+    void Record(const Txn* txn);
+
+    // Sum of all the txns recorded so far.
+    TxnLatencyStats Snapshot();
+
+    static const size_t kShards = 8;
+
+   private:
+    struct Shard
+    {
+        Mutex mutex_;
+        TxnLatencyStats stats_;
+    };
+
+    Shard* LocalShard();
+
+    // On the heap: a shard is a few hundred KB.
+    Shard* shards_;
+
+    DISALLOW_CLASS_COPY_AND_ASSIGN(TxnLatencyRecorder);
+};
+
+#endif  // _TXN_LATENCY_H_
@@ -0,0 +1,78 @@
+#include "txn/txn_latency.h"
+
+#include <sstream>
+
+#include "txn/load_generator.h"
+#include "txn/txn_processor.h"
+#include "txn/txn_types.h"
+#include "utils/testing.h"
+
+TEST(TxnLatency_Stages)
+{
+    TxnLatencyRecorder recorder;
+    Noop txn;
+    txn.stage_time_[TXN_SUBMITTED] = 1000;
+    txn.stage_time_[TXN_BATCHED]   = 1010;
+    txn.stage_time_[TXN_STARTED]   = 1030;
+    txn.stage_time_[TXN_COMMITTED] = 1025;  // another core's counter, a bit behind
+    txn.stage_time_[TXN_RETURNED]  = 1100;
+    recorder.Record(&txn);
+
+    // Not returned yet: ignored.
+    Noop pending;
+    pending.stage_time_[TXN_SUBMITTED] = 1;
+    recorder.Record(&pending);
+
+    TxnLatencyStats stats = recorder.Snapshot();
+    EXPECT_EQ(1, (int)stats.total_[PATH_CLUSTER].Count());
+    EXPECT_EQ(100, (int)stats.total_[PATH_CLUSTER].Max());
+    EXPECT_EQ(0, (int)stats.total_[PATH_RESIDUAL].Count());
+    EXPECT_EQ(10, (int)stats.stage_[PATH_CLUSTER][TXN_BATCHED].Max());
+    // The skipped partitioning counts towards the start.
+    EXPECT_EQ(0, (int)stats.stage_[PATH_CLUSTER][TXN_PARTITIONED].Count());
+    EXPECT_EQ(20, (int)stats.stage_[PATH_CLUSTER][TXN_STARTED].Max());
+    EXPECT_EQ(0, (int)stats.stage_[PATH_CLUSTER][TXN_COMMITTED].Max());
+    EXPECT_EQ(75, (int)stats.stage_[PATH_CLUSTER][TXN_RETURNED].Max());
+
+    txn.residual_ = true;
+    recorder.Record(&txn);
+    EXPECT_EQ(1, (int)recorder.Snapshot().total_[PATH_RESIDUAL].Count());
+    END;
+}
+
+// Runs 'num_txns' txns through a processor in 'mode' and returns its stats.
+static TxnLatencyStats RunTxns(CCMode mode, int num_txns)
+{
+    TxnProcessor p(mode);
+    RMWLoadGen lg(50, 2, 2, 0);
+    for (int i = 0; i < num_txns; i++) p.NewTxnRequest(lg.NewTxn());
+    for (int i = 0; i < num_txns; i++) delete p.GetTxnResult();
+    return p.LatencyStats();
+}
+
+TEST(TxnLatency_Processor)
+{
+    int num_txns = 2000;
+
+    TxnLatencyStats serial = RunTxns(SERIAL, num_txns);
+    EXPECT_EQ(num_txns, (int)serial.total_[PATH_CLUSTER].Count());
+    EXPECT_EQ(num_txns, (int)serial.stage_[PATH_CLUSTER][TXN_STARTED].Count());
+    EXPECT_EQ(0, (int)serial.stage_[PATH_CLUSTER][TXN_PARTITIONED].Count());
+
+    TxnLatencyStats strife = RunTxns(STRIFE_LM, num_txns);
+    EXPECT_EQ(num_txns, (int)(strife.total_[PATH_CLUSTER].Count() + strife.total_[PATH_RESIDUAL].Count()));
+    for (int path = 0; path < NUM_LATENCY_PATHS; path++)
+        EXPECT_EQ(strife.total_[path].Count(), strife.stage_[path][TXN_PARTITIONED].Count());
+
+    std::ostringstream report;
+    strife.Report(report);
+    EXPECT_TRUE(report.str().find("end-to-end") != string::npos);
+    EXPECT_TRUE(report.str().find("partitioned") != string::npos);
+    END;
+}
+
+int main(int argc, char** argv)
+{
+    TxnLatency_Stages();
+    TxnLatency_Processor();
+}
@@ -0,0 +1,70 @@
+#include "txn/txn_pool.h"
+
+// Types Acquire() can hand out again (default constructible, with kType).
+static bool Poolable(TxnType type)
+{
+    return type == TXN_NOOP || type == TXN_RMW || type == TXN_RMW_HOT || type == TXN_RMW_PAR;
+}
+
+TxnPool::~TxnPool()
+{
+    for (size_t i = 0; i < kShards; i++)
+        for (int type = 0; type < kNumTypes; type++)
+            for (size_t j = 0; j < shards_[i].free_[type].size(); j++) delete shards_[i].free_[type][j];
+}
+
+TxnPool::Shard* TxnPool::LocalShard()
+{
+    static std::atomic<uint32> next_shard(0);
+    static thread_local uint32 shard = next_shard.fetch_add(1) % kShards;
+    return &shards_[shard];
+}
+
+Txn* TxnPool::Pop(TxnType type)
+{
+    size_t local = LocalShard() - shards_;
+    for (size_t i = 0; i < kShards; i++)
+    {
+        Shard* shard = &shards_[(local + i) % kShards];
+        if (shard->num_free_[type].load(std::memory_order_relaxed) == 0) continue;
+        Txn* txn = PopFrom(shard, type);
+        if (txn != nullptr) return txn;
+    }
+    return nullptr;
+}
+
+Txn* TxnPool::PopFrom(Shard* shard, TxnType type)
+{
+    Txn* txn = nullptr;
+    shard->mutex_.Lock();
+    if (!shard->free_[type].empty())
+    {
+        txn = shard->free_[type].back();
+        shard->free_[type].pop_back();
+        shard->num_free_[type].store(shard->free_[type].size(), std::memory_order_relaxed);
+    }
+    shard->mutex_.Unlock();
+    return txn;
+}
+
+void TxnPool::Release(Txn* txn)
+{
+    TxnType type = txn->Type();
+    if (!Poolable(type))
+    {
+        delete txn;
+        return;
+    }
+
+    txn->Reset();
+    Shard* shard = LocalShard();
+    shard->mutex_.Lock();
+    bool kept = shard->free_[type].size() < kMaxFree;
+    if (kept)
+    {
+        shard->free_[type].push_back(txn);
+        shard->num_free_[type].store(shard->free_[type].size(), std::memory_order_relaxed);
+    }
+    shard->mutex_.Unlock();
+    if (!kept) delete txn;
+}
@@ -0,0 +1,78 @@
+// Recycles txn objects, with the storage of their key sets, between the
+// clients that create txns and the ones that consume the results. Released
+// txns are reset and kept on free lists per txn type, in shards picked per
+// thread, so a thread usually gets back the txns it released without
+// contending with the others. A thread whose shard has none left takes them
+// from the other shards, so txns also flow from a thread that only releases
+// (e.g. the result collector of an open loop run) to ones that only acquire.
+
+#ifndef _TXN_POOL_H_
+#define _TXN_POOL_H_
+
+#include <atomic>
+#include <vector>
+
+#include "txn/txn.h"
+#include "utils/global.h"
+#include "utils/mutex.h"
+
+using std::vector;
+
+class TxnPool
+{
+   public:
+    TxnPool() : allocated_(0) {}
+    // Deletes the free txns. Txns still out are owned by their holders.
+    ~TxnPool();
+
+    // Returns a reset T (a Txn type defining kType), recycled if possible.
+    template <class T>
+    T* Acquire()
+    {
+        Txn* txn = Pop(T::kType);
+        if (txn != nullptr) return static_cast<T*>(txn);
+        allocated_++;
+        return new T();
+    }
+
+    // Takes back 'txn', of any type. Txns of types that can't be pooled
+    // (Expect, Put, unknown), or beyond kMaxFree per type and shard, are
+    // deleted.
+    void Release(Txn* txn);
+
+    // Number of txns created by Acquire() so far.
+    uint64 NumAllocated() { return allocated_.load(); }
+
+    static const size_t kShards  = 16;
+    static const size_t kMaxFree = 4096;
+
+   private:
+    static const int kNumTypes = TXN_RMW_PAR + 1;
+
+    struct Shard
+    {
+        Shard()
+        {
+            for (int type = 0; type < kNumTypes; type++) num_free_[type] = 0;
+        }
+
+        Mutex mutex_;
+        vector<Txn*> free_[kNumTypes];
+        // Sizes of free_, read without the mutex to skip empty shards.
+        std::atomic<size_t> num_free_[kNumTypes];
+    };
+
+    // Shard of the calling thread.
+    Shard* LocalShard();
+    // A free txn of 'type' from the calling thread's shard, else from any
+    // other, nullptr if there is none.
+    Txn* Pop(TxnType type);
+    static Txn* PopFrom(Shard* shard, TxnType type);
+
+    Shard shards_[kShards];
+    std::atomic<uint64> allocated_;
+
+    DISALLOW_CLASS_COPY_AND_ASSIGN(TxnPool);
+};
+
+#endif  // _TXN_POOL_H_
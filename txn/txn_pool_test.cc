@@ -0,0 +1,119 @@
+#include "txn/txn_pool.h"
+
+#include <pthread.h>
+
+#include "txn/load_generator.h"
+#include "txn/txn_processor.h"
+#include "utils/testing.h"
+
+TEST(TxnPool_Recycles)
+{
+    TxnPool pool;
+    RMW* txn = pool.Acquire<RMW>();
+    txn->Init(100, 3, 2);
+    txn->unique_id_ = 7;
+    EXPECT_EQ(2, (int)txn->writeset_.size());
+    EXPECT_EQ(1, (int)pool.NumAllocated());
+
+    pool.Release(txn);
+    RMW* again = pool.Acquire<RMW>();
+    EXPECT_TRUE(again == txn);
+    EXPECT_EQ(1, (int)pool.NumAllocated());
+    EXPECT_EQ(INCOMPLETE, again->Status());
+    EXPECT_EQ(0, (int)again->writeset_.size());
+    EXPECT_EQ(0, (int)again->unique_id_);
+
+    // Types don't mix, and unpoolable txns are deleted.
+    pool.Release(again);
+    Noop* noop = pool.Acquire<Noop>();
+    EXPECT_TRUE(reinterpret_cast<Txn*>(noop) != reinterpret_cast<Txn*>(txn));
+    EXPECT_EQ(2, (int)pool.NumAllocated());
+    pool.Release(noop);
+    pool.Release(new Put(map<Key, Value>()));
+    END;
+}
+
+static void* ChurnTxns(void* arg)
+{
+    TxnPool* pool = reinterpret_cast<TxnPool*>(arg);
+    RMW* txns[64];
+    for (int round = 0; round < 1000; round++)
+    {
+        for (int i = 0; i < 64; i++)
+        {
+            txns[i] = pool->Acquire<RMW>();
+            txns[i]->Init(1000, 2, 2);
+        }
+        for (int i = 0; i < 64; i++) pool->Release(txns[i]);
+    }
+    return NULL;
+}
+
+TEST(TxnPool_Threads)
+{
+    // Every thread keeps reusing its own 64 txns.
+    TxnPool pool;
+    pthread_t threads[4];
+    for (int t = 0; t < 4; t++) pthread_create(&threads[t], NULL, ChurnTxns, &pool);
+    for (int t = 0; t < 4; t++) pthread_join(threads[t], NULL);
+    EXPECT_TRUE(pool.NumAllocated() <= 4 * 64);
+    END;
+}
+
+static void* ReleaseTxns(void* arg)
+{
+    std::pair<TxnPool*, RMW**>* txns = reinterpret_cast<std::pair<TxnPool*, RMW**>*>(arg);
+    for (int i = 0; i < 64; i++) txns->first->Release(txns->second[i]);
+    delete txns;
+    return NULL;
+}
+
+static void* AcquireTxns(void* arg)
+{
+    TxnPool* pool = reinterpret_cast<TxnPool*>(arg);
+    RMW* txns[64];
+    for (int i = 0; i < 64; i++) txns[i] = pool->Acquire<RMW>();
+    // The txns go back through another thread's shard.
+    pthread_t releaser;
+    pthread_create(&releaser, NULL, ReleaseTxns, new std::pair<TxnPool*, RMW**>(pool, txns));
+    pthread_join(releaser, NULL);
+    return NULL;
+}
+
+TEST(TxnPool_CrossThread)
+{
+    TxnPool pool;
+    for (int round = 0; round < 10; round++)
+    {
+        pthread_t acquirer;
+        pthread_create(&acquirer, NULL, AcquireTxns, &pool);
+        pthread_join(acquirer, NULL);
+    }
+    EXPECT_EQ(64, (int)pool.NumAllocated());
+    END;
+}
+
+TEST(TxnPool_Processor)
+{
+    // Results go back to the pool and come back as new requests.
+    TxnProcessor p(SERIAL);
+    RMWLoadGen lg(1000, 2, 2, 0);
+    for (int i = 0; i < 100; i++) p.NewTxnRequest(lg.NewPooledTxn(p.Pool()));
+    for (int i = 0; i < 10000; i++)
+    {
+        Txn* txn = p.GetTxnResult();
+        EXPECT_EQ(COMMITTED, txn->Status());
+        p.ReleaseTxn(txn);
+        if (i < 9900) p.NewTxnRequest(lg.NewPooledTxn(p.Pool()));
+    }
+    EXPECT_TRUE(p.Pool()->NumAllocated() <= 200);
+    END;
+}
+
+int main(int argc, char** argv)
+{
+    TxnPool_Recycles();
+    TxnPool_Threads();
+    TxnPool_CrossThread();
+    TxnPool_Processor();
+}
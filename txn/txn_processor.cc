@@ -6,16 +6,22 @@
 #include "txn/strife_itf.h"
 #include "txn/lock_manager.h"
 #include "txn/printer.h"
+#include "utils/cycle_clock.h"
 
 
-TxnProcessor::TxnProcessor(CCMode mode) : mode_(mode), tp_(THREAD_COUNT), next_unique_id_(1)
+TxnProcessor::TxnProcessor(CCMode mode) : TxnProcessor(mode, TxnProcessorOptions()) {}
+
+TxnProcessor::TxnProcessor(CCMode mode, const TxnProcessorOptions& options)
+    : mode_(mode), options_(options), tp_(options_.worker_threads_), cluster_(nullptr), command_log_(nullptr),
+      log_schedules_(false), trace_(nullptr), graphs_(nullptr), checkpointer_(nullptr), batch_id_(0), lock_retries_(0), counter_(0), lm_(nullptr),
+      watermark_(nullptr), stopped_(false)
 {
-    if (mode_ == LOCKING_EXCLUSIVE_ONLY || mode_ == STRIFE_S)
+    if (mode_ == LOCKING_EXCLUSIVE_ONLY)
         lm_ = new LockManagerA(&ready_txns_);
-    else if (mode_ == LOCKING || mode_ == STRIFE_S)
+    else if (mode_ == LOCKING)
         lm_ = new LockManagerB(&ready_txns_);
     else if (mode_ == STRIFE_LM || mode_ == STRIFE_PLM)
-        lm_ = new LockManagerC();
+        lm_ = new LockManagerC(options_.lock_policy_);
     // Create the storage
     if (mode_ == MVCC)
     {
@@ -43,6 +49,42 @@ TxnProcessor::TxnProcessor(CCMode mode) : mode_(mode), tp_(THREAD_COUNT), next_u
 
     storage_->InitStorage();
 
+    if (options_.perf_counters_ && cluster_ != nullptr) cluster_->EnablePerfCounters();
+
+    // Replay re-partitions the logged batches with ClustererSerial, or runs the
+    // logged schedules of ClustererParallel, which only reproduces the
+    // conflict-free STRIFE executors.
+    if (!options_.command_log_path_.empty())
+    {
+        if (mode_ != STRIFE_S && mode_ != STRIFE_PM && mode_ != STRIFE_P && mode_ != STRIFE_PM_P)
+            DIE("Command logging is not supported in mode " << mode_);
+        command_log_   = new CommandLog(options_.command_log_path_, options_.command_log_sync_);
+        log_schedules_ = mode_ == STRIFE_P || mode_ == STRIFE_PM_P;
+    }
+
+    if (!options_.trace_path_.empty()) trace_ = new TraceWriter(options_.trace_path_);
+
+    if (!options_.graph_path_.empty() && cluster_ != nullptr)
+    {
+        graphs_ = new BatchGraphWriter(options_.graph_path_);
+        cluster_->ExportGraphs(graphs_);
+    }
+
+    // Checkpoints start at STRIFE batch boundaries, the other schedulers have none.
+    if (!options_.checkpoint_path_.empty())
+    {
+        if (cluster_ == nullptr) DIE("Checkpoints are not supported in mode " << mode_);
+        checkpointer_ = new Checkpointer(storage_, options_.checkpoint_path_, options_.checkpoint_interval_,
+                                         options_.checkpoint_rate_);
+    }
+
+    if (mode_ == MVCC)
+    {
+        watermark_ = new TxnWatermark();
+        if (options_.gc_interval_ > 0)
+            pthread_create(&gc_thread_, NULL, StartGarbageCollector, reinterpret_cast<void*>(this));
+    }
+
     // Start 'RunScheduler()' running.
 
     pthread_attr_t attr;
@@ -61,10 +103,7 @@ TxnProcessor::TxnProcessor(CCMode mode) : mode_(mode), tp_(THREAD_COUNT), next_u
     pthread_t scheduler_;
     pthread_create(&scheduler_, &attr, StartScheduler, reinterpret_cast<void*>(this));
 
-    stopped_          = false;
     scheduler_thread_ = scheduler_;
-
-    counter_ = Atomic<int>(0);
 }
 
 void* TxnProcessor::StartScheduler(void* arg)
@@ -78,47 +117,83 @@ TxnProcessor::~TxnProcessor()
     // Wait for the scheduler thread to join back before destroying the object and its thread pool.
     stopped_ = true;
     pthread_join(scheduler_thread_, NULL);
+    if (watermark_ != nullptr && options_.gc_interval_ > 0) pthread_join(gc_thread_, NULL);
 
-    if (mode_ == LOCKING_EXCLUSIVE_ONLY || mode_ == LOCKING) delete lm_;
+    delete lm_;
 
+    delete checkpointer_;
+    delete command_log_;
+    delete trace_;
+    delete graphs_;
+    delete watermark_;
     delete storage_;
 }
 
 void TxnProcessor::NewTxnRequest(Txn* txn)
 {
-    // Atomically assign the txn a new number and add it to the incoming txn
-    // requests queue.
-    mutex_.Lock();
-    txn->unique_id_ = next_unique_id_;
-    next_unique_id_++;
+    // The txn gets its unique id once the scheduler takes it from the queue.
+    if (txn->stage_time_[TXN_SUBMITTED] == 0) txn->stage_time_[TXN_SUBMITTED] = CycleClock::Now();
+    if (trace_ != nullptr) trace_->Record(txn, txn->stage_time_[TXN_SUBMITTED]);
     txn_requests_.Push(txn);
-    mutex_.Unlock();
 }
 
-void TxnProcessor::NewTxnRequests(queue<Txn*> txn_queue)
+void TxnProcessor::NewTxnRequests(queue<Txn*>& txn_queue)
 {
-    mutex_.Lock();
+    uint64 now = CycleClock::Now();
     while (txn_queue.size() != 0)
     {
-        Txn* tmp = txn_queue.front();
+        Txn* txn = txn_queue.front();
+        if (txn->stage_time_[TXN_SUBMITTED] == 0) txn->stage_time_[TXN_SUBMITTED] = now;
+        if (trace_ != nullptr) trace_->Record(txn, txn->stage_time_[TXN_SUBMITTED]);
+        txn_requests_.Push(txn);
         txn_queue.pop();
-        tmp->unique_id_ = next_unique_id_;
-        next_unique_id_++;
-        txn_requests_.Push(tmp);
     }
-    mutex_.Unlock();
 }
 
 Txn* TxnProcessor::GetTxnResult()
 {
     Txn* txn;
-    while (!txn_results_.Pop(&txn))
+    GetTxnResults(&txn, 1);
+    return txn;
+}
+
+int TxnProcessor::GetTxnResults(Txn** results, int max, bool block)
+{
+    int n = txn_results_.Pop_n(results, max);
+    while (n == 0 && block)
     {
-        // No result yet. Wait a bit before trying again (to reduce contention on
-        // atomic queues).
-        usleep(1);
+        int key = results_ready_.PrepareWait();
+        n       = txn_results_.Pop_n(results, max);
+        if (n != 0)
+        {
+            results_ready_.CancelWait();
+            break;
+        }
+        results_ready_.Wait(key);
+        n = txn_results_.Pop_n(results, max);
     }
-    return txn;
+
+    uint64 now = CycleClock::Now();
+    for (int i = 0; i < n; i++)
+    {
+        results[i]->stage_time_[TXN_RETURNED] = now;
+        latency_.Record(results[i]);
+    }
+    return n;
+}
+
+void TxnProcessor::DeliverResult(Txn* txn)
+{
+    txn->stage_time_[TXN_COMMITTED] = CycleClock::Now();
+    if (options_.result_callback_)
+    {
+        txn->stage_time_[TXN_RETURNED] = txn->stage_time_[TXN_COMMITTED];
+        latency_.Record(txn);
+        options_.result_callback_(txn);
+        return;
+    }
+    txn_results_.Push(txn);
+    results_ready_.NotifyAll();
 }
 
 void TxnProcessor::RunScheduler()
@@ -185,35 +260,94 @@ void TxnProcessor::RunSerialScheduler() {
       }
 
       // Return result to client.
-      txn_results_.Push(txn);
+      DeliverResult(txn);
     }
   }
 }
 
 void TxnProcessor::RunLockingScheduler()
 {
-    RunSerialScheduler(); 
+    Txn* txn;
+    while (!stopped_)
+    {
+        // Request all locks of the next txn, in arrival order. Queues are
+        // FIFO, so a txn only ever waits for older txns: no deadlocks.
+        if (txn_requests_.Pop(&txn))
+        {
+            lm_->BeginRequests(txn);
+            for (KeySet::const_iterator it = txn->readset_.begin(); it != txn->readset_.end(); ++it)
+                lm_->ReadLock(txn, *it);
+            for (KeySet::const_iterator it = txn->writeset_.begin(); it != txn->writeset_.end(); ++it)
+                lm_->WriteLock(txn, *it);
+            lm_->EndRequests(txn);
+        }
+
+        // Hand the txns holding all their locks to the workers.
+        while (lm_->NextReady(&txn))
+        {
+            tp_.AddTask([this, txn]() { this->LockingExecuteTxn(txn); });
+        }
+    }
+}
+
+void TxnProcessor::LockingExecuteTxn(Txn* txn)
+{
+    txn->stage_time_[TXN_STARTED] = CycleClock::Now();
+    txn->occ_start_time_ = GetTime();
+    for (KeySet::const_iterator it = txn->readset_.begin(); it != txn->readset_.end(); ++it)
+    {
+        Value result;
+        if (storage_->Read(*it, &result)) txn->reads_[*it] = result;
+    }
+    for (KeySet::const_iterator it = txn->writeset_.begin(); it != txn->writeset_.end(); ++it)
+    {
+        Value result;
+        if (storage_->Read(*it, &result)) txn->reads_[*it] = result;
+    }
+
+    txn->Run();
+
+    if (txn->Status() == COMPLETED_C)
+    {
+        ApplyWrites(txn);
+        txn->status_ = COMMITTED;
+    }
+    else if (txn->Status() == COMPLETED_A)
+    {
+        txn->status_ = ABORTED;
+    }
+    else
+    {
+        DIE("Completed Txn has invalid TxnStatus: " << txn->Status());
+    }
+
+    // Releasing may make waiting txns ready, the scheduler picks them up.
+    for (KeySet::const_iterator it = txn->readset_.begin(); it != txn->readset_.end(); ++it) lm_->Release(txn, *it);
+    for (KeySet::const_iterator it = txn->writeset_.begin(); it != txn->writeset_.end(); ++it) lm_->Release(txn, *it);
+
+    DeliverResult(txn);
 }
 
 void TxnProcessor::ExecuteTxn(Txn* txn)
 {
     // Get the start time
+    txn->stage_time_[TXN_STARTED] = CycleClock::Now();
     txn->occ_start_time_ = GetTime();
 
     // Read everything in from readset.
-    for (set<Key>::iterator it = txn->readset_.begin(); it != txn->readset_.end(); ++it)
+    for (KeySet::const_iterator it = txn->readset_.begin(); it != txn->readset_.end(); ++it)
     {
         // Save each read result iff record exists in storage.
         Value result;
-        if (storage_->Read(*it, &result)) txn->reads_[*it] = result;
+        if (storage_->Read(*it, &result, txn->unique_id_)) txn->reads_[*it] = result;
     }
 
     // Also read everything in from writeset.
-    for (set<Key>::iterator it = txn->writeset_.begin(); it != txn->writeset_.end(); ++it)
+    for (KeySet::const_iterator it = txn->writeset_.begin(); it != txn->writeset_.end(); ++it)
     {
         // Save each read result iff record exists in storage.
         Value result;
-        if (storage_->Read(*it, &result)) txn->reads_[*it] = result;
+        if (storage_->Read(*it, &result, txn->unique_id_)) txn->reads_[*it] = result;
     }
 
     // Execute txn's program logic.
@@ -226,7 +360,7 @@ void TxnProcessor::ExecuteTxn(Txn* txn)
 void TxnProcessor::ApplyWrites(Txn* txn)
 {
     // Write buffered writes out to storage.
-    for (map<Key, Value>::iterator it = txn->writes_.begin(); it != txn->writes_.end(); ++it)
+    for (KeyValueMap::const_iterator it = txn->writes_.begin(); it != txn->writes_.end(); ++it)
     {
         storage_->Write(it->first, it->second, txn->unique_id_);
     }
@@ -234,53 +368,259 @@ void TxnProcessor::ApplyWrites(Txn* txn)
 
 void TxnProcessor::RunOCCScheduler()
 {
-    //
-    // Implement this method!
-    //
-    // [For now, run serial scheduler in order to make it through the test
-    // suite]
-    RunSerialScheduler();
+    Txn* txn;
+    while (!stopped_)
+    {
+        // Start the read/execute phase of new requests on the workers.
+        if (txn_requests_.Pop(&txn))
+        {
+            tp_.AddTask([this, txn]() { this->ExecuteTxn(txn); });
+        }
+
+        // Validate and commit the txns that finished executing, one at a time.
+        while (completed_txns_.Pop(&txn))
+        {
+            if (txn->Status() == COMPLETED_A)
+            {
+                txn->status_ = ABORTED;
+            }
+            else if (txn->Status() != COMPLETED_C)
+            {
+                DIE("Completed Txn has invalid TxnStatus: " << txn->Status());
+            }
+            else if (SerialValidate(txn))
+            {
+                ApplyWrites(txn);
+                txn->status_ = COMMITTED;
+            }
+            else
+            {
+                // Clean up and restart with a new id.
+                txn->reads_.clear();
+                txn->writes_.clear();
+                txn->status_ = INCOMPLETE;
 
+                txn_requests_.PushShared(txn);
+                continue;
+            }
+
+            DeliverResult(txn);
+        }
+    }
+}
+
+// A txn is valid if none of the records it read was written after it started
+// reading. Writes in the same microsecond count as conflicts.
+bool TxnProcessor::SerialValidate(Txn* txn)
+{
+    for (KeySet::const_iterator it = txn->readset_.begin(); it != txn->readset_.end(); ++it)
+        if (storage_->Timestamp(*it) >= txn->occ_start_time_) return false;
+    for (KeySet::const_iterator it = txn->writeset_.begin(); it != txn->writeset_.end(); ++it)
+        if (storage_->Timestamp(*it) >= txn->occ_start_time_) return false;
+    return true;
 }
 
 void TxnProcessor::RunOCCParallelScheduler()
 {
-    //
-    // Implement this method! Note that implementing OCC with parallel
-    // validation may need to create another method, like
-    // TxnProcessor::ExecuteTxnParallel.
-    // Note that you can use active_set_ and active_set_mutex_ we provided
-    // for you in the txn_processor.h
-    //
-    // [For now, run serial scheduler in order to make it through the test
-    // suite]
-    RunSerialScheduler();
-}
-
-void TxnProcessor::ExecuteTxnParallel(Txn *txn)
+    // Workers validate their own txns, see ExecuteTxnParallel().
+    Txn* txn;
+    while (!stopped_)
+    {
+        if (txn_requests_.Pop(&txn))
+        {
+            tp_.AddTask([this, txn]() { this->ExecuteTxnParallel(txn); });
+        }
+    }
+}
+
+void TxnProcessor::ExecuteTxnParallel(Txn* txn)
+{
+    txn->stage_time_[TXN_STARTED] = CycleClock::Now();
+    txn->occ_start_time_ = GetTime();
+
+    for (KeySet::const_iterator it = txn->readset_.begin(); it != txn->readset_.end(); ++it)
+    {
+        Value result;
+        if (storage_->Read(*it, &result)) txn->reads_[*it] = result;
+    }
+    for (KeySet::const_iterator it = txn->writeset_.begin(); it != txn->writeset_.end(); ++it)
+    {
+        Value result;
+        if (storage_->Read(*it, &result)) txn->reads_[*it] = result;
+    }
+
+    txn->Run();
+
+    if (txn->Status() == COMPLETED_A)
+    {
+        txn->status_ = ABORTED;
+        DeliverResult(txn);
+        return;
+    }
+    else if (txn->Status() != COMPLETED_C)
+    {
+        DIE("Completed Txn has invalid TxnStatus: " << txn->Status());
+    }
+
+    // Check the active txns first: those finishing after the scan have
+    // applied their writes, so the timestamps catch them.
+    uint64 ticket = active_set_.Enter(txn->writeset_);
+    bool valid    = !active_set_.Conflicts(ticket, txn->readset_, txn->writeset_) && SerialValidate(txn);
+    if (valid) ApplyWrites(txn);
+    active_set_.Leave(ticket);
+
+    if (valid)
+    {
+        txn->status_ = COMMITTED;
+        DeliverResult(txn);
+    }
+    else
+    {
+        // Clean up and restart with a new id.
+        txn->reads_.clear();
+        txn->writes_.clear();
+        txn->status_ = INCOMPLETE;
+
+        txn_requests_.PushShared(txn);
+    }
+}
+
+void TxnProcessor::RunMVCCScheduler()
 {
+    // Txns are popped in id order (ids are assigned as they are queued), which
+    // is the order the watermark needs them to start in.
+    Txn* txn;
+    while (!stopped_)
+    {
+        if (txn_requests_.Pop(&txn))
+        {
+            watermark_->Start(txn->unique_id_);
+            tp_.AddTask([this, txn]() { this->MVCCExecuteTxn(txn); });
+        }
+    }
+}
 
+// Write sets are sorted, so txns lock their keys in the same order.
+void TxnProcessor::MVCCLockWriteKeys(Txn* txn)
+{
+    for (KeySet::const_iterator it = txn->writeset_.begin(); it != txn->writeset_.end(); ++it) storage_->Lock(*it);
 }
 
+bool TxnProcessor::MVCCCheckWrites(Txn* txn)
+{
+    for (KeySet::const_iterator it = txn->writeset_.begin(); it != txn->writeset_.end(); ++it)
+        if (!storage_->CheckWrite(*it, txn->unique_id_)) return false;
+    return true;
+}
 
+void TxnProcessor::MVCCUnlockWriteKeys(Txn* txn)
+{
+    for (KeySet::const_iterator it = txn->writeset_.begin(); it != txn->writeset_.end(); ++it) storage_->Unlock(*it);
+}
 
+void* TxnProcessor::StartGarbageCollector(void* arg)
+{
+    TxnProcessor* processor = reinterpret_cast<TxnProcessor*>(arg);
+    while (!processor->stopped_)
+    {
+        processor->GarbageCollection();
+        Sleep(processor->options_.gc_interval_);
+    }
+    return NULL;
+}
 
-void TxnProcessor::RunMVCCScheduler()
+void TxnProcessor::GarbageCollection()
 {
-    //
-    // Implement this method!
+    static_cast<MVCCStorage*>(storage_)->CollectGarbage(watermark_->LowWatermark());
+}
+
+MVCCGCStats TxnProcessor::GCStats()
+{
+    if (mode_ != MVCC) return MVCCGCStats();
+    return static_cast<MVCCStorage*>(storage_)->GCStats();
+}
 
-    // Hint:Pop a txn from txn_requests_, and pass it to a thread to execute.
-    // Note that you may need to create another execute method, like TxnProcessor::MVCCExecuteTxn.
-    //
-    // [For now, run serial scheduler in order to make it through the test
-    // suite]
-    RunSerialScheduler();
+uint64 TxnProcessor::LockRetries() { return lock_retries_.load(); }
+
+PartitionStats TxnProcessor::STRIFEStats()
+{
+    if (cluster_ == nullptr) return PartitionStats();
+    return cluster_->Stats();
+}
+
+TxnLatencyStats TxnProcessor::LatencyStats() { return latency_.Snapshot(); }
+
+ExecutorPerfStats TxnProcessor::ExecutorPerf()
+{
+    executor_perf_mutex_.Lock();
+    ExecutorPerfStats stats = executor_perf_;
+    executor_perf_mutex_.Unlock();
+    return stats;
+}
+
+void TxnProcessor::RecordExecutorPerf(bool reap, bool new_queue, uint64* txns, PerfSample* begin)
+{
+    PerfSample now = PerfCounters::ThreadLocal().Read();
+    int path       = reap ? PATH_CLUSTER : PATH_RESIDUAL;
+    executor_perf_mutex_.Lock();
+    if (new_queue) executor_perf_.queues_[path]++;
+    executor_perf_.txns_[path] += *txns;
+    executor_perf_.events_[path] += now - *begin;
+    executor_perf_mutex_.Unlock();
+    *txns  = 0;
+    *begin = now;
 }
 
-void TxnProcessor::MVCCExecuteTxn(Txn *txn)
+// Reads at the txn's timestamp, then validates and applies its writes under
+// the locks of its write set. Txns failing validation restart with a new id.
+void TxnProcessor::MVCCExecuteTxn(Txn* txn)
 {
-    return;
+    txn->stage_time_[TXN_STARTED] = CycleClock::Now();
+    for (KeySet::const_iterator it = txn->readset_.begin(); it != txn->readset_.end(); ++it)
+    {
+        Value result;
+        if (storage_->Read(*it, &result, txn->unique_id_)) txn->reads_[*it] = result;
+    }
+    for (KeySet::const_iterator it = txn->writeset_.begin(); it != txn->writeset_.end(); ++it)
+    {
+        Value result;
+        if (storage_->Read(*it, &result, txn->unique_id_)) txn->reads_[*it] = result;
+    }
+
+    txn->Run();
+
+    if (txn->Status() == COMPLETED_A)
+    {
+        txn->status_ = ABORTED;
+    }
+    else if (txn->Status() == COMPLETED_C)
+    {
+        MVCCLockWriteKeys(txn);
+        bool valid = MVCCCheckWrites(txn);
+        if (valid) ApplyWrites(txn);
+        MVCCUnlockWriteKeys(txn);
+
+        if (!valid)
+        {
+            // Restart: the txn is queued again and gets a new timestamp
+            // when the scheduler takes it.
+            watermark_->Finish(txn->unique_id_);
+            txn->reads_.clear();
+            txn->writes_.clear();
+            txn->status_ = INCOMPLETE;
+
+            txn_requests_.PushShared(txn);
+            return;
+        }
+        txn->status_ = COMMITTED;
+    }
+    else
+    {
+        DIE("Completed Txn has invalid TxnStatus: " << txn->Status());
+    }
+
+    watermark_->Finish(txn->unique_id_);
+    DeliverResult(txn);
 }
 
 
@@ -303,7 +643,10 @@ void TxnProcessor::RunSTRIFEScheduler() {
         {
             // assert(*counter_ == 0); sometimes the first batch does not finish which makes the assertion to fail (Haoran Zhou)
             while(*counter_ != 0) {} // rayguan_TODO: could add more concurrency here by using new worklist and residuals -- processing residual while batching
+            STRIFEBatchBoundary(batch_id_++);
+            if (command_log_ != nullptr && !log_schedules_) command_log_->LogBatch(batch, 0);
             cluster_->PartitionBatch(batch, worklist, residuals);
+            if (command_log_ != nullptr && log_schedules_) command_log_->LogSchedule(worklist, residuals, 0);
             // std::cout << "worklist len " << worklist.Size() << std::endl;
             // std::cout << "resiudal len " << residuals.Size() << std::endl;
 #if (DEBUG)
@@ -363,13 +706,18 @@ void TxnProcessor::RunSTRIFESchedulerMod() {
             }
 
             // assert(*counter_ == 0); sometimes the first batch does not finish which makes the assertion to fail (Haoran Zhou)
+            if (command_log_ != nullptr && !log_schedules_)
+                command_log_->LogBatch(batch, CommandLog::kDeferResiduals);
             cluster_->PartitionBatch(batch, worklist, residuals);
+            if (command_log_ != nullptr && log_schedules_)
+                command_log_->LogSchedule(worklist, residuals, CommandLog::kDeferResiduals);
             // std::cout << "Size of list " << worklist.Size() << std::endl;
             // std::cout << "Size of res " << residuals.Size() << std::endl;
 #if (DEBUG)
             PrintResult(worklist, residuals);
 #endif
             while(*counter_ != 0) {} // rayguan_TODO: could add more concurrency here by using new worklist and residuals -- processing residual while batching
+            STRIFEBatchBoundary(batch_id_++);
             while (worklist.Size() != 0) 
             {
                 worklist.Pop(&current);
@@ -404,10 +752,14 @@ void TxnProcessor::RunSTRIFESchedulerLockMod() {
     while (!stopped_)
     {
         // rayguan_TODO: need to clear the queue, need to make sure cluster code clear the batch
-        if (txn_requests_.Pop_n(batch, BATCH_SIZE) != 0)
+        // Retried txns go first.
+        retry_txns_.Pop_n(batch, BATCH_SIZE);
+        txn_requests_.Pop_n(batch, BATCH_SIZE - batch.Size());
+        if (batch.Size() != 0)
         {
             // assert(*counter_ == 0); sometimes the first batch does not finish which makes the assertion to fail (Haoran Zhou)
             while(*counter_ != 0) {} // rayguan_TODO: could add more concurrency here by using new worklist and residuals -- processing residual while batching
+            STRIFEBatchBoundary(batch_id_++);
             cluster_->PartitionBatch(batch, worklist, residuals);
 #if (DEBUG)
             PrintResult(worklist, residuals);
@@ -452,9 +804,11 @@ void TxnProcessor::RunSTRIFESchedulerAllMod() {
     while (!stopped_)
     {
         // rayguan_TODO: need to clear the queue, need to make sure cluster code clear the batch
-        if ( residuals.Size() != 0 || txn_requests_.Size() != 0)
+        if ( residuals.Size() != 0 || retry_txns_.Size() != 0 || txn_requests_.Size() != 0)
         {
-            txn_requests_.Pop_n(batch, BATCH_SIZE - residuals.Size());
+            // Retried txns go first.
+            retry_txns_.Pop_n(batch, BATCH_SIZE - residuals.Size());
+            txn_requests_.Pop_n(batch, BATCH_SIZE - residuals.Size() - batch.Size());
             while (residuals.Size() != 0) {
                 residuals.Pop(&txn);
                 batch.Push(txn);
@@ -466,6 +820,7 @@ void TxnProcessor::RunSTRIFESchedulerAllMod() {
             PrintResult(worklist, residuals);
 #endif
             while(*counter_ != 0) {} // rayguan_TODO: could add more concurrency here by using new worklist and residuals -- processing residual while batching
+            STRIFEBatchBoundary(batch_id_++);
             while (worklist.Size() != 0) 
             {
                 worklist.Pop(&current);
@@ -485,14 +840,26 @@ void TxnProcessor::RunSTRIFESchedulerAllMod() {
 }
 
 
+// Called between two STRIFE batches, while no txn is executing.
+void TxnProcessor::STRIFEBatchBoundary(uint64 completed_batch_id)
+{
+    if (checkpointer_ != nullptr) checkpointer_->MaybeStart(completed_batch_id);
+}
+
 void TxnProcessor::STRIFEExecuteSerial(AtomicQueue<Txn*> *queue, bool reap)
 {
+    PerfSample begin;
+    if (options_.perf_counters_) begin = PerfCounters::ThreadLocal().Read();
+    uint64 txns  = 0;
+    bool counted = false;  // the queue was added to executor_perf_
     Txn* txn;
     while (!stopped_ && queue->Size() != 0)
     {
         // Get next txn request.
         if (queue->Pop(&txn))
         {
+            txn->residual_ = !reap;  // only the residual queue outlives the call
+
             // Execute txn.
             ExecuteTxn(txn);
 
@@ -511,10 +878,20 @@ void TxnProcessor::STRIFEExecuteSerial(AtomicQueue<Txn*> *queue, bool reap)
                 // Invalid TxnStatus!
                 DIE("Completed Txn has invalid TxnStatus: " << txn->Status());
             }
+            // Count the queue before its last result lets the client read
+            // ExecutorPerf().
+            txns++;
+            if (options_.perf_counters_ && queue->Size() == 0)
+            {
+                RecordExecutorPerf(reap, !counted, &txns, &begin);
+                counted = true;
+            }
+
             // Return result to client.
-            txn_results_.Push(txn);
+            DeliverResult(txn);
         }
     }
+    if (options_.perf_counters_ && (txns > 0 || !counted)) RecordExecutorPerf(reap, !counted, &txns, &begin);
     counter_ -= 1;
     if (reap) {
         delete queue;
@@ -524,28 +901,30 @@ void TxnProcessor::STRIFEExecuteSerial(AtomicQueue<Txn*> *queue, bool reap)
 
 void TxnProcessor::STRIFEExecuteLocking(AtomicQueue<Txn*> *queue, bool reap)
 {
+    PerfSample begin;
+    if (options_.perf_counters_) begin = PerfCounters::ThreadLocal().Read();
+    uint64 txns  = 0;
+    bool counted = false;  // the queue was added to executor_perf_
     Txn* txn;
-    AtomicQueue<Txn*> completed;
+    LockManagerC* lm = static_cast<LockManagerC*>(lm_);
+    LockPlan plan;
 
     while (!stopped_ && queue->Size() != 0)
     {
         // Start processing the next incoming transaction request.
         if (queue->Pop(&txn))
         {
-            // Request read locks.
-            for (set<Key>::iterator it = txn->readset_.begin(); it != txn->readset_.end(); ++it)
-            {
-                while (!lm_->ReadLock(txn, *it))
-                {
-                }
-            }
+            txn->residual_ = !reap;  // only the residual queue outlives the call
 
-            // Request write locks.
-            for (set<Key>::iterator it = txn->writeset_.begin(); it != txn->writeset_.end(); ++it)
+            // Take all locks in increasing lock word order, so txns can't
+            // wait on each other in a cycle.
+            LockManagerC::Plan(txn->readset_, txn->writeset_, &plan);
+            if (!lm->Acquire(plan, txn->unique_id_))
             {
-                while (!lm_->WriteLock(txn, *it))
-                {
-                }
+                // Nothing ran yet, the txn keeps its id (and so its age).
+                lock_retries_++;
+                retry_txns_.Push(txn);
+                continue;
             }
 
             // Execute txn.
@@ -567,21 +946,22 @@ void TxnProcessor::STRIFEExecuteLocking(AtomicQueue<Txn*> *queue, bool reap)
                 DIE("Completed Txn has invalid TxnStatus: " << txn->Status());
             }
 
-            // Return result to client.
-            txn_results_.Push(txn);
+            lm->ReleaseAll(plan);
 
-            // Release read locks.
-            for (set<Key>::iterator it = txn->readset_.begin(); it != txn->readset_.end(); ++it)
+            // Count the queue before its last result lets the client read
+            // ExecutorPerf().
+            txns++;
+            if (options_.perf_counters_ && queue->Size() == 0)
             {
-                lm_->Release(txn, *it);
-            }
-            // Release write locks.
-            for (set<Key>::iterator it = txn->writeset_.begin(); it != txn->writeset_.end(); ++it)
-            {
-                lm_->Release(txn, *it);
+                RecordExecutorPerf(reap, !counted, &txns, &begin);
+                counted = true;
             }
+
+            // Return result to client, who may delete it right away.
+            DeliverResult(txn);
         }
     }
+    if (options_.perf_counters_ && (txns > 0 || !counted)) RecordExecutorPerf(reap, !counted, &txns, &begin);
     counter_ -= 1;
     if (reap) {
         delete queue;
@@ -2,18 +2,30 @@
 #ifndef _TXN_PROCESSOR_H_
 #define _TXN_PROCESSOR_H_
 
+#include <atomic>
 #include <deque>
+#include <functional>
 #include <map>
 #include <string>
 
+#include "txn/active_set.h"
+#include "txn/batch_graph.h"
+#include "txn/checkpointer.h"
+#include "txn/command_log.h"
 #include "txn/common.h"
 #include "txn/lock_manager.h"
 #include "txn/mvcc_storage.h"
+#include "txn/partition_stats.h"
+#include "txn/request_queue.h"
 #include "txn/storage.h"
+#include "txn/trace.h"
 #include "txn/txn.h"
+#include "txn/txn_latency.h"
+#include "txn/txn_pool.h"
 #include "txn/txn_processor.h"
 #include "txn/strife_itf.h"
 #include "utils/atomic.h"
+#include "utils/event_count.h"
 #include "utils/mutex.h"
 #include "utils/static_thread_pool.h"
 
@@ -51,32 +63,135 @@ enum CCMode
 // Returns a human-readable string naming of the providing mode.
 string ModeToString(CCMode mode);
 
+// Optional features of the TxnProcessor, fixed once the processor is created.
+struct TxnProcessorOptions
+{
+    TxnProcessorOptions()
+        : command_log_path_(""),
+          command_log_sync_(false),
+          trace_path_(""),
+          graph_path_(""),
+          checkpoint_path_(""),
+          checkpoint_interval_(10),
+          checkpoint_rate_(1000),
+          gc_interval_(0.01),
+          lock_policy_(LOCK_SPIN),
+          worker_threads_(THREAD_COUNT),
+          perf_counters_(false),
+          result_callback_(nullptr)
+    {
+    }
+
+    string command_log_path_;  // command log for the STRIFE_S/PM/P/PM_P schedulers ("" disables it)
+    bool command_log_sync_;    // fdatasync the command log after every batch
+
+    string trace_path_;  // trace of the submitted txns, in any mode ("" disables it, see txn/trace.h)
+
+    // conflict graphs of the STRIFE batches ("" disables it, ignored in the
+    // other modes, see txn/batch_graph.h)
+    string graph_path_;
+
+    string checkpoint_path_;      // checkpoint image taken at batch boundaries, STRIFE modes only ("" disables it)
+    double checkpoint_interval_;  // min seconds between two checkpoints
+    uint64 checkpoint_rate_;      // max records copied per ms by the checkpointer (0 = unlimited)
+
+    double gc_interval_;  // seconds between two collections of MVCC versions (0 disables the collector)
+
+    LockPolicy lock_policy_;  // contention policy of the STRIFE_LM/PLM executors
+
+    int worker_threads_;  // threads of the pool running the txns
+
+    bool perf_counters_;  // sample hardware counters around the STRIFE phases and executor queues
+
+    // If set, called by the worker that finished a txn (COMMITTED or ABORTED),
+    // concurrently from several threads, instead of queueing the txn for
+    // GetTxnResult(s). The callback takes ownership of the txn.
+    std::function<void(Txn*)> result_callback_;
+};
+
+// Hardware counters of the STRIFE executors (TxnProcessorOptions::
+// perf_counters_), summed over the queues they ran: conflict free clusters
+// and residual queues.
+struct ExecutorPerfStats
+{
+    ExecutorPerfStats()
+    {
+        memset(queues_, 0, sizeof(queues_));
+        memset(txns_, 0, sizeof(txns_));
+    }
+
+    uint64 queues_[NUM_LATENCY_PATHS];
+    uint64 txns_[NUM_LATENCY_PATHS];
+    PerfSample events_[NUM_LATENCY_PATHS];
+};
+
 class TxnProcessor
 {
    public:
     // The TxnProcessor's constructor starts the TxnProcessor running in the
     // background.
     explicit TxnProcessor(CCMode mode);
+    TxnProcessor(CCMode mode, const TxnProcessorOptions& options);
 
     // The TxnProcessor's destructor stops all background threads and deallocates
     // all objects currently owned by the TxnProcessor, except for Txn objects.
     ~TxnProcessor();
 
     // Registers a new txn request to be executed by the TxnProcessor.
-    // Ownership of '*txn' is transfered to the TxnProcessor.
+    // Ownership of '*txn' is transfered to the TxnProcessor. The txn is
+    // stamped TXN_SUBMITTED unless the client already did (an open loop
+    // client sets the time the txn was due, so falling behind shows up as
+    // latency).
     void NewTxnRequest(Txn* txn);
-    void NewTxnRequests(queue<Txn*> txn_queue);  // probably new requests should be copied
+    // Registers all the txns of 'txn_queue', which is left empty.
+    void NewTxnRequests(queue<Txn*>& txn_queue);
 
     // Returns a pointer to the next COMMITTED or ABORTED Txn. The caller takes
     // ownership of the returned Txn.
     Txn* GetTxnResult();
 
+    // Moves up to 'max' results into 'results' and returns how many. If 'block'
+    // is set and there is no result yet, sleeps until there is one.
+    int GetTxnResults(Txn** results, int max, bool block = true);
+
     // Main loop implementing all concurrency control/thread scheduling.
     void RunScheduler();
 
     static void* StartScheduler(void* arg);
 
+    // Garbage collection counters of the MVCC storage (all zero in other modes).
+    MVCCGCStats GCStats();
+
+    // Number of times a STRIFE_LM/PLM txn gave up on a lock and was retried.
+    uint64 LockRetries();
+
+    // Per phase cycles and per batch counts of the STRIFE partitioner, over
+    // all batches so far (empty in non-STRIFE modes).
+    PartitionStats STRIFEStats();
+
+    // Hardware counters of the STRIFE executors so far (empty unless
+    // options.perf_counters_ is set; the partitioner's are in STRIFEStats()).
+    ExecutorPerfStats ExecutorPerf();
+
+    // Stage latencies of all the txns returned so far (see TxnStage), by
+    // GetTxnResult(s) or to the result callback.
+    TxnLatencyStats LatencyStats();
+
+    // Txn objects recycled across requests: clients may take new txns from
+    // the pool and give results back instead of deleting them. Txns must be
+    // released before the TxnProcessor is destroyed, or deleted.
+    template <class T>
+    T* AcquireTxn()
+    {
+        return txn_pool_.Acquire<T>();
+    }
+    void ReleaseTxn(Txn* txn) { txn_pool_.Release(txn); }
+    TxnPool* Pool() { return &txn_pool_; }
+
    private:
+    // Hands a COMMITTED or ABORTED txn to the client.
+    void DeliverResult(Txn* txn);
+
     // Serial validation
     bool SerialValidate(Txn* txn);
 
@@ -89,6 +204,9 @@ class TxnProcessor
     // Locking version of scheduler.
     void RunLockingScheduler();
 
+    // Executes and commits a txn holding all its locks, then releases them.
+    void LockingExecuteTxn(Txn* txn);
+
     // OCC version of scheduler.
     void RunOCCScheduler();
 
@@ -103,7 +221,12 @@ class TxnProcessor
     void RunSTRIFESchedulerLockMod();
     void RunSTRIFESchedulerAllMod();
     void STRIFEExecuteSerial(AtomicQueue<Txn*> *queue, bool reap);
+    void STRIFEBatchBoundary(uint64 completed_batch_id);
     void STRIFEExecuteLocking(AtomicQueue<Txn*> *queue, bool reap);
+    // Adds the counters since '*begin' of an executor that ran '*txns' txns
+    // of a cluster ('reap') or the residual queue, counting the queue itself
+    // if 'new_queue', then restarts both from now.
+    void RecordExecutorPerf(bool reap, bool new_queue, uint64* txns, PerfSample* begin);
 
     // Performs all reads required to execute the transaction, then executes the
     // transaction logic.
@@ -123,10 +246,15 @@ class TxnProcessor
 
     void MVCCUnlockWriteKeys(Txn* txn);
 
+    // Reclaims the MVCC versions older than the low watermark of the running
+    // txns.
     void GarbageCollection();
 
+    static void* StartGarbageCollector(void* arg);
+
     // Concurrency control mechanism the TxnProcessor is currently using.
     CCMode mode_;
+    TxnProcessorOptions options_;
 
     // Thread pool managing all threads used by TxnProcessor.
     StaticThreadPool tp_;
@@ -135,38 +263,67 @@ class TxnProcessor
     // Data storage used for all modes.
     Storage* storage_;
 
-    // Next valid unique_id, and a mutex to guard incoming txn requests.
-    int next_unique_id_;
-    Mutex mutex_;
+    TxnPool txn_pool_;
+
     ClustererItf *cluster_;
 
-    // Queue of incoming transaction requests.
-    AtomicQueue<Txn*> txn_requests_;
+    // Command log of the STRIFE batches (nullptr if disabled).
+    CommandLog* command_log_;
+    // Log the schedules rather than the batches: replay can't reproduce
+    // those of ClustererParallel.
+    bool log_schedules_;
+
+    // Recorder of the submitted txns (nullptr if disabled).
+    TraceWriter* trace_;
+
+    // Conflict graphs of the STRIFE batches (nullptr if disabled).
+    BatchGraphWriter* graphs_;
+
+    // Checkpointer of storage_ (nullptr if disabled).
+    Checkpointer* checkpointer_;
+
+    // Id of the last STRIFE batch handed to the clusterer.
+    uint64 batch_id_;
+
+    // Queue of incoming transaction requests. Assigns the unique ids as the
+    // scheduler takes them.
+    RequestQueue txn_requests_;
+
+    // Txns whose locks couldn't be taken under options_.lock_policy_. The
+    // STRIFE_LM/PLM schedulers put them in front of the next batch.
+    AtomicQueue<Txn*> retry_txns_;
+    std::atomic<uint64> lock_retries_;
 
     // Queue of txns that have acquired all locks and are ready to be executed.
     //
-    // Does not need to be atomic because RunScheduler is the only thread that
-    // will ever access this queue.
+    // Workers releasing locks append to it, so it is only accessed through
+    // the lock manager (see LockManager::NextReady).
     deque<Txn*> ready_txns_;
 
     // Queue of completed (but not yet committed/aborted) transactions.
     AtomicQueue<Txn*> completed_txns_;
 
     // Queue of transaction results (already committed or aborted) to be returned
-    // to client.
+    // to client, and the clients waiting for one.
     AtomicQueue<Txn*> txn_results_;
+    EventCount results_ready_;
+    TxnLatencyRecorder latency_;
+    Mutex executor_perf_mutex_;
+    ExecutorPerfStats executor_perf_;
     Atomic<int> counter_;
 
     // Set of transactions that are currently in the process of parallel
     // validation.
-    AtomicSet<Txn*> active_set_;
-
-    // Used it for critical section in parallel occ.
-    Mutex active_set_mutex_;
+    ActiveTxnSet active_set_;
 
     // Lock Manager used for LOCKING concurrency implementations.
     LockManager* lm_;
 
+    // Low watermark of the MVCC txns, and the thread collecting the versions
+    // below it (MVCC mode only).
+    TxnWatermark* watermark_;
+    pthread_t gc_thread_;
+
     // Used for stopping the continuous loop that runs in the scheduler thread
     bool stopped_;
 
@@ -7,6 +7,7 @@
 #include "utils/testing.h"
 #include "txn/load_generator.h"
 #include "txn/printer.h"
+#include "utils/cycle_clock.h"
 
 
 // Returns a human-readable string naming of the providing mode.
@@ -50,7 +51,6 @@ void Benchmark(const vector<LoadGen*>& lg)
 {
     // Number of transaction requests that can be active at any given time.
     int active_txns = 100;
-    deque<Txn*> doneTxns;
 
     // For each MODE...
     for (CCMode mode = STRIFE_S; mode <= STRIFE_PLM; mode = static_cast<CCMode>(mode + 1))
@@ -62,6 +62,7 @@ void Benchmark(const vector<LoadGen*>& lg)
         for (uint32 exp = 0; exp < lg.size(); exp++)
         {
             double throughput[2];
+            Histogram latency;
             for (uint32 round = 0; round < 2; round++)
             {
                 int txn_count = 0;
@@ -73,22 +74,22 @@ void Benchmark(const vector<LoadGen*>& lg)
                 double start = GetTime();
 
                 // Start specified number of txns running.
-                for (int i = 0; i < active_txns; i++) p->NewTxnRequest(lg[exp]->NewTxn());
+                for (int i = 0; i < active_txns; i++) p->NewTxnRequest(lg[exp]->NewPooledTxn(p->Pool()));
 
                 // Keep 100 active txns at all times for the first full second.
                 while (GetTime() < start + 0.5)
                 {
                     Txn* txn = p->GetTxnResult();
-                    doneTxns.push_back(txn);
+                    p->ReleaseTxn(txn);
                     txn_count++;
-                    p->NewTxnRequest(lg[exp]->NewTxn());
+                    p->NewTxnRequest(lg[exp]->NewPooledTxn(p->Pool()));
                 }
 
                 // Wait for all of them to finish.
                 for (int i = 0; i < active_txns; i++)
                 {
                     Txn* txn = p->GetTxnResult();
-                    doneTxns.push_back(txn);
+                    p->ReleaseTxn(txn);
                     txn_count++;
                 }
 
@@ -97,17 +98,15 @@ void Benchmark(const vector<LoadGen*>& lg)
 
                 throughput[round] = txn_count / (end - start);
 
-                for (auto it = doneTxns.begin(); it != doneTxns.end(); ++it)
-                {
-                    delete *it;
-                }
+                TxnLatencyStats stats = p->LatencyStats();
+                for (int path = 0; path < NUM_LATENCY_PATHS; path++) latency.Merge(stats.total_[path]);
 
-                doneTxns.clear();
                 delete p;
             }
 
-            // Print throughput
-            cout << "\t" << (throughput[0] + throughput[1]) / 2 << "\t" << flush;
+            // Print throughput, and the tail latency as our SLOs are on it
+            cout << "\t" << (throughput[0] + throughput[1]) / 2 << " (p99 "
+                 << CycleClock::ToSeconds(latency.Percentile(99)) * 1e6 << "us)\t" << flush;
         }
 
         cout << endl;
@@ -246,10 +245,193 @@ TEST(TestStrifeProcessor)
     END;
 }
 
+// Concurrent increments of a few hot keys, mixed with long read-mostly txns:
+// every committed increment must be visible at the end. The STRIFE clusterer
+// needs a write set in every txn, so the check also names an unused key.
+void CheckConcurrentIncrements(CCMode mode, const TxnProcessorOptions& options = TxnProcessorOptions())
+{
+    TxnProcessor p(mode, options);
+    RMWLoadGen writers(20, 0, 3, 0);
+    RMWLoadGen readers(20, 10, 1, 0.0001);
+
+    map<Key, Value> expected;
+    int num_txns = 4000;
+    for (int i = 0; i < num_txns; i++) p.NewTxnRequest(i % 4 == 0 ? readers.NewTxn() : writers.NewTxn());
+    for (int i = 0; i < num_txns; i++)
+    {
+        Txn* txn = p.GetTxnResult();
+        EXPECT_EQ(COMMITTED, txn->Status());
+        for (KeySet::const_iterator it = txn->writeset_.begin(); it != txn->writeset_.end(); ++it) expected[*it]++;
+        delete txn;
+    }
+
+    Txn* check = new Expect(expected);
+    check->writeset_.insert(100);
+    p.NewTxnRequest(check);
+    Txn* txn = p.GetTxnResult();
+    EXPECT_EQ(COMMITTED, txn->Status());
+    delete txn;
+}
+
+TEST(TestLockingProcessor)
+{
+    CheckConcurrentIncrements(LOCKING_EXCLUSIVE_ONLY);
+    CheckConcurrentIncrements(LOCKING);
+    END;
+}
+
+TEST(TestSTRIFELockingProcessor)
+{
+    CheckConcurrentIncrements(STRIFE_LM);
+    CheckConcurrentIncrements(STRIFE_PLM);
+    END;
+}
+
+// Txns giving up on a lock are retried until they commit.
+TEST(TestSTRIFELockPolicies)
+{
+    LockPolicy policies[] = {LOCK_NO_WAIT, LOCK_WAIT_DIE, LOCK_SPIN_PARK};
+    for (int i = 0; i < 3; i++)
+    {
+        TxnProcessorOptions options;
+        options.lock_policy_ = policies[i];
+        CheckConcurrentIncrements(STRIFE_PLM, options);
+    }
+    END;
+}
+
+TEST(TestBatchedResults)
+{
+    TxnProcessor p(LOCKING);
+    RMWLoadGen lg(1000, 2, 2, 0);
+    int num_txns = 2000;
+    for (int i = 0; i < num_txns; i++) p.NewTxnRequest(lg.NewTxn());
+
+    Txn* results[64];
+    int received = 0;
+    while (received < num_txns)
+    {
+        int n = p.GetTxnResults(results, 64);
+        EXPECT_TRUE(n > 0 && n <= 64);
+        for (int i = 0; i < n; i++)
+        {
+            EXPECT_EQ(COMMITTED, results[i]->Status());
+            delete results[i];
+        }
+        received += n;
+    }
+    EXPECT_EQ(num_txns, received);
+    EXPECT_EQ(0, p.GetTxnResults(results, 64, false));
+    END;
+}
+
+TEST(TestResultCallback)
+{
+    std::atomic<int> committed(0);
+    TxnProcessorOptions options;
+    options.result_callback_ = [&committed](Txn* txn) {
+        if (txn->Status() == COMMITTED) committed++;
+        delete txn;
+    };
+
+    int num_txns = 2000;
+    {
+        TxnProcessor p(LOCKING, options);
+        RMWLoadGen lg(1000, 2, 2, 0);
+        for (int i = 0; i < num_txns; i++) p.NewTxnRequest(lg.NewTxn());
+        double start = GetTime();
+        while (committed.load() < num_txns && GetTime() < start + 10) Sleep(0.001);
+        Txn* txn;
+        EXPECT_EQ(0, p.GetTxnResults(&txn, 1, false));
+    }
+    EXPECT_EQ(num_txns, committed.load());
+    END;
+}
+
+TEST(TestSTRIFEStats)
+{
+    EXPECT_EQ(0, (int)TxnProcessor(SERIAL).STRIFEStats().batches_);
+
+    TxnProcessor p(STRIFE_LM);
+    RMWLoadGen lg(1000, 2, 2, 0);
+    int num_txns = 2000;
+    for (int i = 0; i < num_txns; i++) p.NewTxnRequest(lg.NewTxn());
+    for (int i = 0; i < num_txns; i++) delete p.GetTxnResult();
+
+    // Every txn went through exactly one batch, either in a cluster or as a
+    // residual.
+    PartitionStats stats = p.STRIFEStats();
+    EXPECT_TRUE(stats.batches_ > 0);
+    EXPECT_EQ(num_txns, (int)stats.txns_.Sum());
+    EXPECT_EQ(stats.batches_, stats.clusters_.Count());
+    EXPECT_TRUE(stats.data_nodes_.Max() <= 1000);
+    EXPECT_TRUE(stats.special_clusters_.Max() <= STRIFE_K_DEFAULT);
+    EXPECT_TRUE(stats.residuals_.Sum() <= (uint64)num_txns);
+    for (int i = 0; i < NUM_PARTITION_PHASES; i++) EXPECT_EQ(stats.batches_, stats.phase_cycles_[i].Count());
+    END;
+}
+
+// Every executed txn is counted by the executors; the counters themselves
+// only move where the machine provides them.
+TEST(TestPerfCounters)
+{
+    TxnProcessorOptions options;
+    options.perf_counters_ = true;
+    TxnProcessor p(STRIFE_LM, options);
+    RMWLoadGen lg(1000, 2, 2, 0);
+    int num_txns = 2000;
+    for (int i = 0; i < num_txns; i++) p.NewTxnRequest(lg.NewTxn());
+    for (int i = 0; i < num_txns; i++) delete p.GetTxnResult();
+
+    ExecutorPerfStats executor = p.ExecutorPerf();
+    EXPECT_EQ(num_txns, (int)(executor.txns_[PATH_CLUSTER] + executor.txns_[PATH_RESIDUAL]));
+    EXPECT_TRUE(executor.queues_[PATH_CLUSTER] > 0);
+    if (PerfCounters::ThreadLocal().Available(PERF_CYCLES))
+    {
+        PartitionStats stats = p.STRIFEStats();
+        EXPECT_TRUE(stats.phase_events_[PHASE_FUSE].value_[PERF_CYCLES] > 0);
+        EXPECT_TRUE(executor.events_[PATH_CLUSTER].value_[PERF_CYCLES] > 0);
+    }
+
+    // Off by default.
+    TxnProcessor q(STRIFE_LM);
+    for (int i = 0; i < 100; i++) q.NewTxnRequest(lg.NewTxn());
+    for (int i = 0; i < 100; i++) delete q.GetTxnResult();
+    EXPECT_EQ(0, (int)q.ExecutorPerf().txns_[PATH_CLUSTER]);
+    END;
+}
+
+TEST(TestOCCProcessor)
+{
+    CheckConcurrentIncrements(OCC);
+    END;
+}
+
+TEST(TestOCCParallelProcessor)
+{
+    CheckConcurrentIncrements(P_OCC);
+    END;
+}
+
+TEST(TestMVCCProcessor)
+{
+    CheckConcurrentIncrements(MVCC);
+    END;
+}
 
 int main(int argc, char** argv)
 {
     // TestStrifeProcessor();
+    TestLockingProcessor();
+    TestSTRIFELockingProcessor();
+    TestSTRIFELockPolicies();
+    TestBatchedResults();
+    TestResultCallback();
+    TestSTRIFEStats();
+    TestPerfCounters();
+    TestOCCProcessor();
+    TestOCCParallelProcessor();
+    TestMVCCProcessor();
 
 
     // // comment out temporary for unit test speed
@@ -12,8 +12,11 @@
 class Noop : public Txn
 {
    public:
+    static const TxnType kType = TXN_NOOP;
+
     Noop() {}
     virtual void Run() { COMMIT; }
+    virtual TxnType Type() const { return kType; }
     Noop* clone() const
     {  // Virtual constructor (copying)
         Noop* clone = new Noop();
@@ -52,6 +55,16 @@ class Expect : public Txn
         COMMIT;
     }
 
+    virtual TxnType Type() const { return TXN_EXPECT; }
+    virtual void EncodeArgs(vector<uint64>* args) const
+    {
+        for (map<Key, Value>::const_iterator it = m_.begin(); it != m_.end(); ++it)
+        {
+            args->push_back(it->first);
+            args->push_back(it->second);
+        }
+    }
+
    private:
     map<Key, Value> m_;
 };
@@ -78,6 +91,16 @@ class Put : public Txn
         COMMIT;
     }
 
+    virtual TxnType Type() const { return TXN_PUT; }
+    virtual void EncodeArgs(vector<uint64>* args) const
+    {
+        for (map<Key, Value>::const_iterator it = m_.begin(); it != m_.end(); ++it)
+        {
+            args->push_back(it->first);
+            args->push_back(it->second);
+        }
+    }
+
    private:
     map<Key, Value> m_;
 };
@@ -86,19 +109,33 @@ class Put : public Txn
 class RMW : public Txn
 {
    public:
+    static const TxnType kType = TXN_RMW;
+
     explicit RMW(double time = 0) : time_(time) {}
-    RMW(const set<Key>& writeset, double time = 0) : time_(time) { writeset_ = writeset; }
-    RMW(const set<Key>& readset, const set<Key>& writeset, double time = 0) : time_(time)
+    RMW(const KeySet& writeset, double time = 0) : time_(time) { writeset_ = writeset; }
+    RMW(const KeySet& readset, const KeySet& writeset, double time = 0) : time_(time)
     {
         readset_  = readset;
         writeset_ = writeset;
     }
 
     // Constructor with randomized read/write sets
-    RMW(int dbsize, int readsetsize, int writesetsize, double time = 0) : time_(time)
+    RMW(int dbsize, int readsetsize, int writesetsize, double time = 0) { Init(dbsize, readsetsize, writesetsize, time); }
+
+    // Fills the empty sets of a new or reset txn with random keys.
+    void Init(int dbsize, int readsetsize, int writesetsize, double time = 0)
     {
         // Make sure we can find enough unique keys.
         DCHECK(dbsize >= readsetsize + writesetsize);
+        InitKeys(readsetsize, writesetsize, time, [dbsize]() { return static_cast<Key>(rand() % dbsize); });
+    }
+
+    // Same, drawing the keys from 'next_key()' (a callable returning a Key),
+    // which must be able to produce enough distinct keys.
+    template <class NextKey>
+    void InitKeys(int readsetsize, int writesetsize, double time, NextKey next_key)
+    {
+        time_ = time;
 
         // Find readsetsize unique read keys.
         for (int i = 0; i < readsetsize; i++)
@@ -106,7 +143,7 @@ class RMW : public Txn
             Key key;
             do
             {
-                key = rand() % dbsize;
+                key = next_key();
             } while (readset_.count(key));
             readset_.insert(key);
         }
@@ -117,7 +154,7 @@ class RMW : public Txn
             Key key;
             do
             {
-                key = rand() % dbsize;
+                key = next_key();
             } while (readset_.count(key) || writeset_.count(key));
             writeset_.insert(key);
         }
@@ -134,10 +171,10 @@ class RMW : public Txn
     {
         Value result;
         // Read everything in readset.
-        for (set<Key>::iterator it = readset_.begin(); it != readset_.end(); ++it) Read(*it, &result);
+        for (KeySet::const_iterator it = readset_.begin(); it != readset_.end(); ++it) Read(*it, &result);
 
         // Increment length of everything in writeset.
-        for (set<Key>::iterator it = writeset_.begin(); it != writeset_.end(); ++it)
+        for (KeySet::const_iterator it = writeset_.begin(); it != writeset_.end(); ++it)
         {
             result = 0;
             Read(*it, &result);
@@ -159,6 +196,9 @@ class RMW : public Txn
         COMMIT;
     }
 
+    virtual TxnType Type() const { return kType; }
+    virtual void EncodeArgs(vector<uint64>* args) const { args->push_back(DoubleToBits(time_)); }
+
    private:
     double time_;
 };
@@ -166,9 +206,11 @@ class RMW : public Txn
 class RMWHot : public Txn
 {
    public:
+    static const TxnType kType = TXN_RMW_HOT;
+
     explicit RMWHot(double time = 0) : time_(time) {}
-    RMWHot(const set<Key>& writeset, double time = 0) : time_(time) { writeset_ = writeset; }
-    RMWHot(const set<Key>& readset, const set<Key>& writeset, double time = 0) : time_(time)
+    RMWHot(const KeySet& writeset, double time = 0) : time_(time) { writeset_ = writeset; }
+    RMWHot(const KeySet& readset, const KeySet& writeset, double time = 0) : time_(time)
     {
         readset_  = readset;
         writeset_ = writeset;
@@ -246,10 +288,10 @@ class RMWHot : public Txn
     {
         Value result;
         // Read everything in readset.
-        for (set<Key>::iterator it = readset_.begin(); it != readset_.end(); ++it) Read(*it, &result);
+        for (KeySet::const_iterator it = readset_.begin(); it != readset_.end(); ++it) Read(*it, &result);
 
         // Increment length of everything in writeset.
-        for (set<Key>::iterator it = writeset_.begin(); it != writeset_.end(); ++it)
+        for (KeySet::const_iterator it = writeset_.begin(); it != writeset_.end(); ++it)
         {
             result = 0;
             Read(*it, &result);
@@ -271,6 +313,9 @@ class RMWHot : public Txn
         COMMIT;
     }
 
+    virtual TxnType Type() const { return kType; }
+    virtual void EncodeArgs(vector<uint64>* args) const { args->push_back(DoubleToBits(time_)); }
+
    private:
     double time_;
 };
@@ -278,9 +323,11 @@ class RMWHot : public Txn
 class RMWPar : public Txn
 {
    public:
+    static const TxnType kType = TXN_RMW_PAR;
+
     explicit RMWPar(double time = 0) : time_(time) {}
-    RMWPar(const set<Key>& writeset, double time = 0) : time_(time) { writeset_ = writeset; }
-    RMWPar(const set<Key>& readset, const set<Key>& writeset, double time = 0) : time_(time)
+    RMWPar(const KeySet& writeset, double time = 0) : time_(time) { writeset_ = writeset; }
+    RMWPar(const KeySet& readset, const KeySet& writeset, double time = 0) : time_(time)
     {
         readset_  = readset;
         writeset_ = writeset;
@@ -334,10 +381,10 @@ class RMWPar : public Txn
     {
         Value result;
         // Read everything in readset.
-        for (set<Key>::iterator it = readset_.begin(); it != readset_.end(); ++it) Read(*it, &result);
+        for (KeySet::const_iterator it = readset_.begin(); it != readset_.end(); ++it) Read(*it, &result);
 
         // Increment length of everything in writeset.
-        for (set<Key>::iterator it = writeset_.begin(); it != writeset_.end(); ++it)
+        for (KeySet::const_iterator it = writeset_.begin(); it != writeset_.end(); ++it)
         {
             result = 0;
             Read(*it, &result);
@@ -359,6 +406,9 @@ class RMWPar : public Txn
         COMMIT;
     }
 
+    virtual TxnType Type() const { return kType; }
+    virtual void EncodeArgs(vector<uint64>* args) const { args->push_back(DoubleToBits(time_)); }
+
    private:
     double time_;
 };
@@ -3,7 +3,8 @@
 #include <atomic>
 
 
-bool UnionFind::Union(Record *r1, Record *r2, bool relax) {
+bool UnionFind::Union(Record *r1, Record *r2, bool relax, bool *linked) {
+    if (linked != nullptr) *linked = false;
     while(true) {
         Record* parent  = Find(r1);
         Record* child  = Find(r2);
@@ -23,6 +24,7 @@ bool UnionFind::Union(Record *r1, Record *r2, bool relax) {
         }
 
         if (__sync_bool_compare_and_swap(&child->parent_, child, parent)) {
+            if (linked != nullptr) *linked = true;
             return true;
         }
     }
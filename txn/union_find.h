@@ -6,7 +6,7 @@
 
 class UnionFind: public UnionFindItf {
    public:
-    virtual bool Union(Record *r1, Record *r2, bool relax);
+    virtual bool Union(Record *r1, Record *r2, bool relax, bool *linked = nullptr);
     virtual Record* Find(Record *r);
 
    private: 
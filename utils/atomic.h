@@ -2,6 +2,7 @@
 #ifndef _DB_UTILS_ATOMIC_H_
 #define _DB_UTILS_ATOMIC_H_
 
+#include <atomic>
 #include <queue>
 #include <set>
 #include <unordered_map>
@@ -219,6 +220,21 @@ class AtomicQueue
         }
     }
 
+    // Pops up to 'n' elements into 'result' under a single lock acquisition.
+    // Returns the number of elements popped.
+    int Pop_n(T* result, int n)
+    {
+        mutex_.Lock();
+        int popped = 0;
+        for (; popped < n && !queue_.empty(); popped++)
+        {
+            result[popped] = queue_.front();
+            queue_.pop();
+        }
+        mutex_.Unlock();
+        return popped;
+    }
+
     // If mutex is immediately acquired, pushes and returns true, else immediately
     // returns false.
     bool PushNonBlocking(const T& item)
@@ -366,4 +382,69 @@ class Atomic
     Mutex mutex_;
 };
 
+/// @class SpscRing<T>
+///
+/// Bounded lock-free queue for exactly one producer thread and one consumer
+/// thread. 'capacity' must be a power of two. The indices are kept on
+/// separate cache lines, and each side caches the other's index so it only reads the
+/// shared one when the ring looks full/empty.
+template <typename T>
+class SpscRing
+{
+   public:
+    explicit SpscRing(size_t capacity)
+        : items_(new T[capacity]), mask_(capacity - 1), head_(0), cached_tail_(0), tail_(0), cached_head_(0)
+    {
+        assert((capacity & mask_) == 0);
+    }
+    ~SpscRing() { delete[] items_; }
+
+    // Producer side. Returns false if the ring is full.
+    bool TryPush(const T& item)
+    {
+        size_t tail = tail_.load(std::memory_order_relaxed);
+        if (tail - cached_head_ > mask_)
+        {
+            cached_head_ = head_.load(std::memory_order_acquire);
+            if (tail - cached_head_ > mask_) return false;
+        }
+        items_[tail & mask_] = item;
+        tail_.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer side. Returns false if the ring is empty.
+    bool TryPop(T* result)
+    {
+        size_t head = head_.load(std::memory_order_relaxed);
+        if (head == cached_tail_)
+        {
+            cached_tail_ = tail_.load(std::memory_order_acquire);
+            if (head == cached_tail_) return false;
+        }
+        *result = items_[head & mask_];
+        head_.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Number of items, exact only when called by the consumer or producer
+    // while the other side is idle.
+    size_t Size() { return tail_.load(std::memory_order_acquire) - head_.load(std::memory_order_acquire); }
+
+   private:
+    T* items_;
+    size_t mask_;
+
+    // Consumer's line, padded away from the producer's.
+    std::atomic<size_t> head_;
+    size_t cached_tail_;
+    char pad_[64];
+
+    std::atomic<size_t> tail_;
+    size_t cached_head_;
+
+    SpscRing(const SpscRing&);
+    SpscRing& operator=(const SpscRing&);
+};
+
 #endif  // _DB_UTILS_ATOMIC_H_
@@ -0,0 +1,58 @@
+#ifndef _DB_UTILS_CYCLE_CLOCK_H_
+#define _DB_UTILS_CYCLE_CLOCK_H_
+
+#include <stdint.h>
+#include <time.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+/// @class CycleClock
+///
+/// Cheap timestamps for profiling hot paths: the time stamp counter on x86,
+/// a monotonic nanosecond clock elsewhere. Only differences of Now() taken on
+/// the same machine are meaningful; PerSecond() converts them to time.
+class CycleClock
+{
+   public:
+    static uint64_t Now()
+    {
+#if defined(__x86_64__) || defined(__i386__)
+        return __rdtsc();
+#else
+        return MonotonicNanos();
+#endif
+    }
+
+    // Ticks of Now() per second, measured once on first use (~10ms).
+    static double PerSecond()
+    {
+        static const double per_second = Calibrate();
+        return per_second;
+    }
+
+    static double ToSeconds(uint64_t cycles) { return cycles / PerSecond(); }
+
+   private:
+    static uint64_t MonotonicNanos()
+    {
+        struct timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return static_cast<uint64_t>(ts.tv_sec) * 1000000000ull + ts.tv_nsec;
+    }
+
+    static double Calibrate()
+    {
+        uint64_t start_ns     = MonotonicNanos();
+        uint64_t start_cycles = Now();
+        while (MonotonicNanos() - start_ns < 10000000ull)
+        {
+        }
+        uint64_t cycles = Now() - start_cycles;
+        uint64_t ns     = MonotonicNanos() - start_ns;
+        return cycles * 1e9 / ns;
+    }
+};
+
+#endif  // _DB_UTILS_CYCLE_CLOCK_H_
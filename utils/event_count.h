@@ -0,0 +1,72 @@
+#ifndef _DB_UTILS_EVENT_COUNT_H_
+#define _DB_UTILS_EVENT_COUNT_H_
+
+#if defined(__linux__)
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#else
+#include <condition_variable>
+#include <mutex>
+#endif
+
+#include <atomic>
+#include <climits>
+
+/// @class EventCount
+///
+/// Lets threads sleep until a condition (checked outside of it) may have
+/// become true, without a mutex. Waiters take a key with PrepareWait(),
+/// re-check the condition, and Wait(key) only if it's still false; notifiers
+/// make the condition true and then call NotifyAll(). A notification between
+/// PrepareWait() and Wait() makes Wait() return right away. Notifying costs
+/// no syscall while nobody waits. Waiters sleep on a futex on Linux, on a
+/// condition variable elsewhere.
+class EventCount
+{
+   public:
+    EventCount() : epoch_(0), waiters_(0) {}
+
+    int PrepareWait()
+    {
+        waiters_.fetch_add(1);
+        return epoch_.load();
+    }
+
+    void CancelWait() { waiters_.fetch_sub(1); }
+
+    void Wait(int key)
+    {
+#if defined(__linux__)
+        while (epoch_.load() == key)
+            syscall(SYS_futex, reinterpret_cast<int*>(&epoch_), FUTEX_WAIT_PRIVATE, key, NULL, NULL, 0);
+#else
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (epoch_.load() == key) cond_.wait(lock);
+#endif
+        waiters_.fetch_sub(1);
+    }
+
+    void NotifyAll()
+    {
+        epoch_.fetch_add(1);
+        if (waiters_.load() == 0) return;
+#if defined(__linux__)
+        syscall(SYS_futex, reinterpret_cast<int*>(&epoch_), FUTEX_WAKE_PRIVATE, INT_MAX, NULL, NULL, 0);
+#else
+        // A waiter that saw the old epoch holds the mutex until it sleeps.
+        std::lock_guard<std::mutex> lock(mutex_);
+        cond_.notify_all();
+#endif
+    }
+
+   private:
+    std::atomic<int> epoch_;
+    std::atomic<int> waiters_;
+#if !defined(__linux__)
+    std::mutex mutex_;
+    std::condition_variable cond_;
+#endif
+};
+
+#endif  // _DB_UTILS_EVENT_COUNT_H_
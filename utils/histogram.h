@@ -0,0 +1,102 @@
+#ifndef _DB_UTILS_HISTOGRAM_H_
+#define _DB_UTILS_HISTOGRAM_H_
+
+#include <stdint.h>
+
+#include <cstring>
+
+/// @class Histogram
+///
+/// Fixed size, log-linear histogram of uint64 samples in the style of
+/// HdrHistogram: values below 2^kSubBits are exact, larger ones fall into
+/// one of 2^kSubBits buckets per power of two, so every percentile is within
+/// 1/2^kSubBits (~3%) of the real value. Recording is a few instructions and
+/// never allocates. Not thread safe; copy it to take a snapshot.
+class Histogram
+{
+   public:
+    static const int kSubBits    = 5;
+    static const int kSubBuckets = 1 << kSubBits;
+    static const int kBuckets    = kSubBuckets * (64 - kSubBits + 1);
+
+    Histogram() { Reset(); }
+
+    void Reset()
+    {
+        memset(counts_, 0, sizeof(counts_));
+        count_ = 0;
+        sum_   = 0;
+        min_   = UINT64_MAX;
+        max_   = 0;
+    }
+
+    void Record(uint64_t value)
+    {
+        ++counts_[Index(value)];
+        ++count_;
+        sum_ += value;
+        if (value < min_) min_ = value;
+        if (value > max_) max_ = value;
+    }
+
+    void Merge(const Histogram& other)
+    {
+        for (int i = 0; i < kBuckets; i++) counts_[i] += other.counts_[i];
+        count_ += other.count_;
+        sum_ += other.sum_;
+        if (other.min_ < min_) min_ = other.min_;
+        if (other.max_ > max_) max_ = other.max_;
+    }
+
+    uint64_t Count() const { return count_; }
+    uint64_t Sum() const { return sum_; }
+    uint64_t Min() const { return count_ == 0 ? 0 : min_; }
+    uint64_t Max() const { return max_; }
+    double Mean() const { return count_ == 0 ? 0 : static_cast<double>(sum_) / count_; }
+
+    // Smallest recorded value v (rounded up to the end of its bucket) such
+    // that 'percentile' percent of the samples are <= v. 0 if empty.
+    uint64_t Percentile(double percentile) const
+    {
+        if (count_ == 0) return 0;
+        uint64_t rank = static_cast<uint64_t>(percentile / 100.0 * count_ + 0.5);
+        if (rank < 1) rank = 1;
+        if (rank > count_) rank = count_;
+        uint64_t seen = 0;
+        for (int i = 0; i < kBuckets; i++)
+        {
+            seen += counts_[i];
+            if (seen >= rank)
+            {
+                uint64_t high = HighestEquivalent(i);
+                return high < max_ ? high : max_;
+            }
+        }
+        return max_;
+    }
+
+   private:
+    static int Index(uint64_t value)
+    {
+        if (value < static_cast<uint64_t>(kSubBuckets)) return static_cast<int>(value);
+        int exponent = 63 - __builtin_clzll(value);
+        int shift    = exponent - kSubBits;
+        return kSubBuckets * (shift + 1) + static_cast<int>((value >> shift) - kSubBuckets);
+    }
+
+    static uint64_t HighestEquivalent(int index)
+    {
+        if (index < kSubBuckets) return index;
+        int shift     = index / kSubBuckets - 1;
+        uint64_t base = static_cast<uint64_t>(kSubBuckets + index % kSubBuckets);
+        return ((base + 1) << shift) - 1;
+    }
+
+    uint64_t counts_[kBuckets];
+    uint64_t count_;
+    uint64_t sum_;
+    uint64_t min_;
+    uint64_t max_;
+};
+
+#endif  // _DB_UTILS_HISTOGRAM_H_
@@ -0,0 +1,136 @@
+#ifndef _DB_UTILS_PERF_COUNTERS_H_
+#define _DB_UTILS_PERF_COUNTERS_H_
+
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#endif
+
+enum PerfEvent
+{
+    PERF_CYCLES        = 0,
+    PERF_INSTRUCTIONS  = 1,
+    PERF_LLC_MISSES    = 2,
+    PERF_BRANCH_MISSES = 3,
+    NUM_PERF_EVENTS    = 4,
+};
+
+/// Counts of every PerfEvent, over some interval.
+struct PerfSample
+{
+    PerfSample() { memset(value_, 0, sizeof(value_)); }
+
+    PerfSample& operator+=(const PerfSample& other)
+    {
+        for (int i = 0; i < NUM_PERF_EVENTS; i++) value_[i] += other.value_[i];
+        return *this;
+    }
+
+    /// Counts between 'earlier' and this sample (counters only go up).
+    PerfSample operator-(const PerfSample& earlier) const
+    {
+        PerfSample delta;
+        for (int i = 0; i < NUM_PERF_EVENTS; i++)
+            delta.value_[i] = value_[i] > earlier.value_[i] ? value_[i] - earlier.value_[i] : 0;
+        return delta;
+    }
+
+    uint64_t value_[NUM_PERF_EVENTS];
+};
+
+/// @class PerfCounters
+///
+/// Hardware counters of the calling thread, in user space: cycles,
+/// instructions, last level cache misses and branch misses, opened with
+/// perf_event_open as one group so they all cover the same intervals. Events
+/// the CPU or the kernel won't count (e.g. in most VMs, or with
+/// perf_event_paranoid above 2) stay at 0 and are not Available().
+class PerfCounters
+{
+   public:
+    /// Opens the counters of the calling thread, which only it may Read().
+    PerfCounters() : leader_(-1), opened_(0)
+    {
+        for (int i = 0; i < NUM_PERF_EVENTS; i++)
+        {
+            fds_[i]   = -1;
+            index_[i] = -1;
+        }
+#if defined(__linux__)
+        static const uint64_t kConfigs[NUM_PERF_EVENTS] = {PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS,
+                                                           PERF_COUNT_HW_CACHE_MISSES, PERF_COUNT_HW_BRANCH_MISSES};
+        for (int i = 0; i < NUM_PERF_EVENTS; i++)
+        {
+            struct perf_event_attr attr;
+            memset(&attr, 0, sizeof(attr));
+            attr.size           = sizeof(attr);
+            attr.type           = PERF_TYPE_HARDWARE;
+            attr.config         = kConfigs[i];
+            attr.disabled       = leader_ < 0;
+            attr.exclude_kernel = 1;
+            attr.exclude_hv     = 1;
+            attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+            int fd = syscall(__NR_perf_event_open, &attr, 0, -1, leader_, 0);
+            if (fd < 0) continue;
+            if (leader_ < 0) leader_ = fd;
+            fds_[i]   = fd;
+            index_[i] = opened_++;
+        }
+        if (leader_ >= 0) ioctl(leader_, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+#endif
+    }
+
+    ~PerfCounters()
+    {
+        for (int i = 0; i < NUM_PERF_EVENTS; i++)
+            if (fds_[i] >= 0) close(fds_[i]);
+    }
+
+    bool Available(PerfEvent event) const { return index_[event] >= 0; }
+    bool AnyAvailable() const { return leader_ >= 0; }
+
+    /// Counts since the counters were opened, scaled up if the kernel had to
+    /// multiplex them with other users of the PMU.
+    PerfSample Read() const
+    {
+        PerfSample sample;
+        if (leader_ < 0) return sample;
+        // nr, time enabled, time running, then the values in opening order.
+        uint64_t buffer[3 + NUM_PERF_EVENTS];
+        if (read(leader_, buffer, sizeof(buffer)) < static_cast<ssize_t>((3 + opened_) * sizeof(uint64_t)))
+            return sample;
+        double scale = buffer[2] > 0 && buffer[2] < buffer[1] ? static_cast<double>(buffer[1]) / buffer[2] : 1;
+        for (int i = 0; i < NUM_PERF_EVENTS; i++)
+            if (index_[i] >= 0) sample.value_[i] = static_cast<uint64_t>(buffer[3 + index_[i]] * scale);
+        return sample;
+    }
+
+    /// Counters of the calling thread, opened on its first call.
+    static PerfCounters& ThreadLocal()
+    {
+        static thread_local PerfCounters counters;
+        return counters;
+    }
+
+    static const char* EventName(PerfEvent event)
+    {
+        static const char* kNames[NUM_PERF_EVENTS] = {"cycles", "instructions", "llc_misses", "branch_misses"};
+        return kNames[event];
+    }
+
+   private:
+    PerfCounters(const PerfCounters&);
+    PerfCounters& operator=(const PerfCounters&);
+
+    int leader_;                  // group leader, -1 if no event could be opened
+    int fds_[NUM_PERF_EVENTS];    // -1 for events that aren't counted
+    int index_[NUM_PERF_EVENTS];  // position of the event in a group read
+    int opened_;
+};
+
+#endif  // _DB_UTILS_PERF_COUNTERS_H_
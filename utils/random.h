@@ -0,0 +1,66 @@
+#ifndef _DB_UTILS_RANDOM_H_
+#define _DB_UTILS_RANDOM_H_
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#include <atomic>
+
+/// @class FastRandom
+///
+/// xoshiro256** generator: a few cycles per number, no locks, not for
+/// cryptography. Unlike rand(), which takes a global lock, every thread uses
+/// its own instance (see ThreadLocal()).
+class FastRandom
+{
+   public:
+    explicit FastRandom(uint64_t seed) { Seed(seed); }
+
+    void Seed(uint64_t seed)
+    {
+        // Expand the seed with splitmix64, which never yields an all zero state.
+        for (int i = 0; i < 4; i++)
+        {
+            seed += 0x9e3779b97f4a7c15ull;
+            uint64_t z = seed;
+            z          = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+            z          = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+            state_[i]  = z ^ (z >> 31);
+        }
+    }
+
+    uint64_t Next()
+    {
+        uint64_t result = Rotl(state_[1] * 5, 7) * 9;
+        uint64_t t      = state_[1] << 17;
+        state_[2] ^= state_[0];
+        state_[3] ^= state_[1];
+        state_[1] ^= state_[2];
+        state_[0] ^= state_[3];
+        state_[2] ^= t;
+        state_[3] = Rotl(state_[3], 45);
+        return result;
+    }
+
+    // Uniform in [0, n), by multiply and shift rather than a division.
+    uint64_t Uniform(uint64_t n) { return static_cast<uint64_t>((static_cast<unsigned __int128>(Next()) * n) >> 64); }
+
+    // Uniform in [0, 1).
+    double NextDouble() { return (Next() >> 11) * (1.0 / 9007199254740992.0); }
+
+    // Generator of the calling thread. Seeds mix one rand() (so srand()
+    // still matters) with a per thread counter.
+    static FastRandom& ThreadLocal()
+    {
+        static std::atomic<uint64_t> next_thread(0);
+        static thread_local FastRandom random((static_cast<uint64_t>(rand()) << 32) ^ next_thread.fetch_add(1));
+        return random;
+    }
+
+   private:
+    static uint64_t Rotl(uint64_t x, int k) { return (x << k) | (x >> (64 - k)); }
+
+    uint64_t state_[4];
+};
+
+#endif  // _DB_UTILS_RANDOM_H_